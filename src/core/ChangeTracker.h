@@ -0,0 +1,154 @@
+#ifndef ENGINE_CORE_CHANGE_TRACKER_H
+#define ENGINE_CORE_CHANGE_TRACKER_H
+
+#include "core/PCH.h"
+#include "core/Components.h"
+#include "physics/Components.h"
+
+// The amount of frames the change logs are kept, querying changes from further back is not possible
+#ifndef ENGINE_CHANGE_TRACKING_HISTORY
+    #define ENGINE_CHANGE_TRACKING_HISTORY 16
+#endif
+
+namespace Engine {
+
+    typedef uint64_t FrameID;
+
+namespace Component {
+
+    // Is stored next to a tracked component, contains the last frame the component was changed
+    template<class T>
+    struct ChangedAt {
+        FrameID _frame;
+    };
+
+}
+
+    /**
+     * @brief Keeps track of the frame every tracked component last changed
+     * The tracked components are Position, Texture, Text and Collider.
+     * Every change is written to a log, so the systems that need the changes (renderer, physics) only
+     * have to visit the changed entities instead of all entities.
+     *
+     * Frames start at 1, so asking for the changes since frame 0 returns everything in the log.
+     * A system that synchronized at the end of frame X should ask for the changes since X.
+     */
+    class ChangeTracker {
+    public:
+
+        template<class T>
+        static constexpr bool IsTracked() {
+            return std::is_same_v<T, Component::Position> || std::is_same_v<T, Component::Texture>
+                || std::is_same_v<T, Component::Text> || std::is_same_v<T, Component::Collider>;
+        }
+
+        inline FrameID GetFrame() const { return _frame; }
+        // Should be called after every frame, drops the log entries that are too old
+        void NextFrame() {
+            _frame++;
+            if(_frame <= ENGINE_CHANGE_TRACKING_HISTORY) return;
+            for(ChangeLog& log : _logs) {
+                while(log._changed.size() && log._changed.front()._frame <= _frame-ENGINE_CHANGE_TRACKING_HISTORY) log._changed.pop_front();
+                while(log._removed.size() && log._removed.front()._frame <= _frame-ENGINE_CHANGE_TRACKING_HISTORY) log._removed.pop_front();
+            }
+        }
+        // If false, the log no longer contains all changes since that frame and you need to visit every entity
+        inline bool CanQuerySince(const FrameID since) const {
+            return since + ENGINE_CHANGE_TRACKING_HISTORY >= _frame;
+        }
+
+        template<class T>
+        void MarkChanged(entt::registry& registry, const entt::entity entity) {
+            static_assert(IsTracked<T>(), "[ChangeTracker] Cannot mark an untracked component as changed");
+            Component::ChangedAt<T>* changed = registry.try_get<Component::ChangedAt<T>>(entity);
+            if(changed) {
+                if(changed->_frame == _frame) return;// Already in the log for this frame
+                changed->_frame = _frame;
+            } else {
+                registry.emplace<Component::ChangedAt<T>>(entity, _frame);
+            }
+            GetLog<T>()._changed.push_back(Entry{_frame, entity});
+        }
+        template<class T>
+        void MarkRemoved(entt::registry& registry, const entt::entity entity) {
+            static_assert(IsTracked<T>(), "[ChangeTracker] Cannot mark an untracked component as removed");
+            registry.remove<Component::ChangedAt<T>>(entity);
+            GetLog<T>()._removed.push_back(Entry{_frame, entity});
+        }
+
+        // Marks every tracked component as removed, call before clearing the registry
+        void MarkAllRemoved(entt::registry& registry) {
+            MarkAllRemoved<Component::Position>(registry);
+            MarkAllRemoved<Component::Texture>(registry);
+            MarkAllRemoved<Component::Text>(registry);
+            MarkAllRemoved<Component::Collider>(registry);
+        }
+
+        template<class T>
+        bool HasChangedSince(const entt::registry& registry, const entt::entity entity, const FrameID since) const {
+            const Component::ChangedAt<T>* changed = registry.try_get<Component::ChangedAt<T>>(entity);
+            return changed && changed->_frame > since;
+        }
+        // Calls func(entity) once for every entity of which T changed after the frame since
+        template<class T, class Func>
+        void ForEachChangedSince(const entt::registry& registry, const FrameID since, Func&& func) const {
+            ASSERT(CanQuerySince(since), "[ChangeTracker] Cannot query changes that are older than ENGINE_CHANGE_TRACKING_HISTORY frames")
+            const std::deque<Entry>& changed = GetLog<T>()._changed;
+            // The newest entries are at the back
+            for(auto it = std::upper_bound(changed.begin(), changed.end(), since, [](const FrameID frame, const Entry& entry) { return frame < entry._frame; }); it != changed.end(); it++) {
+                const Component::ChangedAt<T>* current = registry.try_get<Component::ChangedAt<T>>(it->_entity);
+                // Only visit the newest entry of an entity
+                if(current && current->_frame == it->_frame) func(it->_entity);
+            }
+        }
+        // Calls func(entity) for every entity that lost T (or got deleted) after the frame since
+        template<class T, class Func>
+        void ForEachRemovedSince(const FrameID since, Func&& func) const {
+            ASSERT(CanQuerySince(since), "[ChangeTracker] Cannot query changes that are older than ENGINE_CHANGE_TRACKING_HISTORY frames")
+            const std::deque<Entry>& removed = GetLog<T>()._removed;
+            for(auto it = std::upper_bound(removed.begin(), removed.end(), since, [](const FrameID frame, const Entry& entry) { return frame < entry._frame; }); it != removed.end(); it++) {
+                func(it->_entity);
+            }
+        }
+
+    private:
+        template<class T>
+        void MarkAllRemoved(entt::registry& registry) {
+            std::deque<Entry>& removed = GetLog<T>()._removed;
+            for(const entt::entity entity : registry.view<Component::ChangedAt<T>>()) {
+                removed.push_back(Entry{_frame, entity});
+            }
+            registry.clear<Component::ChangedAt<T>>();
+        }
+
+        struct Entry {
+            FrameID _frame;
+            entt::entity _entity;
+        };
+        struct ChangeLog {
+            std::deque<Entry> _changed;
+            std::deque<Entry> _removed;
+        };
+        std::array<ChangeLog, 4> _logs;
+        FrameID _frame = 1;
+
+        template<class T>
+        inline ChangeLog& GetLog() {
+            return _logs[LogIndex<T>()];
+        }
+        template<class T>
+        inline const ChangeLog& GetLog() const {
+            return _logs[LogIndex<T>()];
+        }
+        template<class T>
+        static constexpr size_t LogIndex() {
+            if constexpr (std::is_same_v<T, Component::Position>) return 0;
+            else if constexpr (std::is_same_v<T, Component::Texture>) return 1;
+            else if constexpr (std::is_same_v<T, Component::Text>) return 2;
+            else return 3;
+        }
+    };
+
+}
+
+#endif
\ No newline at end of file
@@ -17,12 +17,6 @@ namespace Component {
         Position(Util::Vec2F pos) : _pos(pos) {}
         Position(Util::Vec2F pos, const float rotation) : _pos(pos), _rotation(rotation) {}
 
-        struct Precalculated {
-            Util::Vec2F _topLeft;
-            Util::Vec2F _bottomRight;
-            Util::Vec2F _deltaPosition;
-        };
-        Precalculated GetPrecalculated(const float w, const float h);
         struct Corners {
             Util::Vec2F _points[4];
         };
@@ -39,6 +33,7 @@ namespace Component {
 
     struct Texture {
         
+        Texture() {}// Used by the deserializer
         Texture(Scene* scene, const uint32_t assetID, const Util::Vec2F size);
 
         Util::AreaF _textureArea;
@@ -47,8 +42,30 @@ namespace Component {
     };
     typedef Texture QRCode;
 
+    // How the characters of a text are placed on lines
+    struct TextOptions {
+        enum Alignment : uint8_t { Left, Center, Right };
+
+        float _wrapWidth = 0;// Lines are broken at the spaces to stay within this width in pixels, 0 never wraps
+        uint8_t _alignment = Left;
+        float _lineHeight = 0;// The distance between the lines in pixels, 0 uses ENGINE_RENDERER_LINE_HEIGHT_FACTOR times the size
+
+        bool operator==(const TextOptions& other) const = default;
+    };
+
     struct Text {
-        Text(Scene* scene, uint32_t assetID, const uint32_t size, const std::u32string text);
+        Text() {}// Used by the deserializer
+        Text(Scene* scene, uint32_t assetID, const uint32_t size, const std::u32string text, const TextOptions options = TextOptions());
+        // The glyphs are rendered when they are first used (see Window::AddGlyphCache), a placeholder is drawn until they are ready
+        // The scene lays the text out again when the glyph cache changed
+        Text(Scene* scene, const uint32_t glyphCache, const std::u32string text, const TextOptions options = TextOptions());
+
+        // Only the lines from the line before the first changed character on are laid out again
+        // Use Scene::SetText for a component in the scene, it keeps the amount of characters of the scene up to date
+        void SetText(Scene* scene, const std::u32string text);
+        // Lays out the text again, previousText is the text the render info was made for
+        // Every character of the text of a glyph cache gets a render info (empty for spaces), so the amount only changes with the text
+        void Layout(Scene* scene, const std::u32string& previousText);
         
         struct CharRenderInfo {
             Util::AreaF _position;
@@ -57,6 +74,11 @@ namespace Component {
             float _pxRange;
         };
         std::vector<CharRenderInfo> _renderInfo;
+        uint32_t _asset = UINT32_MAX;// UINT32_MAX when the text uses a glyph cache
+        uint32_t _size = 0;
+        uint32_t _glyphCache = UINT32_MAX;// UINT32_MAX when the text uses a loaded text asset
+        std::u32string _text;
+        TextOptions _options;
     };
 
 }
@@ -5,6 +5,19 @@ namespace Engine {
 
 	int EngineMain(int c, char* v[]) {
 		std::unique_ptr<Engine::Game> game = Engine::CreateApplication();
+		for(int i = 1; i < c; i++) {
+			if(std::string(v[i]) == "--benchmark-instances") {
+				game->BenchmarkInstances();
+				return 0;
+			}
+			if(i+1 == c) break;
+			if(std::string(v[i]) == "--benchmark-hinting") {
+				game->BenchmarkHinting(v[++i]);
+				return 0;
+			}
+			if(std::string(v[i]) == "--record-input") game->RecordInput(v[++i]);
+			else if(std::string(v[i]) == "--replay-input") game->ReplayInput(v[++i]);
+		}
 		return game->Run();
 	}
 }
@@ -1,11 +1,12 @@
 #include "Game.h"
 
 #include "util/DebugGraphics.h"
+#include "util/Profiler.h"
 #include "util/serialization/JSON.h"
 
 namespace Engine {
 
-    Game::Game() { }
+    Game::Game() : _window(&_frameArena, &_threadPool) { }
 
     void Game::Start() {
         Util::FileManager::Init(GetResourceDirectories(), GetCacheDirectory());
@@ -13,8 +14,13 @@ namespace Engine {
 
         _webhandler = Network::WebHandler::Create();
         _webhandler->Route("/", this);// Router all requests to this
-        _webhandler->Start();
-        _window.Init(2);
+        // A replay feeds the recorded requests directly to the webhandler
+        if(_replayFile.empty()) _webhandler->Start();
+        if(_recorder) _webhandler->SetInputRecorder(_recorder.get());
+        // The game, the scene and the scene that is loading
+        // A replay does not draw, so it runs without a window and the assets are only loaded for their render info
+        if(_replayFile.empty()) _window.Init(3, GetFrameLatency());
+        else _window.InitHeadless(3);
 
         _window.StartAssetLoading(ENGINE_GAME_TEXTUREMAP_ID);
         LoadAssets();
@@ -25,25 +31,9 @@ namespace Engine {
         try {
             Start();
 
-            _previousFrame = std::chrono::steady_clock::now();
-            while(!_window.ShouldClose()) {
-                ASSERT(_scene!=nullptr, "[Game] No scene bound, there should always be a scene bound")
-                _webhandler->Update();
-                _window.Update();
-
-                auto now = std::chrono::steady_clock::now();
-                float dt = (float)(((double)std::chrono::nanoseconds(now - _previousFrame).count()) / 1000000000);
-                // TODO: Use the framerate of the device to skip frames
-                if(dt > (1/30.f)) {
-                    dt = 1/30.f;
-                    INFO("[Game] Skipping frames, previous took too long")
-                }
-                _previousFrame = now;
-                
-                _scene->OnFrame(dt);
-                _scene->_physics.Update(_scene->_entt, dt);
-                _window.Draw(_scene->_entt, _scene->_textureComponents, _scene->_textComponents);
-            }
+            ENGINE_PROFILE_THREAD("Main")
+            if(_replayFile.size()) Replay();
+            else Loop();
         } catch(std::runtime_error exc) {
             OnError("[Game] Caught std::runtime_error '" + std::string(exc.what()) + "'");
         } catch(std::exception exc) {
@@ -56,10 +46,90 @@ namespace Engine {
         return 0;
     }
 
+    void Game::Loop() {
+        _previousFrame = std::chrono::steady_clock::now();
+        while(!_window.ShouldClose()) {
+            UpdateSceneLoading();
+            ASSERT(_scene!=nullptr, "[Game] No scene bound, there should always be a scene bound")
+            _webhandler->Update();
+            _window.Update();
+
+            auto now = std::chrono::steady_clock::now();
+            float dt = (float)(((double)std::chrono::nanoseconds(now - _previousFrame).count()) / 1000000000);
+            // TODO: Use the framerate of the device to skip frames
+            if(dt > (1/30.f)) {
+                dt = 1/30.f;
+                INFO("[Game] Skipping frames, previous took too long")
+            }
+            _previousFrame = now;
+            // The requests handled by the webhandler update belong to this frame
+            if(_recorder) _recorder->EndFrame(dt);
+            
+            {
+                ENGINE_PROFILE_SCOPE("Scene::OnFrame")
+                _scene->OnFrame(dt);
+            }
+            _scene->_physics.Update(_scene->_entt, dt, &_frameArena, &_scene->_changes);
+            _window.UpdateGlyphCaches();
+            _scene->LayoutGlyphCacheText(false);
+            _window.Draw(_scene->_entt, _scene->_textureComponents, _scene->_textComponents, &_scene->_changes);
+            _scene->_changes.NextFrame();
+            ENGINE_PROFILE_FRAME()
+            // Reset after the frame instead of before, so allocations made while starting survive the first frame
+            ResetFrameMemory();
+        }
+    }
+    void Game::Replay() {
+        const Network::InputRecording recording = Network::InputRecorder::Load(Util::File(_replayFile));
+        LOG("[Game] Replaying " + std::to_string(recording._frames.size()) + " frames from '" + _replayFile + "'")
+
+        std::vector<float> frameTimes;
+        frameTimes.reserve(recording._frames.size());
+        for(const Network::RecordedFrame& frame : recording._frames) {
+            UpdateSceneLoading();
+            ASSERT(_scene!=nullptr, "[Game] No scene bound, there should always be a scene bound")
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for(const Network::RecordedEvent& event : frame._events) {
+                _webhandler->Replay(event);
+            }
+            {
+                ENGINE_PROFILE_SCOPE("Scene::OnFrame")
+                _scene->OnFrame(frame._dt);
+            }
+            _scene->_physics.Update(_scene->_entt, frame._dt, &_frameArena, &_scene->_changes);
+            _scene->_changes.NextFrame();
+            ENGINE_PROFILE_FRAME()
+            ResetFrameMemory();
+            frameTimes.push_back((float)((double)std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count() / 1000000));
+        }
+        LogFrameStatistics(frameTimes);
+    }
+    void Game::ResetFrameMemory() {
+        // The debug lines live in the arena, they are not drawn (and not cleared by Draw) when the window is minimized
+        _window.DiscardDebugLines();
+        _frameArena.Reset();
+    }
+    void Game::LogFrameStatistics(std::vector<float>& frameTimes) {
+        if(frameTimes.empty()) {
+            LOG("[Game] Replayed 0 frames")
+            return;
+        }
+        const double total = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0);
+        std::sort(frameTimes.begin(), frameTimes.end());
+        auto percentile = [&](const float p) { return frameTimes[std::min(frameTimes.size()-1, (size_t)(p*frameTimes.size()))]; };
+        LOG("[Game] Replayed " + std::to_string(frameTimes.size()) + " frames in " + std::to_string(total) + "ms (frame times in ms):"
+            + "\n\tmin " + std::to_string(frameTimes.front())
+            + "\n\tmean " + std::to_string(total/frameTimes.size())
+            + "\n\tmedian " + std::to_string(percentile(0.5f))
+            + "\n\tp95 " + std::to_string(percentile(0.95f))
+            + "\n\tp99 " + std::to_string(percentile(0.99f))
+            + "\n\tmax " + std::to_string(frameTimes.back()))
+    }
+
     void Game::OnError(const std::string& message) {
 #ifndef __DEBUG__
         try {
-            INFO(_window.GetVulkanDeviceLimits())
+            if(!_window.IsHeadless()) INFO(_window.GetVulkanDeviceLimits())
         } catch(std::exception exc) {}
 #endif
         WARNING(message)
@@ -68,18 +138,88 @@ namespace Engine {
         std::cin.get();
     }
     void Game::Cleanup() {
+        LOG("[Game] Frame arena high-water mark: " + std::to_string(_frameArena.GetHighWaterMark()) + " of " + std::to_string(_frameArena.GetCapacity()) + " bytes")
+        if(_loadingScene) {
+            // Once uploading the future was already consumed, the texture map then finishes the pending upload in its cleanup
+            if(_loadingScene->_prepared.valid()) _loadingScene->_prepared.wait();
+            _window.CleanupAssets(_loadingScene->_scene->_textureMapID);
+            _loadingScene = nullptr;
+        }
         StopScene();
+        if(_recorder) {
+            _webhandler->SetInputRecorder(nullptr);
+            _recorder->Save(Util::File(_recordingFile));
+        }
         _webhandler->Stop();
         _webhandler = nullptr;
         _window.Cleanup();
     }
 
+    void Game::RecordInput(const std::string file) {
+        ASSERT(_replayFile.empty(), "[Game] Cannot record the input while replaying")
+        _recordingFile = file;
+        _recorder = std::make_unique<Network::InputRecorder>();
+    }
+    void Game::ReplayInput(const std::string file) {
+        ASSERT(!_recorder, "[Game] Cannot replay while recording the input")
+        _replayFile = file;
+    }
+    void Game::BenchmarkInstances() {
+        Renderer::InstanceWriter::Benchmark(_threadPool);
+    }
+    void Game::BenchmarkHinting(const std::string file) {
+        const Util::File font = Util::FileManager::Get(file);
+        ASSERT(font.Exists() && font.IsRegular(), "[Game] Cannot benchmark the hinting of a font file that does not exist '" + font.String() + "'")
+        Renderer::TTFFontParser::Benchmark(font, _threadPool);
+    }
+
     void Game::StopScene() {
         if (!_scene) return;// There is no scene bound
         _scene->OnSceneStop();
         Route(nullptr);
+        _window.CleanupAssets(_scene->_textureMapID);
+        _window.ResetInstanceCaches();
         _scene = nullptr;
-        _window.CleanupAssets(ENGINE_SCENE_TEXTUREMAP_ID);
+    }
+
+    void Game::StartSceneLoading(std::shared_ptr<Scene> scene) {
+        // Load into the texture map the current scene is not using
+        scene->_textureMapID = _scene && _scene->_textureMapID == ENGINE_SCENE_TEXTUREMAP_ID ? ENGINE_SCENE_BACK_TEXTUREMAP_ID : ENGINE_SCENE_TEXTUREMAP_ID;
+        _window.StartAssetLoading(scene->_textureMapID);
+        scene->LoadAssets();// Only registers the asset loaders, the actual loading happens in the background
+
+        _loadingScene = std::make_unique<SceneLoading>();
+        _loadingScene->_scene = scene;
+        const size_t textureMapID = scene->_textureMapID;
+        _loadingScene->_prepared = std::async(std::launch::async, [this, textureMapID]() {
+            ENGINE_PROFILE_THREAD("Scene loading")
+            _window.PrepareAssets(textureMapID);
+        });
+    }
+    void Game::UpdateSceneLoading() {
+        if(!_loadingScene) return;
+        // Without a current scene there is nothing to keep running, so finish the loading right away
+        const bool block = _scene == nullptr;
+        if(!_loadingScene->_uploading) {
+            if(!block && _loadingScene->_prepared.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+            _loadingScene->_prepared.get();// Rethrows the exception if the preparing failed
+            _loadingScene->_uploading = true;
+        }
+        while(!_window.UploadAssets(_loadingScene->_scene->_textureMapID)) {
+            if(!block) return;
+        }
+
+        std::shared_ptr<Scene> scene = std::move(_loadingScene->_scene);
+        _loadingScene = nullptr;
+        StopScene();
+        _scene = scene;
+        _scene->OnSceneStart();
+        Route(_scene);
+        OnSceneStart();
+    }
+    float Game::GetSceneLoadingProgress() const {
+        if(!_loadingScene) return 1;
+        return _window.GetAssetLoadingProgress(_loadingScene->_scene->_textureMapID);
     }
 
     
@@ -103,6 +243,24 @@ namespace Engine {
             ENGINE_RENDERER_ASSETTYPE_TEXT
         );
     }
+    Renderer::AssetID Game::LoadDynamicTextureFile(const std::string file) {
+        return _window.AddDynamicAsset(
+            std::static_pointer_cast<Renderer::AssetLoader>(std::make_shared<Renderer::ImageLoader>(file)), 
+            ENGINE_RENDERER_ASSETTYPE_TEXTURE
+        );
+    }
+    Renderer::AssetID Game::LoadDynamicTextFile(const std::string file, const Renderer::Characters characters, const std::initializer_list<uint32_t> sizes) {
+        return _window.AddDynamicAsset(
+            std::static_pointer_cast<Renderer::AssetLoader>(std::make_shared<Renderer::TextLoader>(file, characters, sizes)), 
+            ENGINE_RENDERER_ASSETTYPE_TEXT
+        );
+    }
+    void Game::UnloadDynamicAsset(const AssetID asset) {
+        _window.RemoveDynamicAsset(asset);
+    }
+    uint32_t Game::LoadGlyphCache(const std::string file, const uint32_t size, const size_t memoryBudget) {
+        return _window.AddGlyphCache(file, size, memoryBudget);
+    }
 
     void Game::SetCameraPosition(const Util::Vec2F pos) {
         _window.SetCameraPosition(pos);
@@ -11,9 +11,13 @@
 #include "network/WebHandler.h"
 
 #include "util/FileManager.h"
+#include "util/FrameArena.h"
+#include "util/ThreadPool.h"
 
 #define ENGINE_GAME_TEXTUREMAP_ID 0
 #define ENGINE_SCENE_TEXTUREMAP_ID 1
+// The scene texture map a scene loads into while the previous scene is still using ENGINE_SCENE_TEXTUREMAP_ID (they swap roles)
+#define ENGINE_SCENE_BACK_TEXTUREMAP_ID 2
 
 namespace Engine {
     typedef Renderer::AssetID AssetID;
@@ -34,6 +38,11 @@ namespace Engine {
          * Will by default choose to create a /cache/ directory in the first resource directory (Please override this choise).
         */
         virtual std::string GetCacheDirectory() const { return *GetResourceDirectories().begin() + "./cache/"; }
+        /**
+         * Should return the amount of frames the CPU may work ahead of the GPU.
+         * 1 gives the lowest input latency, higher values keep the GPU busy when frame times vary.
+         */
+        virtual uint32_t GetFrameLatency() const { return ENGINE_RENDERER_FRAMES_IN_FLIGHT; }
         virtual void OnStart() {}
         virtual void OnSceneStart() {}
         virtual void LoadAssets() {}
@@ -42,16 +51,32 @@ namespace Engine {
 
         template<class tScene>
         void StartScene() {
+            ASSERT(!_loadingScene, "[Game] Cannot start a scene while another scene is loading")
             StopScene();
             // Start a new scene by first creating one
             _scene = std::static_pointer_cast<Scene>(std::make_shared<tScene>(this, &_window));
-            _window.StartAssetLoading(ENGINE_SCENE_TEXTUREMAP_ID);
+            _scene->_textureMapID = ENGINE_SCENE_TEXTUREMAP_ID;
+            _window.StartAssetLoading(_scene->_textureMapID);
             _scene->LoadAssets();
-            _window.EndAssetLoading(ENGINE_SCENE_TEXTUREMAP_ID);
+            _window.EndAssetLoading(_scene->_textureMapID);
             _scene->OnSceneStart();
             Route(_scene);
             OnSceneStart();
         }
+        /**
+         * Loads the scene in the background while the current scene keeps running.
+         * LoadAssets is called immediately, the assets are decoded and rendered on a worker thread
+         * and uploaded one texture per frame. When everything is loaded the current scene is stopped and the new scene started
+         * between two frames. Use GetSceneLoadingProgress to show a loading bar.
+         */
+        template<class tScene>
+        void StartSceneAsync() {
+            ASSERT(!_loadingScene, "[Game] Cannot start a scene while another scene is loading")
+            StartSceneLoading(std::static_pointer_cast<Scene>(std::make_shared<tScene>(this, &_window)));
+        }
+        inline bool IsLoadingScene() const { return _loadingScene != nullptr; }
+        // Between 0 and 1, returns 1 when no scene is loading
+        float GetSceneLoadingProgress() const;
         void StopScene();
 
         /// @name Asset loading
@@ -70,19 +95,97 @@ namespace Engine {
         AssetID LoadTextFile(const std::string file, const Renderer::Characters characters, const std::initializer_list<uint32_t> sizes);
         ///@}
 
+        /// @name Dynamic assets
+        ///@{
+        /**
+         * Loads an asset while the game is running, outside of LoadAssets.
+         * The asset is placed in a shared texture map that grows when needed, it can be used immediately.
+         * The asset stays loaded until UnloadDynamicAsset is called, also when the scene changes.
+         */
+        AssetID LoadDynamicTextureFile(const std::string file);
+        /// @see LoadDynamicTextureFile
+        AssetID LoadDynamicTextFile(const std::string file, const Renderer::Characters characters, const std::initializer_list<uint32_t> sizes);
+        /// @warning Nothing may use the asset anymore, its space is reused by the next dynamic assets
+        void UnloadDynamicAsset(const AssetID asset);
+        /**
+         * A font size of which the glyphs are rendered on a worker thread the first time a text uses them, for text with any unicode character.
+         * Create the text with Component::Text(scene, glyphCache, text), a placeholder box is drawn until its glyphs are ready.
+         * The glyphs that are not used anymore are removed when the glyphs need more than memoryBudget bytes of texture memory.
+         */
+        uint32_t LoadGlyphCache(const std::string file, const uint32_t size, const size_t memoryBudget);
+        ///@}
+
+        /// @name Input recording
+        ///@{
+        /**
+         * Records the dt and all the network input of every frame, the recording is written to the file when the game stops.
+         * Start the game with '--record-input <file>' to call this.
+         * @warning Should be called before Run
+         */
+        void RecordInput(const std::string file);
+        /**
+         * Replays a recording made with RecordInput instead of running normally.
+         * The frames are run back to back with the recorded dt, without networking and without drawing.
+         * No window is opened and nothing is uploaded to the GPU, the assets are only loaded for their render info.
+         * Logs the frame time statistics when done. Start the game with '--replay-input <file>' to call this.
+         * @warning Should be called before Run
+         */
+        void ReplayInput(const std::string file);
+        /**
+         * Logs how long writing the instance data of 10k up to 1M sprites takes on one thread and on the thread pool.
+         * Does not open a window. Start the game with '--benchmark-instances' to call this.
+         */
+        void BenchmarkInstances();
+        /**
+         * Logs how long hinting every glyph of the font takes at 8 up to 32 pixels, on one thread and on the thread pool.
+         * Warns when the thread pool gives different outlines than one thread.
+         * Does not open a window. Start the game with '--benchmark-hinting <font file>' to call this.
+         */
+        void BenchmarkHinting(const std::string file);
+        ///@}
+
         void SetCameraPosition(const Util::Vec2F pos);
         void DebugLine(const Util::Vec2F start, const Util::Vec2F end, const Util::Vec3F color);
 
+        /**
+         * @brief Memory for temporaries that only have to live until the end of the current frame
+         * Is reset after every frame, see Util::FrameArena
+         */
+        Util::FrameArena& GetFrameArena() { return _frameArena; }
+        // Worker threads to split large loops over, see Util::ThreadPool
+        Util::ThreadPool& GetThreadPool() { return _threadPool; }
+
     private:
         void Start();
+        void Loop();
+        void Replay();
+        void LogFrameStatistics(std::vector<float>& frameTimes);
+        // The only place the frame arena is reset, everything pointing into it is dropped first
+        void ResetFrameMemory();
+        void StartSceneLoading(std::shared_ptr<Scene> scene);
+        // Swaps in the loading scene when it is done, called between frames
+        void UpdateSceneLoading();
         void Cleanup();
         void OnError(const std::string& message);
 
         std::shared_ptr<Scene> _scene;
+        struct SceneLoading {
+            std::shared_ptr<Scene> _scene;
+            std::future<void> _prepared;
+            bool _uploading = false;
+        };
+        std::unique_ptr<SceneLoading> _loadingScene;
+        // Must be declared before the window, the window uses them
+        Util::FrameArena _frameArena;
+        Util::ThreadPool _threadPool;
         Renderer::Window _window;
         std::shared_ptr<Network::WebHandler> _webhandler;
 
         std::chrono::steady_clock::time_point _previousFrame;
+
+        std::unique_ptr<Network::InputRecorder> _recorder;
+        std::string _recordingFile;
+        std::string _replayFile;
     };
 
 }
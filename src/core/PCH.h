@@ -22,9 +22,12 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <flat_set>
 #include <flat_map>
 #include <queue>
+#include <deque>
+#include <array>
 #include <initializer_list>
 #include <chrono>
 #include <filesystem>
@@ -34,4 +37,12 @@
 #include <cctype>
 #include <bit>
 #include <charconv>
-#include <typeindex>
\ No newline at end of file
+#include <typeindex>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <iomanip>
+#include <memory_resource>
+#include <numeric>
+#include <algorithm>
+#include <future>
\ No newline at end of file
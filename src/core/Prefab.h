@@ -0,0 +1,41 @@
+#ifndef ENGINE_CORE_PREFAB_H
+#define ENGINE_CORE_PREFAB_H
+
+#include "core/PCH.h"
+#include "core/Components.h"
+#include "physics/Components.h"
+
+namespace Engine {
+
+    /**
+     * @brief A set of components that can be instantiated many times at once with Scene::Instantiate
+     * ```
+     * Prefab bullet(Component::Position(), Component::Texture(this, bulletTexture, Util::Vec2F(4)), Component::Velocity());
+     * Instantiate(bullet, 10000, [](const size_t i, Component::Position& pos, Component::Texture& tex, Component::Velocity& vel) {
+     *      pos._pos = Util::Vec2F(i*5.f, 0);
+     * });
+     * ```
+     * 
+     * @tparam Ts The component types, every type may only appear once
+     */
+    template<class ... Ts>
+    class Prefab {
+    public:
+        static_assert(sizeof...(Ts) > 0, "[Prefab] A prefab needs at least one component");
+        static_assert((!std::is_same_v<Ts, Component::ImageBasedCollider> && ...), "[Prefab] Image based colliders cannot be instantiated in bulk");
+
+        Prefab(const Ts&... components) : _components(components...) {}
+
+        template<class T>
+        inline T& Get() { return std::get<T>(_components); }
+        template<class T>
+        inline const T& Get() const { return std::get<T>(_components); }
+        inline const std::tuple<Ts...>& GetComponents() const { return _components; }
+
+    private:
+        std::tuple<Ts...> _components;
+    };
+
+}
+
+#endif
\ No newline at end of file
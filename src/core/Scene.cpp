@@ -1,6 +1,8 @@
 #include "core/Scene.h"
 #include "core/Game.h"
 
+#include "util/serialization/Binary.h"
+
 namespace Engine{
 
     Scene::Scene(Game* game, Renderer::Window* window) : _game(game), _window(window), _physics(GetSceneBounds()) {}
@@ -9,11 +11,11 @@ namespace Engine{
     }
 
     void Scene::SetAssetCacheName(const std::string name) {
-        _window->SetAssetLoadingCacheName(ENGINE_SCENE_TEXTUREMAP_ID, name);
+        _window->SetAssetLoadingCacheName(_textureMapID, name);
     }
     Renderer::AssetID Scene::LoadTextureFile(const std::string file) {
         return _window->AddAsset(
-            ENGINE_SCENE_TEXTUREMAP_ID, 
+            _textureMapID, 
             std::static_pointer_cast<Renderer::AssetLoader>(std::make_shared<Renderer::ImageLoader>(file)), 
             ENGINE_RENDERER_ASSETTYPE_TEXTURE
         );
@@ -23,7 +25,7 @@ namespace Engine{
     }
     Renderer::AssetID Scene::LoadTextFile(const std::string file, const Renderer::Characters characters, const std::initializer_list<uint32_t> sizes) {
         return _window->AddAsset(
-            ENGINE_SCENE_TEXTUREMAP_ID, 
+            _textureMapID, 
             std::static_pointer_cast<Renderer::AssetLoader>(std::make_shared<Renderer::TextLoader>(file, characters, sizes)), 
             ENGINE_RENDERER_ASSETTYPE_TEXT
         );
@@ -37,6 +39,114 @@ namespace Engine{
         _window->AddDebugLine(start, end, color);
     }
 
+    bool Scene::IsInSnapshot(const entt::id_type type) const {
+        static const std::array<entt::id_type, 11> written = {
+            entt::type_id<entt::entity>().hash(),
+            entt::type_id<Component::Position>().hash(),
+            entt::type_id<Component::Velocity>().hash(),
+            entt::type_id<Component::Texture>().hash(),
+            entt::type_id<Component::Text>().hash(),
+            // Restored by the physics snapshot
+            entt::type_id<Component::ColliderUUID>().hash(),
+            entt::type_id<Component::ImageBasedColliderID>().hash(),
+            // Restored by marking the loaded components as changed
+            entt::type_id<Component::ChangedAt<Component::Position>>().hash(),
+            entt::type_id<Component::ChangedAt<Component::Texture>>().hash(),
+            entt::type_id<Component::ChangedAt<Component::Text>>().hash(),
+            entt::type_id<Component::ChangedAt<Component::Collider>>().hash()
+        };
+        return std::find(written.begin(), written.end(), type) != written.end() || _snapshotComponents.contains(type);
+    }
+    void Scene::SaveSnapshot(const Util::File file) {
+        for(auto [type, storage] : _entt.storage()) {
+            if(storage.empty() || IsInSnapshot(type)) continue;
+            THROW("[Scene] Cannot save a snapshot, entities have a component that would be lost ('" + std::string(storage.type().name()) + "'), add it with AddSnapshotComponent")
+        }
+        SceneSnapshot snapshot;
+        std::unordered_map<entt::entity, uint32_t> entityIndices;
+        SavePool(snapshot._positions, entityIndices);
+        SavePool(snapshot._velocities, entityIndices);
+        SavePool(snapshot._textures, entityIndices);
+        SavePool(snapshot._texts, entityIndices);
+        _physics.SaveSnapshot(_entt, entityIndices, snapshot._physics);
+        for(const auto& [type, component] : _snapshotComponents) {
+            SerializedPoolSnapshot& pool = snapshot._pools.emplace_back();
+            pool._name = component._name;
+            component._save(entityIndices, pool._data);
+        }
+        snapshot._amountEntities = (uint32_t)entityIndices.size();
+
+        std::vector<uint8_t> data;
+        Util::BinarySerializer serializer;
+        serializer.Serialize(snapshot, data, ENGINE_SCENE_SNAPSHOT_SERIALIZATION_FLAGS);
+        file.Write(data);
+    }
+    void Scene::LoadSnapshot(const Util::File file) {
+        ASSERT(file.Exists(), "[Scene] Cannot load a snapshot from a file that does not exist ('" + file.String() + "')")
+        std::vector<uint8_t> data;
+        file.Read(data);
+        SceneSnapshot snapshot;
+        Util::BinaryDeserializer deserializer;
+        deserializer.Deserialize(snapshot, data);
+        // Checked before the scene is cleared
+        std::vector<const SnapshotComponent*> poolComponents;
+        for(const SerializedPoolSnapshot& pool : snapshot._pools) {
+            auto it = std::find_if(_snapshotComponents.begin(), _snapshotComponents.end(), [&](const auto& component) { return component.second._name == pool._name; });
+            if(it == _snapshotComponents.end()) THROW("[Scene] Snapshot contains a component that is not added with AddSnapshotComponent ('" + pool._name + "')")
+            poolComponents.push_back(&it->second);
+        }
+
+        // Start from an empty scene
+        _changes.MarkAllRemoved(_entt);
+        _entt.clear();
+        _physics.Clear();
+
+        std::vector<entt::entity> entities(snapshot._amountEntities);
+        _entt.create(entities.begin(), entities.end());
+        LoadPool(snapshot._positions, entities);
+        LoadPool(snapshot._velocities, entities);
+        LoadPool(snapshot._textures, entities);
+        LoadPool(snapshot._texts, entities);
+        for(size_t i = 0; i < snapshot._pools.size(); i++) {
+            poolComponents[i]->_load(snapshot._pools[i]._data, entities);
+        }
+        _physics.LoadSnapshot(_entt, snapshot._physics, entities);
+        for(const Physics::MovingBodySnapshot& body : snapshot._physics._movingBodies) {
+            MarkChanged<Component::Collider>(entities[body._entity]);
+        }
+        for(const Physics::StaticBodySnapshot& body : snapshot._physics._staticBodies) {
+            if(body._entity != UINT32_MAX) MarkChanged<Component::Collider>(entities[body._entity]);
+        }
+
+        _textureComponents = (uint32_t)snapshot._textures._components.size();
+        _textComponents = 0;
+        for(const Component::Text& text : snapshot._texts._components) {
+            _textComponents += (uint32_t)text._renderInfo.size();
+        }
+        // The glyphs are not at the same place in the texture map as when the snapshot was saved
+        LayoutGlyphCacheText(true);
+    }
+    void Scene::SetText(const entt::entity entity, const std::u32string text) {
+        Component::Text& component = _entt.get<Component::Text>(entity);
+        _textComponents -= (uint32_t)component._renderInfo.size();
+        component.SetText(this, text);
+        _textComponents += (uint32_t)component._renderInfo.size();
+        MarkChanged<Component::Text>(entity);
+    }
+    void Scene::LayoutGlyphCacheText(const bool all) {
+        for(auto [entity, text] : _entt.view<Component::Text>().each()) {
+            if(text._glyphCache == UINT32_MAX) continue;
+            Renderer::GlyphCache& glyphCache = _window->GetGlyphCache(text._glyphCache);
+            if(!all && !glyphCache.HasChanged()) continue;
+            text.Layout(this, text._text);
+            MarkChanged<Component::Text>(entity);
+        }
+    }
+
+    std::pmr::memory_resource* Scene::GetFrameMemory() {
+        return &_game->GetFrameArena();
+    }
+
     #define BOUNDINGBOXWIDTH 10000
     Scene::BoundingboxID Scene::CreateBoundingBox(const Util::Vec2F pos, const float rotation, const Util::Vec2F dimensions, const Component::PhysicsMaterial mat) {
         BoundingboxID ret;
@@ -3,6 +3,9 @@
 
 #include "core/PCH.h"
 #include "core/Components.h"
+#include "core/ChangeTracker.h"
+#include "core/Snapshot.h"
+#include "core/Prefab.h"
 
 #include "renderer/Window.h"
 #include "renderer/ImageLoader.h"
@@ -13,6 +16,8 @@
 #include "physics/Engine.h"
 #include "physics/Components.h"
 
+#include "util/serialization/Binary.h"
+
 namespace Engine{
 
     typedef entt::entity Entity;
@@ -54,6 +59,7 @@ namespace Engine{
 
             if(IsTextureComponent<ComponentType>()) _textureComponents++;
 			_entt.emplace<ComponentType>(entity, component);
+            MarkChanged<ComponentType>(entity);
             
             if(IsTextComponent<ComponentType>()) {
                 _textComponents += (uint32_t)_entt.get<Component::Text>(entity)._renderInfo.size();
@@ -72,32 +78,157 @@ namespace Engine{
 		template<class ComponentType>
 		inline void SetComponent(const entt::entity entity, const ComponentType component) {
             ASSERT_IF_DEBUG(HasComponent<ComponentType>(entity), "[Scene] Cannot set a component to an entity that doesnt't have that component")
+            if(IsTextComponent<ComponentType>()) _textComponents -= (uint32_t)_entt.get<Component::Text>(entity)._renderInfo.size();
 			_entt.replace<ComponentType>(entity, component);
+            MarkChanged<ComponentType>(entity);
+            if(IsTextComponent<ComponentType>()) _textComponents += (uint32_t)_entt.get<Component::Text>(entity)._renderInfo.size();
 		}
+        // Changes the text of the Text component, only the lines from the line before the first changed character on are laid out again
+        void SetText(const entt::entity entity, const std::u32string text);
         // Has template overloaded for Component::Collider and Component::ImageBasedCollider
         template<class ComponentType>
         inline bool HasComponent(const entt::entity entity) {
             return _entt.all_of<ComponentType>(entity);
         }
         // Has template overloaded for Component::Collider and Component::ImageBasedCollider
+        // Marks the component as changed (the reference may be used to modify it), use ReadComponent if you only read
 		template<class ComponentType>
 		inline ComponentType& GetComponent(const entt::entity entity) {
+            MarkChanged<ComponentType>(entity);
 			return _entt.get<ComponentType>(entity);
 		}
+        // Has template overloaded for Component::Collider
+        // Read only access, does not mark the component as changed
+		template<class ComponentType>
+		inline const ComponentType& ReadComponent(const entt::entity entity) const {
+			return _entt.get<ComponentType>(entity);
+		}
+        /**
+         * @brief Creates count entities with the components of the prefab
+         * All the components of one type are inserted with one call and the colliders are registered in bulk,
+         * which is a lot faster than calling CreateEntity count times
+         * 
+         * @param prefab The components every entity starts with
+         * @param count The amount of entities to create
+         * @param initializer Is called as initializer(index, components&...) for every entity before the components are inserted
+         * @return The created entities
+         */
+        template<class ... Ts, class Initializer>
+        std::vector<entt::entity> Instantiate(const Prefab<Ts...>& prefab, const size_t count, Initializer&& initializer) {
+            std::vector<entt::entity> entities(count);
+            _entt.create(entities.begin(), entities.end());
+            // One contiguous block per component type
+            std::tuple<std::vector<Ts>...> components;
+            (std::get<std::vector<Ts>>(components).reserve(count), ...);
+            for(size_t i = 0; i < count; i++) {
+                std::tuple<Ts...> instance = prefab.GetComponents();
+                std::apply([&](Ts&... instanceComponents) { initializer(i, instanceComponents...); }, instance);
+                (std::get<std::vector<Ts>>(components).push_back(std::get<Ts>(instance)), ...);
+            }
+            (InsertPool<Ts>(entities, std::get<std::vector<Ts>>(components)), ...);
+            // Static colliders need the position, so they are added after all the other components
+            if constexpr ((std::is_same_v<Ts, Component::Collider> || ...)) {
+                _physics.AddColliders(_entt, entities, std::get<std::vector<Component::Collider>>(components));
+                for(const entt::entity entity : entities) MarkChanged<Component::Collider>(entity);
+            }
+            return entities;
+        }
+        template<class ... Ts>
+        std::vector<entt::entity> Instantiate(const Prefab<Ts...>& prefab, const size_t count) {
+            return Instantiate(prefab, count, [](const size_t, Ts&...) {});
+        }
+
         inline void DeleteEntity(const entt::entity entity) {
-            if(HasComponent<Component::Texture>(entity)) _textureComponents--;
+            if(HasComponent<Component::Position>(entity)) _changes.MarkRemoved<Component::Position>(_entt, entity);
+            if(HasComponent<Component::Texture>(entity)) {
+                _textureComponents--;
+                _changes.MarkRemoved<Component::Texture>(_entt, entity);
+            }
             if(HasComponent<Component::Text>(entity)) {
-                _textComponents -= (uint32_t)GetComponent<Component::Text>(entity)._renderInfo.size();
+                _textComponents -= (uint32_t)ReadComponent<Component::Text>(entity)._renderInfo.size();
+                _changes.MarkRemoved<Component::Text>(_entt, entity);
             }
             if(_physics.HasCollider(_entt, entity)) {
                 _physics.RemoveCollider(_entt, entity);
+                _changes.MarkRemoved<Component::Collider>(_entt, entity);
             }
             _entt.destroy(entity);
         }
+
+        /// @name Change tracking
+        /// Position, Texture, Text and Collider remember the last frame they were added, set or retrieved with GetComponent
+        ///@{
+        // The current frame, pass it to the *Since functions on the next frame to get everything that changed in between
+        inline FrameID GetFrame() const { return _changes.GetFrame(); }
+        template<class ComponentType>
+        inline bool HasChangedSince(const entt::entity entity, const FrameID since) const {
+            return _changes.HasChangedSince<ComponentType>(_entt, entity, since);
+        }
+        // Calls func(entity) for every entity of which the component changed after the frame since
+        template<class ComponentType, class Func>
+        inline void ForEachChangedSince(const FrameID since, Func&& func) const {
+            _changes.ForEachChangedSince<ComponentType>(_entt, since, std::forward<Func>(func));
+        }
+        // Calls func(entity) for every entity that was deleted after the frame since
+        template<class ComponentType, class Func>
+        inline void ForEachRemovedSince(const FrameID since, Func&& func) const {
+            _changes.ForEachRemovedSince<ComponentType>(since, std::forward<Func>(func));
+        }
+        inline const ChangeTracker& GetChangeTracker() const { return _changes; }
+        ///@}
+
+        /// @name Snapshots
+        ///@{
+        /**
+         * @brief Writes all the entities with a Position, Velocity, Texture, Text or collider and the physics state to a file
+         * The other components are only written when they are added with AddSnapshotComponent
+         * 
+         * @param file The file to write to (will be overwritten)
+         * @warning Throws when an entity has a component that is not written, instead of silently leaving it out
+         */
+        void SaveSnapshot(const Util::File file);
+        /**
+         * @brief Replaces all the entities of the scene with the entities in the snapshot
+         * The entities and components are created in bulk and image colliders are restored without reading the image
+         * 
+         * @param file A file written by SaveSnapshot
+         * @warning The same assets must be loaded as when the snapshot was saved (call it after LoadAssets)
+         */
+        void LoadSnapshot(const Util::File file);
+        /**
+         * @brief Writes the components of type T to the snapshots as well
+         * Call it before saving or loading a snapshot, for example in the constructor of the scene
+         * @warning T must be serializable by Util::BinarySerializer
+         */
+        template<class T>
+        void AddSnapshotComponent() {
+            ASSERT(!IsInSnapshot(entt::type_id<T>().hash()), "[Scene] The component is already written to the snapshots")
+            SnapshotComponent& component = _snapshotComponents[entt::type_id<T>().hash()];
+            component._name = std::string(entt::type_id<T>().name());
+            component._save = [this](std::unordered_map<entt::entity, uint32_t>& entityIndices, std::vector<uint8_t>& data) {
+                ComponentPoolSnapshot<T> pool;
+                SavePool(pool, entityIndices);
+                Util::BinarySerializer serializer;
+                serializer.Serialize(pool, data, ENGINE_SCENE_SNAPSHOT_SERIALIZATION_FLAGS);
+            };
+            component._load = [this](std::vector<uint8_t>& data, const std::vector<entt::entity>& entities) {
+                ComponentPoolSnapshot<T> pool;
+                Util::BinaryDeserializer deserializer;
+                deserializer.Deserialize(pool, data);
+                LoadPool(pool, entities);
+            };
+        }
+        ///@}
         
         void SetCameraPosition(const Util::Vec2F pos);
+        // The amount of sprites and characters that were drawn and culled the previous frame
+        inline const Renderer::CullingStatistics& GetCullingStatistics() const { return _window->GetCullingStatistics(); }
         void DebugLine(const Util::Vec2F start, const Util::Vec2F end, const Util::Vec3F color);
 
+        // Memory that is valid until the end of the current frame, use it for temporaries inside OnFrame:
+        //      std::pmr::vector<Entity> hits(GetFrameMemory());
+        std::pmr::memory_resource* GetFrameMemory();
+
         struct BoundingboxID {
             entt::entity e1, e2, e3, e4;
         };
@@ -131,13 +262,66 @@ namespace Engine{
 		constexpr bool IsTextComponent() { return std::is_same<T, Component::Text>::value; }
         template <typename T>
 		constexpr bool IsColliderComponent() { return std::is_same<T, Component::Collider>::value; }
+        template<class T>
+        void InsertPool(const std::vector<entt::entity>& entities, const std::vector<T>& components) {
+            if constexpr (!std::is_same_v<T, Component::Collider>) {
+                _entt.storage<T>().reserve(_entt.storage<T>().size() + components.size());
+                _entt.insert<T>(entities.begin(), entities.end(), components.begin());
+                if constexpr (std::is_same_v<T, Component::Texture>) _textureComponents += (uint32_t)components.size();
+                if constexpr (std::is_same_v<T, Component::Text>) {
+                    for(const Component::Text& text : components) _textComponents += (uint32_t)text._renderInfo.size();
+                }
+                for(const entt::entity entity : entities) MarkChanged<T>(entity);
+            }
+        }
+        template<class T>
+        void SavePool(ComponentPoolSnapshot<T>& pool, std::unordered_map<entt::entity, uint32_t>& entityIndices) {
+            auto view = _entt.view<T>();
+            pool._entities.reserve(view.size());
+            pool._components.reserve(view.size());
+            for(const auto [entity, component] : view.each()) {
+                pool._entities.push_back(entityIndices.try_emplace(entity, (uint32_t)entityIndices.size()).first->second);
+                pool._components.push_back(component);
+            }
+        }
+        template<class T>
+        void LoadPool(const ComponentPoolSnapshot<T>& pool, const std::vector<entt::entity>& entities) {
+            ASSERT(pool._entities.size() == pool._components.size(), "[Scene] Snapshot contains a corrupt component pool")
+            std::vector<entt::entity> poolEntities;
+            poolEntities.reserve(pool._entities.size());
+            for(const uint32_t index : pool._entities) {
+                ASSERT(index < entities.size(), "[Scene] Snapshot contains a component for an entity that does not exist")
+                poolEntities.push_back(entities[index]);
+            }
+            _entt.insert<T>(poolEntities.begin(), poolEntities.end(), pool._components.begin());
+            for(const entt::entity entity : poolEntities) MarkChanged<T>(entity);
+        }
+        // Lays out the text of the glyph caches that changed since the previous frame, or all of it
+        void LayoutGlyphCacheText(const bool all);
+        template <typename T>
+        inline void MarkChanged(const entt::entity entity) {
+            if constexpr (ChangeTracker::IsTracked<T>()) _changes.MarkChanged<T>(_entt, entity);
+        }
 
         entt::registry _entt;
         Game* _game;
         Renderer::Window* _window;
+        // The texture map the assets of this scene are loaded in, set by the game before LoadAssets
+        size_t _textureMapID = 0;
         uint32_t _textureComponents = 0;
         uint32_t _textComponents = 0;
         Physics::PhysicsEngine _physics;
+        ChangeTracker _changes;
+
+        // The components added with AddSnapshotComponent, by the hash of their type
+        struct SnapshotComponent {
+            std::string _name;
+            std::function<void(std::unordered_map<entt::entity, uint32_t>&, std::vector<uint8_t>&)> _save;
+            std::function<void(std::vector<uint8_t>&, const std::vector<entt::entity>&)> _load;
+        };
+        std::unordered_map<entt::id_type, SnapshotComponent> _snapshotComponents;
+        // Whether the components of the storage are written to the snapshots
+        bool IsInSnapshot(const entt::id_type type) const;
     };
     
     // Template overload
@@ -145,12 +329,14 @@ namespace Engine{
     inline void Scene::AddComponent<Component::Collider>(const entt::entity entity, const Component::Collider component) {
         ASSERT_IF_DEBUG(!_physics.HasCollider(_entt, entity), "[Scene] Cannot add a component to an entity that already has that component")
         _physics.AddCollider(_entt, entity, component);
+        _changes.MarkChanged<Component::Collider>(_entt, entity);
     }
     // Template overload
     template<>
     inline void Scene::SetComponent<Component::Collider>(const entt::entity entity, const Component::Collider component) {
         ASSERT_IF_DEBUG(_physics.HasCollider(_entt, entity), "[Scene] Cannot set a component to an entity that doesnt't have that component")
         _physics.SetCollider(_entt, entity, component);
+        _changes.MarkChanged<Component::Collider>(_entt, entity);
     }
     // Template overload
     template<>
@@ -163,6 +349,12 @@ namespace Engine{
     //      to make your changes get effect !!
     template<>
     inline Component::Collider& Scene::GetComponent<Component::Collider>(const entt::entity entity) {
+        _changes.MarkChanged<Component::Collider>(_entt, entity);
+        return _physics.GetCollider(_entt, entity);
+    }
+    // Template overload
+    template<>
+    inline const Component::Collider& Scene::ReadComponent<Component::Collider>(const entt::entity entity) const {
         return _physics.GetCollider(_entt, entity);
     }
 
@@ -0,0 +1,49 @@
+#ifndef ENGINE_CORE_SNAPSHOT_H
+#define ENGINE_CORE_SNAPSHOT_H
+
+#include "core/PCH.h"
+#include "core/Components.h"
+#include "physics/Components.h"
+#include "physics/Snapshot.h"
+
+#ifndef ENGINE_SCENE_SNAPSHOT_SERIALIZATION_FLAGS
+    #define ENGINE_SCENE_SNAPSHOT_SERIALIZATION_FLAGS (static_cast<uint8_t>(Util::BinarySerializationOutputFlag::IncludeTypeInfo) \
+                                                     | static_cast<uint8_t>(Util::BinarySerializationOutputFlag::OutputLitleEndian) \
+                                                     | static_cast<uint8_t>(Util::BinarySerializationOutputFlag::ExcludeVariableNames))
+#endif
+
+namespace Engine {
+
+    // All the components of one type, stored as one contiguous block
+    template<class T>
+    struct ComponentPoolSnapshot {
+        // Index into the entities of the scene snapshot
+        std::vector<uint32_t> _entities;
+        std::vector<T> _components;
+    };
+
+    // The components of a type added with Scene::AddSnapshotComponent, serialized on their own as a ComponentPoolSnapshot
+    struct SerializedPoolSnapshot {
+        std::string _name;// The type name, the components are only restored into the type with the same name
+        std::vector<uint8_t> _data;
+    };
+
+    /**
+     * @brief The state of a scene as written by Scene::SaveSnapshot
+     * The type info is included in the file, so a snapshot from an older version of this struct is rejected instead of misread
+     * 
+     * @warning The texture and text components refer to the loaded assets, the scene must load the same assets before loading the snapshot
+     */
+    struct SceneSnapshot {
+        uint32_t _amountEntities = 0;
+        ComponentPoolSnapshot<Component::Position> _positions;
+        ComponentPoolSnapshot<Component::Velocity> _velocities;
+        ComponentPoolSnapshot<Component::Texture> _textures;
+        ComponentPoolSnapshot<Component::Text> _texts;
+        Physics::PhysicsSnapshot _physics;
+        std::vector<SerializedPoolSnapshot> _pools;
+    };
+
+}
+
+#endif
\ No newline at end of file
@@ -111,6 +111,7 @@ namespace Network {
         // Post work for the main thread
         asio::post(asio::bind_executor(_webhandler.lock()->_requestHandler, 
         [this, self, request]() {
+            if(_webhandler.lock()->_recorder) _webhandler.lock()->_recorder->OnHTTPRequest(*request);
             std::shared_ptr<HTTP::Response> response = _webhandler.lock()->HandleRequestInternal(request);
             if(response == nullptr) response = _webhandler.lock()->NotFound(request);
 
@@ -7,6 +7,7 @@
 
 namespace Engine {
 namespace Network {
+    class InputRecorder;
 namespace HTTP {
     class Router;
     
@@ -73,6 +74,7 @@ namespace HTTP {
 
     private:
         friend class Network::HTTP::Router;
+        friend class Network::InputRecorder;
 
         Method _method;
         std::string _url;
@@ -1,6 +1,8 @@
 #include "network/HTTP/Router.h"
 #include "network/WebHandler.h"
 
+#include "util/Profiler.h"
+
 namespace Engine {
 namespace Network {
 namespace HTTP {
@@ -225,6 +227,7 @@ namespace HTTP {
     }
 
     std::shared_ptr<Response> Router::HandleRequestInternal(std::shared_ptr<HTTP::Request> request) {
+        ENGINE_PROFILE_SCOPE("Router::HandleRequest")
         ASSERT(!_currentRequest, "[Network::Router] Detected routing loop or usage of HTTP::Router from multiple threads")
         _currentRequest = request;
         // Remove leading /
@@ -0,0 +1,86 @@
+#include "network/InputRecording.h"
+
+#include "util/serialization/Binary.h"
+
+namespace Engine {
+namespace Network {
+
+    void InputRecorder::OnHTTPRequest(const HTTP::Request& request) {
+        RecordedEvent event;
+        event._type = RecordedEventType::HTTPRequest;
+        event._request = ToRecordedRequest(request);
+        _currentFrame._events.push_back(std::move(event));
+    }
+    void InputRecorder::OnWebsocketStart(const size_t connection, const HTTP::Request& request) {
+        RecordedEvent event;
+        event._type = RecordedEventType::WebsocketStart;
+        event._connection = connection;
+        event._request = ToRecordedRequest(request);
+        _currentFrame._events.push_back(std::move(event));
+    }
+    void InputRecorder::OnWebsocketMessage(const size_t connection, const Websocket::Frame& message) {
+        RecordedEvent event;
+        event._type = RecordedEventType::WebsocketMessage;
+        event._connection = connection;
+        event._opcode = (uint8_t)message._code;
+        event._body = message._body;
+        _currentFrame._events.push_back(std::move(event));
+    }
+    void InputRecorder::OnWebsocketStop(const size_t connection) {
+        RecordedEvent event;
+        event._type = RecordedEventType::WebsocketStop;
+        event._connection = connection;
+        _currentFrame._events.push_back(std::move(event));
+    }
+    void InputRecorder::EndFrame(const float dt) {
+        _currentFrame._dt = dt;
+        _recording._frames.push_back(std::move(_currentFrame));
+        _currentFrame = RecordedFrame();
+    }
+
+    void InputRecorder::Save(const Util::File file) const {
+        std::vector<uint8_t> data;
+        Util::BinarySerializer serializer;
+        serializer.Serialize(_recording, data, ENGINE_NETWORK_INPUT_RECORDING_SERIALIZATION_FLAGS);
+        file.Write(data);
+        LOG("[Network::InputRecorder] Saved " + std::to_string(_recording._frames.size()) + " frames to '" + file.String() + "'")
+    }
+    InputRecording InputRecorder::Load(const Util::File file) {
+        ASSERT(file.Exists(), "[Network::InputRecorder] Cannot load a recording from a file that does not exist ('" + file.String() + "')")
+        std::vector<uint8_t> data;
+        file.Read(data);
+        InputRecording recording;
+        Util::BinaryDeserializer deserializer;
+        deserializer.Deserialize(recording, data);
+        return recording;
+    }
+
+    RecordedRequest InputRecorder::ToRecordedRequest(const HTTP::Request& request) {
+        RecordedRequest recorded;
+        recorded._method = (uint8_t)request._method;
+        recorded._url = request._url;
+        recorded._version = request._version;
+        recorded._headers.assign(request._headers.begin(), request._headers.end());
+        recorded._cookies.assign(request._cookies.begin(), request._cookies.end());
+        recorded._body = request._body;
+        return recorded;
+    }
+    std::shared_ptr<HTTP::Request> InputRecorder::ToRequest(const RecordedRequest& recorded) {
+        std::shared_ptr<HTTP::Request> request = std::make_shared<HTTP::Request>();
+        request->_method = (HTTP::Method)recorded._method;
+        request->_url = recorded._url;
+        request->_version = recorded._version;
+        request->_headers.insert(recorded._headers.begin(), recorded._headers.end());
+        request->_cookies.insert(recorded._cookies.begin(), recorded._cookies.end());
+        request->_body = recorded._body;
+        return request;
+    }
+    std::shared_ptr<Websocket::Frame> InputRecorder::ToFrame(const RecordedEvent& recorded) {
+        std::shared_ptr<Websocket::Frame> frame = std::make_shared<Websocket::Frame>();
+        frame->_code = (Websocket::Opcode)recorded._opcode;
+        frame->_body = recorded._body;
+        return frame;
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef ENGINE_NETWORK_INPUT_RECORDING_H
+#define ENGINE_NETWORK_INPUT_RECORDING_H
+
+#include "core/PCH.h"
+#include "network/HTTP/Request.h"
+#include "network/websocket/Frame.h"
+#include "util/FileManager.h"
+
+#ifndef ENGINE_NETWORK_INPUT_RECORDING_SERIALIZATION_FLAGS
+    #define ENGINE_NETWORK_INPUT_RECORDING_SERIALIZATION_FLAGS (static_cast<uint8_t>(Util::BinarySerializationOutputFlag::IncludeTypeInfo) \
+                                                              | static_cast<uint8_t>(Util::BinarySerializationOutputFlag::OutputLitleEndian) \
+                                                              | static_cast<uint8_t>(Util::BinarySerializationOutputFlag::ExcludeVariableNames))
+#endif
+
+namespace Engine {
+namespace Network {
+
+    enum RecordedEventType : uint8_t {
+        HTTPRequest,
+        WebsocketStart,
+        WebsocketMessage,
+        WebsocketStop
+    };
+
+    // A HTTP::Request as it was received, before it was routed
+    struct RecordedRequest {
+        uint8_t _method = 0;
+        std::string _url;
+        std::string _version;
+        std::vector<std::pair<std::string, std::string>> _headers;
+        std::vector<std::pair<std::string, std::string>> _cookies;
+        std::vector<uint8_t> _body;
+    };
+
+    struct RecordedEvent {
+        uint8_t _type = RecordedEventType::HTTPRequest;
+        // The UUID of the websocket connection, unused for HTTP requests
+        uint64_t _connection = 0;
+        // Used by HTTPRequest and WebsocketStart (the upgrade request)
+        RecordedRequest _request;
+        // Used by WebsocketMessage
+        uint8_t _opcode = 0;
+        std::vector<uint8_t> _body;
+    };
+
+    struct RecordedFrame {
+        float _dt = 0;
+        // In the order they were handled on the main thread
+        std::vector<RecordedEvent> _events;
+    };
+
+    struct InputRecording {
+        std::vector<RecordedFrame> _frames;
+    };
+
+    /**
+     * @brief Records the input of every frame, so a run can be replayed deterministically
+     * The WebHandler reports every request and websocket event when it is handled on the main thread,
+     * the game reports the dt at the end of every frame.
+     * Replaying is done by WebHandler::Replay, see Game::ReplayInput
+     */
+    class InputRecorder {
+    public:
+
+        void OnHTTPRequest(const HTTP::Request& request);
+        void OnWebsocketStart(const size_t connection, const HTTP::Request& request);
+        void OnWebsocketMessage(const size_t connection, const Websocket::Frame& message);
+        void OnWebsocketStop(const size_t connection);
+        // Closes the current frame, all events after this are recorded in the next frame
+        void EndFrame(const float dt);
+
+        inline size_t GetAmountFrames() const { return _recording._frames.size(); }
+
+        void Save(const Util::File file) const;
+        static InputRecording Load(const Util::File file);
+
+        static RecordedRequest ToRecordedRequest(const HTTP::Request& request);
+        static std::shared_ptr<HTTP::Request> ToRequest(const RecordedRequest& recorded);
+        static std::shared_ptr<Websocket::Frame> ToFrame(const RecordedEvent& recorded);
+
+    private:
+        InputRecording _recording;
+        RecordedFrame _currentFrame;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "network/WebHandler.h"
 
+#include "util/Profiler.h"
+
 namespace Engine {
 namespace Network {
     
@@ -24,7 +26,7 @@ namespace Network {
         _running = true;
 
         AwaitConnection();
-        _thread = std::thread([&] { try { _context.run(); } catch (std::exception err) { THROW("[Network::Webhandler] Experienced an error:\n\t\t" + std::string(err.what())); return 1;} return 0; });
+        _thread = std::thread([&] { ENGINE_PROFILE_THREAD("Network") try { _context.run(); } catch (std::exception err) { THROW("[Network::Webhandler] Experienced an error:\n\t\t" + std::string(err.what())); return 1;} return 0; });
     }
     void WebHandler::Stop() {
         _running = false;
@@ -43,6 +45,7 @@ namespace Network {
     }
     
     void WebHandler::Update() {
+        ENGINE_PROFILE_SCOPE("WebHandler::Update")
         auto count = _requestHandler.poll();
         if(_requestHandler.stopped()) _requestHandler.restart();
     }
@@ -86,10 +89,51 @@ namespace Network {
         if(ENGINE_NETWORK_VERBOSE_HTTP_WEBSOCKET) LOG("[Network::WebHandler] Upgraded connection (" + std::to_string(uuid) + ")")
         // Post work for the main thread
         asio::post(_requestHandler, [this, newConnection, request, handler]() {
+            if(_recorder) _recorder->OnWebsocketStart(newConnection->GetUUID(), *request);
             handler->OnWebsocketStart(*newConnection.get(), *request);
         });
     }
 
+    void WebHandler::Replay(const RecordedEvent& event) {
+        switch(event._type) {
+        case RecordedEventType::HTTPRequest: {
+            std::shared_ptr<HTTP::Response> response = HandleRequestInternal(InputRecorder::ToRequest(event._request));
+            // The websocket start event of this upgrade is recorded later and needs the handler that accepted it
+            if(response && response->IsWebsocketUpgrade()) _replayHandlers.push(response->GetUserData());
+            break;
+        }
+        case RecordedEventType::WebsocketStart: {
+            ASSERT(_replayHandlers.size(), "[Network::WebHandler] Replaying a websocket start without a replayed upgrade request")
+            Util::WeirdPointer<Websocket::BasicHandler> handler = _replayHandlers.front();
+            _replayHandlers.pop();
+            // The socket is never opened and the network thread is not running, so the connection never reads or writes
+            std::shared_ptr<WebsocketConnection> connection = std::make_shared<WebsocketConnection>(shared_from_this(), asio::ip::tcp::socket(_context), handler);
+            connection->Start(event._connection);// Reuse the recorded UUID, so the game sees the same connection IDs
+            _websocketConnections[event._connection] = connection;
+            handler->OnWebsocketStart(*connection.get(), *InputRecorder::ToRequest(event._request));
+            break;
+        }
+        case RecordedEventType::WebsocketMessage: {
+            auto connection = _websocketConnections.find(event._connection);
+            if(connection == _websocketConnections.end()) {
+                WARNING("[Network::WebHandler] Replaying a websocket message on an unknown connection (" + std::to_string(event._connection) + ")")
+                break;
+            }
+            connection->second->GetHandler()->OnWebsocketMessage(*connection->second.get(), *InputRecorder::ToFrame(event));
+            break;
+        }
+        case RecordedEventType::WebsocketStop: {
+            auto connection = _websocketConnections.find(event._connection);
+            if(connection == _websocketConnections.end()) break;
+            connection->second->GetHandler()->OnWebsocketStop(*connection->second.get());
+            _websocketConnections.erase(connection);
+            break;
+        }
+        default:
+            THROW("[Network::WebHandler] Cannot replay an event of unknown type " + std::to_string(event._type))
+        }
+    }
+
     std::string WebHandler::GetLocalAdress() {
         asio::ip::tcp::resolver resolver(_context);
         const auto query = resolver.resolve(asio::ip::host_name(), "");
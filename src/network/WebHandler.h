@@ -12,6 +12,8 @@
 #include "network/websocket/Connection.h"
 #include "network/websocket/BasicHandler.h"
 
+#include "network/InputRecording.h"
+
 #ifndef ENGINE_NETWORK_LAN_POLLING_RATE
 #define ENGINE_NETWORK_LAN_POLLING_RATE std::chrono::seconds(3)
 #endif
@@ -54,6 +56,18 @@ namespace Network {
 
         std::string GetLocalAdress();
 
+        /**
+         * Reports every request and websocket event to the recorder when it is handled on the main thread.
+         * Pass nullptr to stop recording.
+         */
+        void SetInputRecorder(InputRecorder* recorder) { _recorder = recorder; }
+        /**
+         * Handles a recorded event as if it was just received, used to replay a recording without networking.
+         * Everything send to a replayed websocket connection is dropped.
+         * @warning Do not start the WebHandler while replaying
+         */
+        void Replay(const RecordedEvent& event);
+
     private:
         friend class HTTPConnection;/// Acesses both io_context's and Router class
         friend class WebsocketConnection;/// Acesses both io_context's
@@ -84,6 +98,10 @@ namespace Network {
         std::map<size_t, std::shared_ptr<HTTPConnection>> _httpConnections;
         std::map<size_t, std::shared_ptr<WebsocketConnection>> _websocketConnections;
 
+        InputRecorder* _recorder = nullptr;
+        /// The handlers that accepted a replayed websocket upgrade, in the order the upgrades were replayed
+        std::queue<Util::WeirdPointer<Websocket::BasicHandler>> _replayHandlers;
+
     };
 
 }
@@ -39,6 +39,7 @@ namespace Network {
         // Post work for the main thread
         std::shared_ptr<WebsocketConnection> self = shared_from_this();
         asio::post(_webhandler.lock()->_requestHandler, [this, self]() {
+            if(_webhandler.lock()->_recorder) _webhandler.lock()->_recorder->OnWebsocketStop(_uuid);
             _websocketHandler->OnWebsocketStop(*self.get());
         });
     }
@@ -115,6 +116,7 @@ namespace Network {
         _receivingFrame = std::make_shared<Websocket::Frame>();
         // Post work for the main thread
         asio::post(_webhandler.lock()->_requestHandler, [this, self, frame]() {
+            if(_webhandler.lock()->_recorder) _webhandler.lock()->_recorder->OnWebsocketMessage(_uuid, *frame);
             _websocketHandler->OnWebsocketMessage(*self.get(), *frame);
         });
     }
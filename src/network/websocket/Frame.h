@@ -6,6 +6,7 @@
 
 namespace Engine {
 namespace Network {
+    class InputRecorder;
 namespace Websocket {
 
     #ifndef ENGINE_NETWORK_MAXIMUM_WEBSOCKET_BODY
@@ -68,6 +69,8 @@ namespace Websocket {
         Opcode GetOpcode() { return _code; }
 
     private:
+        friend class Network::InputRecorder;
+
         std::vector<uint8_t> _buffer;
         Opcode _code;
         bool _errorOccured = false;
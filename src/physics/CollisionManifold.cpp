@@ -118,11 +118,12 @@ namespace Physics {
         }
     }
 
-    void CollisionManifold::PositionalCorrection() {
+    bool CollisionManifold::PositionalCorrection() {
         RecalculatePenetration();
-        if(_penetration >= 0) return;
+        if(_penetration >= 0) return false;
         _posA->_pos += _normal * _penetration * (_a->im / (_a->im + _b->im));
         _posB->_pos -= _normal * _penetration * (_b->im / (_a->im + _b->im));
+        return true;
     }
 
 
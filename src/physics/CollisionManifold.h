@@ -45,7 +45,8 @@ namespace Physics {
 
         bool DoesCollide();
         void ApplyImpulse();
-        void PositionalCorrection();
+        // Returns if the positions were moved
+        bool PositionalCorrection();
 
     private:
         friend class PhysicsEngine;
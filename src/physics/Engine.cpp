@@ -1,5 +1,7 @@
 #include "physics/Engine.h"
 
+#include "util/Profiler.h"
+
 // UUIDS:
 
 // Static UUID has the first bit set to 0
@@ -13,15 +15,21 @@
 namespace Engine {
 namespace Physics {
 
-    void PhysicsEngine::Update(entt::registry& registry, float dt) {
-		std::vector<CollisionManifold> manifolds;
+    void PhysicsEngine::Update(entt::registry& registry, float dt, std::pmr::memory_resource* frameMemory, ChangeTracker* changes) {
+		ENGINE_PROFILE_SCOPE("PhysicsEngine::Update")
+		std::pmr::vector<CollisionManifold> manifolds(frameMemory);
+		// The entities of the bodies of manifolds[i], entt::null for the copies of the static bodies
+		std::pmr::vector<std::pair<entt::entity, entt::entity>> manifoldEntities(frameMemory);
+		std::pmr::vector<StaticBody> staticBodies(frameMemory);
 
 		int i = 0;
 		for(auto& [uuid, body] : _movingBodies) {
 			Component::Position& pos1 = registry.get<Component::Position>(body.entity);
 			Component::Velocity* vel1 = registry.try_get<Component::Velocity>(body.entity);
 			AABB aabb1 = body.GetAABB(pos1);
-			for(auto& body2 : _staticBodies.Query(aabb1)) {
+			staticBodies.clear();
+			_staticBodies.Query(aabb1, staticBodies);
+			for(auto& body2 : staticBodies) {
 				// Lifetime of the body2 ends after this forloop
 				// Create a copy of the collider+position and indicate with a flag CollisionManifold needs
 				// 		to delete the pointers
@@ -32,8 +40,10 @@ namespace Physics {
 				CollisionManifold manifold(
 					&body.col, &pos1, vel1,
 					body2Ptr, pos2Ptr, nullptr);
-				if(manifold.DoesCollide())
+				if(manifold.DoesCollide()) {
                 	manifolds.push_back(std::move(manifold));
+					manifoldEntities.emplace_back(body.entity, entt::null);
+				}
 			}
 			int j = 0;
 			for(auto& [uuid2, body2] : _movingBodies) {
@@ -45,8 +55,10 @@ namespace Physics {
 				CollisionManifold manifold(
 					&body.col, &pos1, vel1,
 					&body2.col, &pos2, vel2);
-				if(manifold.DoesCollide())
+				if(manifold.DoesCollide()) {
                 	manifolds.push_back(std::move(manifold));
+					manifoldEntities.emplace_back(body.entity, body2.entity);
+				}
 			}
 			i++;
 		}
@@ -71,13 +83,20 @@ namespace Physics {
 				vel.v += _gravity * _movingBodies[col->uuid].col.gravityFactor * dt;
 			}
 
+			const Component::Position oldPos = pos;
 			pos._pos += vel.v * dt;
 			pos._rotation += vel.w * dt;
+			// Resting bodies keep their position, so they do not need to be marked
+			if(changes && (pos._pos != oldPos._pos || pos._rotation != oldPos._rotation)) changes->MarkChanged<Component::Position>(registry, entity);
 		}
 		}
 
-		for(auto& manifold : manifolds) {
-			manifold.PositionalCorrection();
+		for(size_t m = 0; m < manifolds.size(); m++) {
+			// Also moves the bodies without a velocity
+			if(!manifolds[m].PositionalCorrection() || !changes) continue;
+			const auto [entityA, entityB] = manifoldEntities[m];
+			if(entityA != entt::null) changes->MarkChanged<Component::Position>(registry, entityA);
+			if(entityB != entt::null) changes->MarkChanged<Component::Position>(registry, entityB);
 		}
     }
 	
@@ -97,6 +116,27 @@ namespace Physics {
 			_nextMovingID++;
 		}
 	}
+	void PhysicsEngine::AddColliders(entt::registry& registry, const std::vector<entt::entity>& entities, const std::vector<Component::Collider>& colliders) {
+		ASSERT(entities.size() == colliders.size(), "[PhysicsEngine::AddColliders] Needs exactly one collider per entity")
+		std::vector<Component::ColliderUUID> uuids;
+		uuids.reserve(entities.size());
+		for(size_t i = 0; i < entities.size(); i++) {
+			const Component::Collider& collider = colliders[i];
+			if(collider.IsStatic()) {
+				const Component::Position* pos = registry.try_get<Component::Position>(entities[i]);
+				ASSERT(pos != nullptr, "[PhysicsEngine::AddColliders] Cannot add a static collider to an entity without a position")
+				StaticBody body = StaticBody(*pos, collider);
+				uuids.push_back(NEW_STATIC_UUID((uint64_t)_staticBodies.Insert(body, body.GetAABB())));
+			} else {
+				const uint64_t uuid = NEW_MOVING_UUID;
+				// The keys are increasing, so inserting at the end is constant time
+				_movingBodies.emplace_hint(_movingBodies.end(), uuid, MovingBody(collider, entities[i]));
+				uuids.push_back(uuid);
+				_nextMovingID++;
+			}
+		}
+		registry.insert<Component::ColliderUUID>(entities.begin(), entities.end(), uuids.begin());
+	}
 	void PhysicsEngine::SetCollider(entt::registry& registry, const entt::entity entity, const Component::Collider collider) {
 		uint64_t uuid = registry.get<Component::ColliderUUID>(entity).uuid;
 		if(IS_STATIC(uuid)) {
@@ -119,6 +159,14 @@ namespace Physics {
 			return _movingBodies[uuid].col;
 		}
 	}
+	const Component::Collider& PhysicsEngine::GetCollider(const entt::registry& registry, const entt::entity entity) const {
+		uint64_t uuid = registry.get<Component::ColliderUUID>(entity).uuid;
+		if(IS_STATIC(uuid)) {
+			return _staticBodies.Get(uuid).col;
+		} else {
+			return _movingBodies.at(uuid).col;
+		}
+	}
     void PhysicsEngine::UpdateCollider(entt::registry& registry, const entt::entity entity) {
 		uint64_t uuid = registry.get<Component::ColliderUUID>(entity).uuid;
 		if(IS_STATIC(uuid)) {
@@ -208,6 +256,86 @@ namespace Physics {
 	void PhysicsEngine::UpdateImageCollider(entt::registry& registry, const entt::entity entity) {
 		THROW("Why whould you update an image collider, that is extremely inefficient. Please just create a new scene if you want a new collider. TODO implement this function")
 	}
+	void PhysicsEngine::SaveSnapshot(entt::registry& registry, std::unordered_map<entt::entity, uint32_t>& entityIndices, PhysicsSnapshot& snapshot) const {
+		auto IndexOf = [&entityIndices](const entt::entity entity) {
+			return entityIndices.try_emplace(entity, (uint32_t)entityIndices.size()).first->second;
+		};
+		snapshot._gravity = _gravity;
+		snapshot._nextImageColliderID = _nextImageColliderID;
+
+		// Static bodies only know their own ID, so first find the entities that own one
+		std::unordered_map<uint64_t, entt::entity> staticOwners;
+		for(const auto [entity, uuid] : registry.view<Component::ColliderUUID>().each()) {
+			if(IS_STATIC(uuid.uuid)) staticOwners[uuid.uuid] = entity;
+		}
+		snapshot._staticBodies.reserve(staticOwners.size());
+		_staticBodies.ForEach([&](const ChildID id, const StaticBody& body) {
+			auto owner = staticOwners.find(id);
+			snapshot._staticBodies.push_back(StaticBodySnapshot{
+				id, owner == staticOwners.end() ? UINT32_MAX : IndexOf(owner->second), body.pos, ColliderSnapshot(body.col)
+			});
+		});
+
+		snapshot._movingBodies.reserve(_movingBodies.size());
+		for(const auto& [uuid, body] : _movingBodies) {
+			snapshot._movingBodies.push_back(MovingBodySnapshot{ IndexOf(body.entity), ColliderSnapshot(body.col) });
+		}
+
+		for(const auto [entity, id] : registry.view<Component::ImageBasedColliderID>().each()) {
+			snapshot._imageColliders.push_back(ImageColliderSnapshot{
+				IndexOf(entity), id.id, id.firstStaticBody, id.lastStaticBody, _imageBasedColliders.at(id.id)
+			});
+		}
+	}
+	void PhysicsEngine::LoadSnapshot(entt::registry& registry, const PhysicsSnapshot& snapshot, const std::vector<entt::entity>& entities) {
+		ASSERT(_movingBodies.empty() && _imageBasedColliders.empty() && _staticBodies.GetNextChildID() == 0, "[PhysicsEngine::LoadSnapshot] Can only load a snapshot into an empty physics engine")
+		_gravity = snapshot._gravity;
+		_nextImageColliderID = snapshot._nextImageColliderID;
+
+		// Register all the ColliderUUIDs with one insert instead of an emplace per entity
+		std::vector<entt::entity> owners;
+		std::vector<Component::ColliderUUID> uuids;
+		owners.reserve(snapshot._staticBodies.size() + snapshot._movingBodies.size());
+		uuids.reserve(snapshot._staticBodies.size() + snapshot._movingBodies.size());
+
+		// The IDs are kept, image colliders refer to a range of them
+		_staticBodies.SetContinuousIDs(true);
+		for(const StaticBodySnapshot& body : snapshot._staticBodies) {
+			StaticBody staticBody(body._position, body._collider.ToCollider());
+			_staticBodies.InsertWithID(body._id, staticBody, staticBody.GetAABB());
+			if(body._entity == UINT32_MAX) continue;
+			owners.push_back(entities[body._entity]);
+			uuids.push_back(NEW_STATIC_UUID((uint64_t)body._id));
+		}
+		_staticBodies.SetContinuousIDs(false);
+
+		for(const MovingBodySnapshot& body : snapshot._movingBodies) {
+			const uint64_t uuid = NEW_MOVING_UUID;
+			// The keys are increasing, so inserting at the end is constant time
+			_movingBodies.emplace_hint(_movingBodies.end(), uuid, MovingBody(body._collider.ToCollider(), entities[body._entity]));
+			owners.push_back(entities[body._entity]);
+			uuids.push_back(uuid);
+			_nextMovingID++;
+		}
+		registry.insert<Component::ColliderUUID>(owners.begin(), owners.end(), uuids.begin());
+
+		for(const ImageColliderSnapshot& image : snapshot._imageColliders) {
+			_imageBasedColliders[image._id] = image._collider;
+			Component::ImageBasedColliderID id;
+			id.id = image._id;
+			id.firstStaticBody = image._firstStaticBody;
+			id.lastStaticBody = image._lastStaticBody;
+			registry.emplace<Component::ImageBasedColliderID>(entities[image._entity], id);
+		}
+	}
+	void PhysicsEngine::Clear() {
+		_staticBodies.Clear();
+		_movingBodies.clear();
+		_imageBasedColliders.clear();
+		_nextMovingID = 0;
+		_nextImageColliderID = 0;
+	}
+
 	void PhysicsEngine::RemoveImageCollider(entt::registry& registry, const entt::entity entity) {
 		Component::ImageBasedColliderID id = registry.get<Component::ImageBasedColliderID>(entity);
 		for(uint64_t i = id.firstStaticBody; i < id.lastStaticBody; i++) {
@@ -3,9 +3,11 @@
 
 #include "core/PCH.h"
 #include "core/Components.h"
+#include "core/ChangeTracker.h"
 #include "physics/Components.h"
 #include "physics/CollisionManifold.h"
 #include "physics/QuadTree.h"
+#include "physics/Snapshot.h"
 #include "util/FileManager.h"
 
 namespace Engine {
@@ -21,7 +23,9 @@ namespace Physics {
 
         PhysicsEngine(const AABB worldBounds) : _staticBodies(worldBounds) {}
 
-        void Update(entt::registry& registry, float dt);
+        // The frame memory is used for all the temporary allocations of the update
+        // The positions the update moves are marked in changes (if not nullptr)
+        void Update(entt::registry& registry, float dt, std::pmr::memory_resource* frameMemory = std::pmr::get_default_resource(), ChangeTracker* changes = nullptr);
 
         void SetGravity(const Util::Vec2F gravity);
         
@@ -29,8 +33,11 @@ namespace Physics {
         // We store only the UUID so we can organize the colliders any way we want
         void AddCollider(entt::registry& registry, const entt::entity entity, const Component::Collider collider);
         void SetCollider(entt::registry& registry, const entt::entity entity, const Component::Collider collider);
+        // Adds colliders[i] to entities[i], registers all the ColliderUUIDs with one insert
+        void AddColliders(entt::registry& registry, const std::vector<entt::entity>& entities, const std::vector<Component::Collider>& colliders);
         bool HasCollider(entt::registry& registry, const entt::entity entity);
         Component::Collider& GetCollider(entt::registry& registry, const entt::entity entity);
+        const Component::Collider& GetCollider(const entt::registry& registry, const entt::entity entity) const;
         // Should be called after retrieving a collider and modifying it
         void UpdateCollider(entt::registry& registry, const entt::entity entity);
         void RemoveCollider(entt::registry& registry, const entt::entity entity);
@@ -45,6 +52,15 @@ namespace Physics {
         void UpdateImageCollider(entt::registry& registry, const entt::entity entity);
         void RemoveImageCollider(entt::registry& registry, const entt::entity entity);
 
+        // Writes all the bodies to the snapshot, entities are converted to their index in entityIndices
+        //      (entities that are not yet in entityIndices get the next free index)
+        void SaveSnapshot(entt::registry& registry, std::unordered_map<entt::entity, uint32_t>& entityIndices, PhysicsSnapshot& snapshot) const;
+        // Restores the bodies from the snapshot, the engine must be empty (see Clear)
+        //      entities[i] is the entity with index i in the snapshot
+        void LoadSnapshot(entt::registry& registry, const PhysicsSnapshot& snapshot, const std::vector<entt::entity>& entities);
+        // Removes all the bodies, does not remove the ColliderUUID components from the registry
+        void Clear();
+
     private:
         Util::Vec2F _gravity = Util::Vec2F(0);
 
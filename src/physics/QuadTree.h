@@ -40,6 +40,12 @@ namespace Physics {
             _nextChildID++;
             return id;
         }
+        // Insert with an ID that was handed out before (for example when restoring a snapshot)
+        // The ID must not be in use
+        void InsertWithID(const ChildID id, const T obj, const AABB aabb) {
+            ASSERT(TryInsert(0, obj, aabb, id), "[Physics::QuadTree] Failed to insert node");// Insert at root node
+            _nextChildID = std::max(_nextChildID, id+1);
+        }
         void Set(const ChildID id, const T obj, const AABB aabb) {
             TryRemove(0, id);
             TryInsert(0, obj, aabb, id);
@@ -55,12 +61,22 @@ namespace Physics {
             return *obj;
         #endif
         }
+        const T& Get(const ChildID id) const {
+            // The lookup does not modify the tree
+            return const_cast<QuadTree*>(this)->Get(id);
+        }
         // Returns all the data with its bounding box inside the queried area
         std::vector<T> Query(const AABB aabb) const {
             std::vector<T> result;
             Query(0, aabb, result);// Query the root node
             return result;
         }
+        // Appends all the data with its bounding box inside the queried area to result
+        // Use with a std::pmr::vector to keep the query results out of the heap
+        template<class Allocator>
+        void Query(const AABB aabb, std::vector<T, Allocator>& result) const {
+            Query(0, aabb, result);// Query the root node
+        }
         // Removes the element with the id
         void Remove(const ChildID id) {
             #if EFFICIENT_LOOKUP
@@ -69,6 +85,28 @@ namespace Physics {
             TryRemove(0, id);
             #endif
         }
+        // Removes all the elements, keeps the bounds of the root node
+        void Clear() {
+            const AABB aabb = _nodes[0]._aabb;
+            _nodes.clear();
+            Node root{};
+            root._aabb = aabb;
+            _nodes.push_back(root);
+            _emptyNodes = std::priority_queue<NodeID>();
+            _nextChildID = 0;
+            #if EFFICIENT_LOOKUP
+            _childrenLocations.clear();
+            #endif
+        }
+        // Calls func(id, obj) for every element in the tree
+        template<class Func>
+        void ForEach(Func&& func) const {
+            for(size_t i = 0; i < _nodes.size(); i++) {
+                for(const Data& data : _nodes[i]._children) {
+                    func(data._uuid, data._obj);
+                }
+            }
+        }
 
     private:
         struct Data {
@@ -188,7 +226,8 @@ namespace Physics {
             #endif
             return true;
         }
-        void Query(const NodeID atNode, const AABB& aabb, std::vector<T>& result) const {
+        template<class Allocator>
+        void Query(const NodeID atNode, const AABB& aabb, std::vector<T, Allocator>& result) const {
             if(!aabb.HasOverlap(_nodes[atNode]._aabb)) {
                 // If this is the root node, return all the root nodes children
                 if(atNode == 0) {
@@ -0,0 +1,43 @@
+#include "physics/Snapshot.h"
+
+namespace Engine {
+namespace Physics {
+
+    ColliderSnapshot::ColliderSnapshot(const Component::Collider& collider) 
+        : _flags(collider.flags), _e(collider.e), _im(collider.im), _iL(collider.iL), _sf(collider.sf), _df(collider.df), _gravityFactor(collider.gravityFactor) {
+        if(collider.flags & Component::ColliderFlags::Polygon) {
+            _shape.assign(collider.shape.polygon.points, collider.shape.polygon.points + collider.shape.polygon.numPoints);
+        } else if(collider.flags & Component::ColliderFlags::Rectangle) {
+            _shape.push_back(collider.shape.rectangle.size);
+        } else if(collider.flags & Component::ColliderFlags::Circle) {
+            _shape.push_back(Util::Vec2F(collider.shape.circle.radius, 0));
+        }
+    }
+    Component::Collider ColliderSnapshot::ToCollider() const {
+        Component::Collider collider;
+        collider.flags = _flags;
+        collider.e = _e;
+        collider.im = _im;
+        collider.iL = _iL;
+        collider.sf = _sf;
+        collider.df = _df;
+        collider.gravityFactor = _gravityFactor;
+        if(_flags & Component::ColliderFlags::Polygon) {
+            ASSERT(_shape.size() <= ENGINE_PHYSICS_MAX_POLYGON_SIZE, "[Physics::ColliderSnapshot] Snapshot contains a polygon with more points than ENGINE_PHYSICS_MAX_POLYGON_SIZE")
+            collider.shape.polygon = Polygon();
+            for(size_t i = 0; i < _shape.size(); i++) collider.shape.polygon.points[i] = _shape[i];
+            collider.shape.polygon.numPoints = (int)_shape.size();
+        } else if(_flags & Component::ColliderFlags::Rectangle) {
+            ASSERT(_shape.size() == 1, "[Physics::ColliderSnapshot] Snapshot contains an invalid rectangle")
+            collider.shape.rectangle = Rectangle();
+            collider.shape.rectangle.size = _shape[0];
+        } else if(_flags & Component::ColliderFlags::Circle) {
+            ASSERT(_shape.size() == 1, "[Physics::ColliderSnapshot] Snapshot contains an invalid circle")
+            collider.shape.circle = Circle();
+            collider.shape.circle.radius = _shape[0].x;
+        }
+        return collider;
+    }
+
+}
+}
\ No newline at end of file
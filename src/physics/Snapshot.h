@@ -0,0 +1,59 @@
+#ifndef ENGINE_PHYSICS_SNAPSHOT_H
+#define ENGINE_PHYSICS_SNAPSHOT_H
+
+#include "core/PCH.h"
+#include "core/Components.h"
+#include "physics/Components.h"
+
+namespace Engine {
+namespace Physics {
+
+    // Component::Collider without the union, so it can be handled by the Util::Serializer
+    struct ColliderSnapshot {
+        ColliderSnapshot() {}
+        ColliderSnapshot(const Component::Collider& collider);
+        Component::Collider ToCollider() const;
+
+        uint16_t _flags = 0;
+        float _e = 1;
+        float _im = 1;
+        float _iL = 0.5;
+        float _sf = 0.5f;
+        float _df = 0.3f;
+        float _gravityFactor = 1;
+        // Polygon: the points, Rectangle: the size, Circle: (radius, 0)
+        std::vector<Util::Vec2F> _shape;
+    };
+
+    // The entities are stored as an index into the entities of the scene snapshot
+    struct MovingBodySnapshot {
+        uint32_t _entity;
+        ColliderSnapshot _collider;
+    };
+    struct StaticBodySnapshot {
+        uint32_t _id;// The ID inside the quadtree
+        uint32_t _entity;// UINT32_MAX for bodies that are part of an image collider
+        Component::Position _position;
+        ColliderSnapshot _collider;
+    };
+    struct ImageColliderSnapshot {
+        uint32_t _entity;
+        uint32_t _id;
+        uint64_t _firstStaticBody;
+        uint64_t _lastStaticBody;
+        Component::ImageBasedCollider _collider;
+    };
+
+    // The complete state of the PhysicsEngine, see PhysicsEngine::SaveSnapshot
+    struct PhysicsSnapshot {
+        Util::Vec2F _gravity;
+        std::vector<MovingBodySnapshot> _movingBodies;
+        std::vector<StaticBodySnapshot> _staticBodies;
+        std::vector<ImageColliderSnapshot> _imageColliders;
+        uint32_t _nextImageColliderID = 0;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
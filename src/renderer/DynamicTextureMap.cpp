@@ -0,0 +1,207 @@
+#include "renderer/DynamicTextureMap.h"
+
+#include "util/Profiler.h"
+
+namespace Engine {
+namespace Renderer {
+
+    void DynamicTextureMap::Init(const uint32_t framesInFlight, const bool headless) {
+        _headless = headless;
+        _stagingBuffers.resize(framesInFlight);
+        _stagingSizes.resize(framesInFlight, 0);
+    }
+    void DynamicTextureMap::Cleanup(Vulkan::Context& context, std::initializer_list<Vulkan::Pipeline*> boundToPipelines) {
+        for(Bin& bin : _bins) {
+            if(_headless) break;
+            for(Vulkan::Pipeline* pipeline : boundToPipelines) {
+                pipeline->UnbindTextureDescriptor(context, bin._descriptorBinding, bin._texture);
+            }
+            bin._texture.Cleanup(context);
+        }
+        for(size_t i = 0; i < _stagingBuffers.size(); i++) {
+            if(_stagingSizes[i]) _stagingBuffers[i].Cleanup(context);
+            _stagingSizes[i] = 0;
+        }
+        _bins.clear();
+        _preparedBins = 0;
+        _entries.clear();
+        _removedIDs.clear();
+        _areas.clear();
+        _removedAreaIDs.clear();
+        _pendingAreas.clear();
+    }
+
+    uint32_t DynamicTextureMap::AddTextureLoader(Vulkan::Context& context, std::shared_ptr<AssetLoader> assetLoader, std::initializer_list<Vulkan::Pipeline*> bindToPipelines) {
+        ENGINE_PROFILE_SCOPE("DynamicTextureMap::AddTextureLoader")
+        assetLoader->Init();
+        const size_t amountTextures = assetLoader->GetAmountTextures();
+        std::vector<Util::Vec3U32> sizes(amountTextures);
+        if(amountTextures) assetLoader->SetTextureSizes(sizes.data(), nullptr);
+
+        Entry entry;
+        entry._areas.resize(amountTextures);
+        for(size_t id = 0; id < amountTextures; id++) {
+            PackedArea& packed = entry._areas[id];
+            packed._bin = Allocate(context, Util::Vec2U32(sizes[id].x, sizes[id].y), packed._area, bindToPipelines);
+            // Rendered into its own memory, so the upload can copy it as one region
+            PendingArea pending{packed._bin, packed._area, std::vector<Util::AreaU8>((size_t)packed._area.w * packed._area.h)};
+            assetLoader->RenderTexture(pending._pixels.data(), Util::Vec2U32(packed._area.w, packed._area.h), Util::AreaU32(0, 0, packed._area.w, packed._area.h), id);
+            if(!pending._pixels.empty()) _pendingAreas.push_back(std::move(pending));
+
+            const Util::Vec2U32 binSize = ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE;
+            assetLoader->SetTextureRenderInfo(
+                Util::AreaF((float)packed._area.x/binSize.x, (float)packed._area.y/binSize.y, (float)packed._area.w/binSize.x, (float)packed._area.h/binSize.y),
+                _bins[packed._bin]._descriptorBinding,
+                id
+            );
+        }
+        entry._renderInfo = assetLoader->GetRenderInfo();
+        return AddEntry(_entries, _removedIDs, std::move(entry));
+    }
+    uint32_t DynamicTextureMap::AddArea(Vulkan::Context& context, const Util::Vec2U32 size, std::vector<Util::AreaU8>&& pixels, std::initializer_list<Vulkan::Pipeline*> bindToPipelines, Util::AreaF& textureArea, uint32_t& boundTexture) {
+        ASSERT(pixels.size() == (size_t)size.x*size.y, "[Renderer::DynamicTextureMap] The pixels of an area should be tightly packed")
+        PackedArea packed;
+        packed._bin = Allocate(context, size, packed._area, bindToPipelines);
+        if(!pixels.empty()) _pendingAreas.push_back(PendingArea{packed._bin, packed._area, std::move(pixels)});
+
+        const Util::Vec2U32 binSize = ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE;
+        textureArea = Util::AreaF((float)packed._area.x/binSize.x, (float)packed._area.y/binSize.y, (float)packed._area.w/binSize.x, (float)packed._area.h/binSize.y);
+        boundTexture = _bins[packed._bin]._descriptorBinding;
+        Entry entry;
+        entry._areas.push_back(packed);
+        return AddEntry(_areas, _removedAreaIDs, std::move(entry));
+    }
+    uint32_t DynamicTextureMap::AddEntry(std::vector<Entry>& entries, std::vector<uint32_t>& removedIDs, Entry&& entry) {
+        entry._used = true;
+        if(!removedIDs.empty()) {
+            const uint32_t id = removedIDs.back();
+            removedIDs.pop_back();
+            entries[id] = std::move(entry);
+            return id;
+        }
+        entries.push_back(std::move(entry));
+        return (uint32_t)(entries.size() - 1);
+    }
+    void DynamicTextureMap::Remove(const uint32_t id) {
+        ASSERT(id < _entries.size() && _entries[id]._used, "[Renderer::DynamicTextureMap] Cannot remove an asset that is not in the dynamic texture map")
+        RemoveEntry(_entries, _removedIDs, id);
+    }
+    void DynamicTextureMap::RemoveArea(const uint32_t id) {
+        ASSERT(id < _areas.size() && _areas[id]._used, "[Renderer::DynamicTextureMap] Cannot remove an area that is not in the dynamic texture map")
+        RemoveEntry(_areas, _removedAreaIDs, id);
+    }
+    void DynamicTextureMap::RemoveEntry(std::vector<Entry>& entries, std::vector<uint32_t>& removedIDs, const uint32_t id) {
+        const std::vector<PackedArea>& areas = entries[id]._areas;
+        for(const PackedArea& packed : areas) {
+            if(packed._area.w == 0 || packed._area.h == 0) continue;
+            _bins[packed._bin]._freeAreas.push_back(packed._area);
+        }
+        // Not copied anymore when it was not uploaded yet
+        std::erase_if(_pendingAreas, [&](const PendingArea& pending) {
+            return std::any_of(areas.begin(), areas.end(), [&](const PackedArea& packed) {
+                return packed._bin == pending._bin && packed._area.x == pending._area.x && packed._area.y == pending._area.y;
+            });
+        });
+        entries[id] = Entry();
+        removedIDs.push_back(id);
+    }
+
+    void DynamicTextureMap::Upload(Vulkan::Context& context, Vulkan::CommandBuffer& commandBuffer, const uint32_t frameInFlight) {
+        // The new bins are bound from their creation on, so they need to be in the shader read layout before this frame draws
+        for(; _preparedBins < _bins.size(); _preparedBins++) _bins[_preparedBins]._texture.PrepareForSampling(commandBuffer);
+        if(_pendingAreas.empty()) return;
+        ENGINE_PROFILE_SCOPE("DynamicTextureMap::Upload")
+        size_t size = 0;
+        for(const PendingArea& pending : _pendingAreas) size += pending._pixels.size()*sizeof(Util::AreaU8);
+        Vulkan::TransferBuffer& staging = _stagingBuffers[frameInFlight];
+        if(_stagingSizes[frameInFlight] == 0) staging.Init(context, (uint32_t)size);
+        else staging.Resize(context, (uint32_t)size);
+        _stagingSizes[frameInFlight] = staging.GetSize();
+
+        // One copy per bin, with a region per area
+        std::vector<std::vector<VkBufferImageCopy>> regions(_bins.size());
+        staging.StartTransferingData(context);
+        VkDeviceSize offset = 0;
+        for(const PendingArea& pending : _pendingAreas) {
+            VkBufferImageCopy region{};
+            region.bufferOffset = offset;
+            region.bufferRowLength = 0;// Tightly packed
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = { (int32_t)pending._area.x, (int32_t)pending._area.y, 0 };
+            region.imageExtent = { pending._area.w, pending._area.h, 1 };
+            regions[pending._bin].push_back(region);
+            staging.AddData(pending._pixels);
+            offset += pending._pixels.size()*sizeof(Util::AreaU8);
+        }
+        staging.EndTransferingData(context);
+        for(size_t i = 0; i < _bins.size(); i++) {
+            _bins[i]._texture.CopyRegions(commandBuffer, staging, regions[i]);
+        }
+        _pendingAreas.clear();
+    }
+
+    uint32_t DynamicTextureMap::Allocate(Vulkan::Context& context, const Util::Vec2U32 size, Util::AreaU32& area, std::initializer_list<Vulkan::Pipeline*> bindToPipelines) {
+        const Util::Vec2U32 binSize = ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE;
+        ASSERT(size.x <= binSize.x && size.y <= binSize.y, "[Renderer::DynamicTextureMap] Cannot add an asset that is bigger than ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE")
+        // The areas of removed assets first, so the textures do not fill up with holes
+        for(uint32_t i = 0; i < _bins.size(); i++) {
+            if(AllocateFreeArea(_bins[i]._freeAreas, size, area)) return i;
+        }
+        for(uint32_t i = 0; i < _bins.size(); i++) {
+            if(_bins[i]._skyline.Insert(size, area)) return i;
+        }
+
+        if(_headless) {
+            // Nothing is drawn, so the bin only needs its skyline
+            _bins.emplace_back()._descriptorBinding = 0;
+            _bins.back()._skyline.Insert(size, area);
+            return (uint32_t)(_bins.size() - 1);
+        }
+        // The descriptor sets may still be used by the frames in flight
+        context.WaitIdle();
+        Bin& bin = _bins.emplace_back();
+        bin._texture.Init(context, binSize, VK_FORMAT_R8G8B8A8_SRGB);
+        // Make sure all the pipelines when binding this descriptor return the same DescriptorBindingID
+        bin._descriptorBinding = (*bindToPipelines.begin())->BindTextureDescriptor(context, bin._texture);
+        for(Vulkan::Pipeline* const* p = bindToPipelines.begin()+1; p<bindToPipelines.end(); p++) {
+            if(bin._descriptorBinding!=(*p)->BindTextureDescriptor(context, bin._texture))
+                THROW("[Renderer::DynamicTextureMap] AddTextureLoader should receive pipelines with equal amount of textures and with exclusive acces to the bindings (nothing else should bind textures)")
+        }
+        bin._skyline.Insert(size, area);
+        return (uint32_t)(_bins.size() - 1);
+    }
+    bool DynamicTextureMap::AllocateFreeArea(std::vector<Util::AreaU32>& freeAreas, const Util::Vec2U32 size, Util::AreaU32& area) {
+        // Empty areas are left to the skyline, they do not use any space
+        if(size.x == 0 || size.y == 0) return false;
+        size_t best = SIZE_MAX;
+        for(size_t i = 0; i < freeAreas.size(); i++) {
+            if(freeAreas[i].w < size.x || freeAreas[i].h < size.y) continue;
+            if(best == SIZE_MAX || (uint64_t)freeAreas[i].w*freeAreas[i].h < (uint64_t)freeAreas[best].w*freeAreas[best].h) best = i;
+        }
+        if(best == SIZE_MAX) return false;
+        const Util::AreaU32 free = freeAreas[best];
+        freeAreas.erase(freeAreas.begin() + best);
+        area = Util::AreaU32(free.x, free.y, size.x, size.y);
+        // Split the rest along the longer leftover side, so the biggest piece stays as large as possible
+        const uint32_t right = free.w - size.x;
+        const uint32_t below = free.h - size.y;
+        if(right > below) {
+            if(right) freeAreas.push_back(Util::AreaU32(free.x + size.x, free.y, right, free.h));
+            if(below) freeAreas.push_back(Util::AreaU32(free.x, free.y + size.y, size.x, below));
+        } else {
+            if(below) freeAreas.push_back(Util::AreaU32(free.x, free.y + size.y, free.w, below));
+            if(right) freeAreas.push_back(Util::AreaU32(free.x + size.x, free.y, right, size.y));
+        }
+        return true;
+    }
+
+    std::shared_ptr<uint8_t> DynamicTextureMap::GetRenderInfo(const uint32_t id) {
+        return _entries[id]._renderInfo;
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef ENGINE_RENDERER_DYNAMICTEXTUREMAP_H
+#define ENGINE_RENDERER_DYNAMICTEXTUREMAP_H
+
+#include "core/PCH.h"
+
+#include "renderer/vulkan/Context.h"
+#include "renderer/vulkan/Texture.h"
+#include "renderer/vulkan/Buffers.h"
+#include "renderer/vulkan/CommandBuffer.h"
+#include "renderer/vulkan/Pipeline.h"
+#include "renderer/TextureMap.h"
+#include "renderer/RectanglePacker.h"
+
+// The size of every texture of the dynamic texture map, a new texture is added when the assets do not fit anymore
+#ifndef ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE
+#define ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE Util::Vec2U32(1024, 1024)
+#endif
+
+namespace Engine {
+namespace Renderer {
+
+    /**
+     * @brief A texture map that accepts and removes assets while the game is running
+     * The assets are placed with a skyline per texture, the areas of removed assets are reused by the next assets that fit in them.
+     * Adding an asset renders it immediately into CPU memory, the next Upload copies only the new areas into the textures.
+     * The rendering happens on the calling thread, so adding a big asset (like a font) stalls that frame.
+     * Only adding a texture (when the assets do not fit anymore) waits for the device, as the descriptor sets are changed.
+     */
+    class DynamicTextureMap {
+    public:
+
+        // Without a GPU no textures are created, the assets only get their render info (see Window::InitHeadless)
+        void Init(const uint32_t framesInFlight, const bool headless = false);
+        void Cleanup(Vulkan::Context& context, std::initializer_list<Vulkan::Pipeline*> boundToPipelines);
+
+        // Loads all the textures of the asset loader, the render info can be used immediately and is drawn from the next frame on
+        // The textures are rendered synchronously, use a TextureMap with PrepareAssets on a worker for big assets
+        // The IDs of removed asset loaders are given out again
+        uint32_t AddTextureLoader(Vulkan::Context& context, std::shared_ptr<AssetLoader> assetLoader, std::initializer_list<Vulkan::Pipeline*> bindToPipelines);
+        // Adds a single area that is already rendered, for users that keep track of the render info themselves (like the glyph cache)
+        // The areas have their own IDs, so they never use up the IDs of the asset loaders, textureArea is normalized to the size of the texture
+        uint32_t AddArea(Vulkan::Context& context, const Util::Vec2U32 size, std::vector<Util::AreaU8>&& pixels, std::initializer_list<Vulkan::Pipeline*> bindToPipelines, Util::AreaF& textureArea, uint32_t& boundTexture);
+        // The areas of the asset loader are reused by the next assets, nothing may draw them anymore
+        void Remove(const uint32_t id);
+        // The same as Remove, for an ID returned by AddArea
+        void RemoveArea(const uint32_t id);
+        // Records the copies of the assets added since the last upload, must be called before the render pass of the frame
+        // The staging memory of a frame in flight is reused, so the GPU must be done with the previous use of this frame
+        void Upload(Vulkan::Context& context, Vulkan::CommandBuffer& commandBuffer, const uint32_t frameInFlight);
+
+        std::shared_ptr<uint8_t> GetRenderInfo(const uint32_t id);
+
+    private:
+
+        struct Bin {
+            Bin() : _skyline(ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE) {}
+            Vulkan::Texture _texture;
+            uint32_t _descriptorBinding;
+            RectanglePacker::Skyline _skyline;
+            std::vector<Util::AreaU32> _freeAreas;// The areas of the removed assets
+        };
+        struct PackedArea {
+            uint32_t _bin;
+            Util::AreaU32 _area;
+        };
+        // Waiting to be copied into its bin
+        struct PendingArea {
+            uint32_t _bin;
+            Util::AreaU32 _area;
+            std::vector<Util::AreaU8> _pixels;
+        };
+
+        // An asset loader or a single area
+        struct Entry {
+            std::shared_ptr<uint8_t> _renderInfo;// Reinterpret casted pointer, empty for single areas
+            std::vector<PackedArea> _areas;
+            bool _used = false;
+        };
+
+        // Returns the ID, reuses the IDs of the removed entries
+        static uint32_t AddEntry(std::vector<Entry>& entries, std::vector<uint32_t>& removedIDs, Entry&& entry);
+        void RemoveEntry(std::vector<Entry>& entries, std::vector<uint32_t>& removedIDs, const uint32_t id);
+        // Returns the bin, adds a new one when the size does not fit in any of the bins
+        uint32_t Allocate(Vulkan::Context& context, const Util::Vec2U32 size, Util::AreaU32& area, std::initializer_list<Vulkan::Pipeline*> bindToPipelines);
+        // Takes the smallest free area the size fits in, the rest of the free area stays free
+        static bool AllocateFreeArea(std::vector<Util::AreaU32>& freeAreas, const Util::Vec2U32 size, Util::AreaU32& area);
+
+        std::vector<Bin> _bins;
+        size_t _preparedBins = 0;// The bins before this one are transitioned to the shader read layout
+        std::vector<Entry> _entries;
+        std::vector<uint32_t> _removedIDs;
+        std::vector<Entry> _areas;// Added with AddArea
+        std::vector<uint32_t> _removedAreaIDs;
+        std::vector<PendingArea> _pendingAreas;
+        std::vector<Vulkan::TransferBuffer> _stagingBuffers;// One per frame in flight
+        std::vector<uint32_t> _stagingSizes;// Zero when the staging buffer is not created yet
+        bool _headless = false;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "renderer/GlyphCache.h"
+
+#include "util/Profiler.h"
+
+namespace Engine {
+namespace Renderer {
+
+    GlyphCache::GlyphCache(const std::string file, const uint32_t size, const size_t memoryBudget)
+     : _file(file), _size(size), _memoryBudget(memoryBudget) {
+        // Checked here, the worker thread cannot report it
+        const Util::File font = Util::FileManager::Get(file);
+        ASSERT(font.Exists() && font.IsRegular(), "[Renderer::GlyphCache] GlyphCache received a font file that does not exist '" + font.String() + "'")
+    }
+    GlyphCache::~GlyphCache() {
+        StopWorker();
+    }
+
+    void GlyphCache::Init(Vulkan::Context& context, DynamicTextureMap& textureMap, std::initializer_list<Vulkan::Pipeline*> bindToPipelines) {
+        // Fully inside the glyph everywhere, only the middle is sampled so the linear filter never reaches the neighbouring areas
+        const Util::Vec2U32 placeholderSize = Util::Vec2U32(4, 4);
+        std::vector<Util::AreaU8> pixels((size_t)placeholderSize.x*placeholderSize.y, Util::AreaU8(255));
+        Util::AreaF area;
+        _placeholderArea = textureMap.AddArea(context, placeholderSize, std::move(pixels), bindToPipelines, area, _placeholder._boundTexture);
+        const Util::Vec2U32 binSize = ENGINE_RENDERER_DYNAMIC_TEXTURE_SIZE;
+        _placeholder._textureArea = Util::AreaF(area.x + 1.f/binSize.x, area.y + 1.f/binSize.y, area.w - 2.f/binSize.x, area.h - 2.f/binSize.y);
+        _placeholder._min = Util::Vec2F(0.1f*_size, 0);
+        _placeholder._max = Util::Vec2F(0.5f*_size, 0.7f*_size);
+        _placeholder._leftSideBearing = 0;
+        _placeholder._advance = 0.6f*_size;
+
+        _worker = std::thread([this]() { WorkerLoop(); });
+    }
+    void GlyphCache::Cleanup(DynamicTextureMap& textureMap) {
+        StopWorker();
+        for(const auto& [c, glyph] : _glyphs) {
+            if(glyph._area != UINT32_MAX) textureMap.RemoveArea(glyph._area);
+        }
+        if(_placeholderArea != UINT32_MAX) textureMap.RemoveArea(_placeholderArea);
+        _placeholderArea = UINT32_MAX;
+        _glyphs.clear();
+        _kerning.clear();
+        _leastRecentlyUsed.clear();
+        _queued.clear();
+        _usedMemory = 0;
+    }
+
+    const CharInfo* GlyphCache::GetGlyph(const char32_t c) {
+        auto it = _glyphs.find(c);
+        if(it == _glyphs.end()) {
+            if(_queued.insert(c).second) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _requests.push_back(c);
+                }
+                _wakeWorker.notify_one();
+            }
+            return nullptr;
+        }
+        Glyph& glyph = it->second;
+        glyph._lastLayout = _layout;
+        _leastRecentlyUsed.splice(_leastRecentlyUsed.begin(), _leastRecentlyUsed, glyph._leastRecentlyUsed);
+        return &glyph._info;
+    }
+    int16_t GlyphCache::GetKerning(const char32_t left, const char32_t right) const {
+        if(_kerning.empty()) return 0;
+        auto it = _kerning.find(((uint64_t)left << 32) | right);
+        return it == _kerning.end()? 0 : it->second;
+    }
+
+    bool GlyphCache::Update(Vulkan::Context& context, DynamicTextureMap& textureMap, std::initializer_list<Vulkan::Pipeline*> bindToPipelines) {
+        std::vector<RenderedGlyph> rendered;
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            rendered.swap(_rendered);
+            error = _error;
+        }
+        // The worker cannot throw, its error is thrown on the game thread instead
+        if(error) std::rethrow_exception(error);
+        _changed = !rendered.empty();
+        if(!_changed) return false;
+        ENGINE_PROFILE_SCOPE("GlyphCache::Update")
+
+        for(RenderedGlyph& render : rendered) {
+            _queued.erase(render._character);
+            for(const TextRenderInfo::KerningPair& pair : render._kerning) {
+                _kerning[((uint64_t)pair._left << 32) | pair._right] = pair._kerning;
+            }
+            Glyph glyph;
+            glyph._info = std::move(render._info);
+            glyph._lastLayout = _layout;
+            if(!render._pixels.empty()) {
+                glyph._bytes = render._pixels.size()*sizeof(Util::AreaU8);
+                glyph._area = textureMap.AddArea(context, render._size, std::move(render._pixels), bindToPipelines, glyph._info._textureArea, glyph._info._boundTexture);
+                _usedMemory += glyph._bytes;
+            }
+            _leastRecentlyUsed.push_front(render._character);
+            glyph._leastRecentlyUsed = _leastRecentlyUsed.begin();
+            _glyphs.insert_or_assign(render._character, std::move(glyph));
+        }
+        if(_usedMemory > _memoryBudget) Evict(textureMap);
+        // The text laid out after this update uses the new layout
+        _layout++;
+        return true;
+    }
+    void GlyphCache::Evict(DynamicTextureMap& textureMap) {
+        // Every text was laid out with the current layout or created after it, so older glyphs are not drawn anymore
+        while(_usedMemory > _memoryBudget && !_leastRecentlyUsed.empty()) {
+            const char32_t c = _leastRecentlyUsed.back();
+            Glyph& glyph = _glyphs.at(c);
+            if(glyph._lastLayout >= _layout) break;
+            if(glyph._area != UINT32_MAX) textureMap.RemoveArea(glyph._area);
+            _usedMemory -= glyph._bytes;
+            _leastRecentlyUsed.pop_back();
+            _glyphs.erase(c);
+        }
+        if(_usedMemory > _memoryBudget) INFO("[Renderer::GlyphCache] The glyphs in use need " + std::to_string(_usedMemory) + " bytes, more than the budget of " + std::to_string(_memoryBudget) + " bytes")
+    }
+
+    void GlyphCache::WorkerLoop() {
+        ENGINE_PROFILE_THREAD("Glyph cache")
+        while(true) {
+            std::vector<char32_t> characters;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wakeWorker.wait(lock, [&]() { return _stop || !_requests.empty(); });
+                if(_stop) return;
+                const size_t amount = std::min(_requests.size(), (size_t)ENGINE_RENDERER_GLYPHCACHE_BATCH_SIZE);
+                characters.assign(_requests.begin(), _requests.begin() + amount);
+                _requests.erase(_requests.begin(), _requests.begin() + amount);
+            }
+            std::vector<RenderedGlyph> rendered;
+            try {
+                RenderGlyphs(characters, rendered);
+            } catch(...) {
+                // Stops rendering, the next Update throws the error
+                std::lock_guard<std::mutex> lock(_mutex);
+                if(!_error) _error = std::current_exception();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                for(RenderedGlyph& render : rendered) _rendered.push_back(std::move(render));
+            }
+        }
+    }
+    void GlyphCache::RenderGlyphs(const std::vector<char32_t>& characters, std::vector<RenderedGlyph>& rendered) {
+        ENGINE_PROFILE_SCOPE("GlyphCache::RenderGlyphs")
+        // The same steps as the texture maps take, but every glyph gets its own pixels
+        Characters batch;
+        for(const char32_t c : characters) batch.AddCharacter(c);
+        TextLoader loader(_file, batch, { _size });
+        loader.DisableFontDataCache();
+        loader.Init();
+        std::vector<Util::Vec3U32> sizes(characters.size());
+        // The batches are small, hinting them in parallel costs more than it saves
+        loader.SetTextureSizes(sizes.data(), nullptr);
+        std::shared_ptr<TextRenderInfo> metrics = std::reinterpret_pointer_cast<TextRenderInfo>(loader.GetRenderInfo());
+
+        rendered.resize(characters.size());
+        for(size_t id = 0; id < characters.size(); id++) {
+            RenderedGlyph& render = rendered[id];
+            render._character = characters[id];
+            render._info = *metrics->FindGlyph(0, characters[id]);
+            render._size = Util::Vec2U32(sizes[id].x, sizes[id].y);
+            render._pixels.resize((size_t)render._size.x*render._size.y);
+            for(const TextRenderInfo::KerningPair& pair : metrics->_kerning) {
+                if(pair._right == characters[id]) render._kerning.push_back(pair);
+            }
+            if(render._pixels.empty()) continue;
+            loader.RenderTexture(render._pixels.data(), render._size, Util::AreaU32(0, 0, render._size.x, render._size.y), id);
+        }
+    }
+    void GlyphCache::StopWorker() {
+        if(!_worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wakeWorker.notify_all();
+        _worker.join();
+    }
+
+}
+}
\ No newline at end of file
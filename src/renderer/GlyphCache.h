@@ -0,0 +1,102 @@
+#ifndef ENGINE_RENDERER_GLYPHCACHE_H
+#define ENGINE_RENDERER_GLYPHCACHE_H
+
+#include "core/PCH.h"
+#include <condition_variable>
+#include <list>
+#include <unordered_set>
+
+#include "renderer/DynamicTextureMap.h"
+#include "renderer/TextLoader.h"
+
+// The maximum amount of missing glyphs the worker renders with one parse of the font
+#ifndef ENGINE_RENDERER_GLYPHCACHE_BATCH_SIZE
+#define ENGINE_RENDERER_GLYPHCACHE_BATCH_SIZE 64
+#endif
+
+namespace Engine {
+namespace Renderer {
+
+    /**
+     * @brief The glyphs of one font size, rendered the first time they are needed instead of all up front
+     * A missing glyph is queued for the worker thread of the cache, the next Update places the rendered glyph in the dynamic texture map.
+     * When the glyphs use more memory than the budget, the glyphs that no text used since the previous layout are removed again.
+     * The budget is exceeded when the text on screen needs more, the glyphs in use are never removed.
+     */
+    class GlyphCache {
+    public:
+        GlyphCache(const std::string file, const uint32_t size, const size_t memoryBudget);
+        ~GlyphCache();
+
+        // Adds the placeholder to the texture map and starts the worker
+        void Init(Vulkan::Context& context, DynamicTextureMap& textureMap, std::initializer_list<Vulkan::Pipeline*> bindToPipelines);
+        // Stops the worker and removes all the glyphs from the texture map
+        void Cleanup(DynamicTextureMap& textureMap);
+
+        // Returns nullptr when the glyph is not rendered yet, it is queued then and the placeholder should be drawn in its place
+        // Marks the glyph as used by the text that is being laid out
+        const CharInfo* GetGlyph(const char32_t c);
+        // The kerning of right when it follows left, 0 when one of them is not rendered yet
+        int16_t GetKerning(const char32_t left, const char32_t right) const;
+        // A solid box with the metrics of an average glyph
+        inline const CharInfo& GetPlaceholder() const { return _placeholder; }
+        // Places the glyphs the worker rendered and removes the unused glyphs when over the budget, must be called between frames
+        // Returns true when the text using this cache should be laid out again, throws the error when the worker failed
+        bool Update(Vulkan::Context& context, DynamicTextureMap& textureMap, std::initializer_list<Vulkan::Pipeline*> bindToPipelines);
+        // The result of the last Update
+        inline bool HasChanged() const { return _changed; }
+        inline uint32_t GetSize() const { return _size; }
+        // The bytes the glyphs use in the texture map
+        inline size_t GetUsedMemory() const { return _usedMemory; }
+
+    private:
+        // Rendered by the worker, not in the texture map yet
+        struct RenderedGlyph {
+            char32_t _character;
+            CharInfo _info;
+            Util::Vec2U32 _size;
+            std::vector<Util::AreaU8> _pixels;
+            std::vector<TextRenderInfo::KerningPair> _kerning;// The pairs with the glyphs of the same batch
+        };
+        struct Glyph {
+            CharInfo _info;
+            uint32_t _area = UINT32_MAX;// The area ID in the dynamic texture map (not an asset ID), UINT32_MAX for glyphs without pixels
+            size_t _bytes = 0;
+            uint64_t _lastLayout = 0;
+            std::list<char32_t>::iterator _leastRecentlyUsed;
+        };
+
+        void WorkerLoop();
+        void RenderGlyphs(const std::vector<char32_t>& characters, std::vector<RenderedGlyph>& rendered);
+        void Evict(DynamicTextureMap& textureMap);
+        void StopWorker();
+
+        std::string _file;
+        uint32_t _size;
+        size_t _memoryBudget;
+        size_t _usedMemory = 0;
+
+        CharInfo _placeholder;
+        uint32_t _placeholderArea = UINT32_MAX;
+        std::unordered_map<char32_t, Glyph> _glyphs;
+        std::list<char32_t> _leastRecentlyUsed;// The back is evicted first
+        std::unordered_set<char32_t> _queued;// Requested and not placed yet
+        std::unordered_map<uint64_t, int16_t> _kerning;// The left character in the upper 32 bits
+        // Every Update that changed starts a new layout, glyphs not used since the previous layout are unused
+        uint64_t _layout = 1;
+        bool _changed = false;
+
+        // Shared with the worker
+        std::thread _worker;
+        std::mutex _mutex;
+        std::condition_variable _wakeWorker;
+        bool _stop = false;
+        std::vector<char32_t> _requests;
+        std::vector<RenderedGlyph> _rendered;
+        std::exception_ptr _error;// The first error of the worker, thrown again by Update
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
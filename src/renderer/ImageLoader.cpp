@@ -12,7 +12,7 @@ namespace Renderer {
     size_t ImageLoader::GetAmountTextures() {
         return 1;
     }
-    void ImageLoader::SetTextureSizes(Util::Vec3U32* start) {
+    void ImageLoader::SetTextureSizes(Util::Vec3U32* start, Util::ThreadPool* threadPool) {
         int x, y, n;
         bool success = _file.GetImageInfo(x, y, n);
         ASSERT(success, "[Renderer::ImageLoader] Failed to load image info with the stbi_info function:\n" + _file.GetImageReadingError())
@@ -20,7 +20,6 @@ namespace Renderer {
         *start = Util::Vec3U32(x, y, 0);
     }
     void ImageLoader::RenderTexture(Util::AreaU8* texture, const Util::Vec2U32 textureSize, const Util::AreaU32 area, const size_t id) {
-        _area = area;
         int width, height, channels;
         std::shared_ptr<uint8_t> imageDataPtr = _file.ReadImage(width, height, channels, 4);
         uint8_t* imageData = imageDataPtr.get();
@@ -42,5 +41,12 @@ namespace Renderer {
         return std::reinterpret_pointer_cast<uint8_t>(std::make_shared<ImageRenderInfo>(_area, _descriptorArrayID));
     }
 
+    std::string ImageLoader::GetCacheKey() {
+        return "image:" + _file.String();
+    }
+    std::vector<Util::File> ImageLoader::GetSourceFiles() {
+        return { _file };
+    }
+
 }
 }
\ No newline at end of file
@@ -15,12 +15,15 @@ namespace Renderer {
 
         void Init() override;
         size_t GetAmountTextures() override;
-        void SetTextureSizes(Util::Vec3U32* start) override;
+        void SetTextureSizes(Util::Vec3U32* start, Util::ThreadPool* threadPool) override;
         void RenderTexture(Util::AreaU8* texture, const Util::Vec2U32 textureSize, const Util::AreaU32 area, const size_t id) override;
 
         void SetTextureRenderInfo(const Util::AreaF area, const uint32_t boundTexture, const size_t id) override;
         std::shared_ptr<uint8_t> GetRenderInfo() override;
 
+        std::string GetCacheKey() override;
+        std::vector<Util::File> GetSourceFiles() override;
+
     private:
         
         Util::File _file;
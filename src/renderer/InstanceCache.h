@@ -0,0 +1,229 @@
+#ifndef ENGINE_RENDERER_INSTANCE_CACHE_H
+#define ENGINE_RENDERER_INSTANCE_CACHE_H
+
+#include "core/PCH.h"
+
+#include "renderer/vulkan/Context.h"
+#include "renderer/vulkan/CommandBuffer.h"
+#include "renderer/vulkan/Buffers.h"
+
+// The amount of holes (deleted instances) that are allowed before the instances are compacted
+#ifndef ENGINE_RENDERER_INSTANCE_CACHE_MAX_HOLES
+    #define ENGINE_RENDERER_INSTANCE_CACHE_MAX_HOLES 1024
+#endif
+
+namespace Engine {
+namespace Renderer {
+
+    /**
+     * @brief Keeps the instance data of every entity in a gpu local vertex buffer across frames
+     * Every entity owns a range of instances (a text has one instance per character), which stays at the same place
+     * until the entity is removed. Only the ranges that were set since the previous upload are copied to the GPU.
+     *
+     * Every range keeps the slots it has ever used: shrinking zeroes the unused tail, growing into the reserved slots
+     * stays in place and growing past them shifts the following instances back. Removing an entity zeroes its range
+     * (a zeroed instance has no area and draws nothing), the holes are only compacted when there are more than
+     * ENGINE_RENDERER_INSTANCE_CACHE_MAX_HOLES and they make up half of the buffer.
+     * The instances are always drawn in the order the entities were added.
+     */
+    struct InstanceRange {
+        uint32_t _start;
+        uint32_t _amount;
+    };
+
+    template<class Instance>
+    class InstanceCache {
+    public:
+
+        void Init(const Vulkan::Context& context, const uint32_t capacity) {
+            _capacity = std::max<uint32_t>(capacity, 1);
+            _vkBuffer.Init(context, _capacity * sizeof(Instance), true);
+        }
+        void Cleanup(const Vulkan::Context& context) {
+            _vkBuffer.Cleanup(context);
+        }
+
+        // Drops every instance, the next upload will only contain what is set after this call
+        void Clear() {
+            _instances.clear();
+            _ranges.clear();
+            _dirty.clear();
+            _holes = 0;
+        }
+        /**
+         * @brief Gives the entity amount instances, the entity keeps its place in the draw order when the amount changes
+         *
+         * @return The instances to fill in, valid until the next call to the cache
+         */
+        Instance* Set(const entt::entity entity, const uint32_t amount) {
+            auto [it, inserted] = _ranges.try_emplace(entity, Entry{InstanceRange{(uint32_t)_instances.size(), amount}, amount});
+            Entry& entry = it->second;
+            InstanceRange& range = entry._range;
+            if(inserted) {
+                _instances.resize(_instances.size() + amount);
+            } else if(amount < range._amount) {
+                // The tail stays reserved for the entry
+                memset((void*)(_instances.data() + range._start + amount), 0, (range._amount - amount) * sizeof(Instance));
+                _dirty.push_back(InstanceRange{range._start + amount, range._amount - amount});
+                _holes += range._amount - amount;
+                range._amount = amount;
+            } else if(amount > range._amount) {
+                _holes -= entry._reserved - range._amount;
+                if(amount > entry._reserved) Grow(it, amount);
+                _holes += entry._reserved - amount;
+                range._amount = amount;
+            }
+            if(amount) _dirty.push_back(range);
+            return _instances.data() + range._start;
+        }
+        void Remove(const entt::entity entity) {
+            auto it = _ranges.find(entity);
+            if(it == _ranges.end()) return;
+            Free(it->second);
+            _ranges.erase(it);
+        }
+
+        // The amount of instances to draw, including the holes
+        inline uint32_t GetAmountInstances() const { return (uint32_t)_instances.size(); }
+        // The amount of instances that belong to an entity
+        inline uint32_t GetAmountUsedInstances() const { return (uint32_t)_instances.size() - _holes; }
+        // The instances of the entity, has an amount of 0 when the entity has none
+        inline InstanceRange GetRange(const entt::entity entity) const {
+            auto it = _ranges.find(entity);
+            return it == _ranges.end() ? InstanceRange{0, 0} : it->second._range;
+        }
+        inline const Vulkan::VertexBuffer& GetBuffer() const { return _vkBuffer; }
+        // The instances of a range returned by GetRange, valid until the next Set or Remove
+        // Different ranges can be filled from different threads
+        inline Instance* GetInstances(const InstanceRange range) { return _instances.data() + range._start; }
+
+        /**
+         * @brief Compacts the holes, grows the gpu buffer when needed and merges the ranges that have to be uploaded
+         * Growing waits for the device, as the frames in flight may still read the buffer
+         *
+         * @return The amount of bytes Upload is going to write into the ring buffer
+         */
+        uint32_t PrepareUpload(Vulkan::Context& context) {
+            if(_holes > ENGINE_RENDERER_INSTANCE_CACHE_MAX_HOLES && _holes*2 > _instances.size()) Compact();
+            if(_instances.size() > _capacity) {
+                context.WaitIdle();
+                _capacity = std::bit_ceil((uint32_t)_instances.size());
+                _vkBuffer.Resize(context, _capacity * sizeof(Instance));
+                // The old content is gone
+                _dirty.clear();
+                _dirty.push_back(InstanceRange{0, (uint32_t)_instances.size()});
+            }
+
+            std::sort(_dirty.begin(), _dirty.end(), [](const InstanceRange& a, const InstanceRange& b) { return a._start < b._start; });
+            const uint32_t size = (uint32_t)_instances.size();
+            uint32_t amount = 0;
+            size_t merged = 0;
+            for(size_t i = 0; i < _dirty.size(); i++) {
+                // Ranges at the end may have been cut off by a removal
+                if(_dirty[i]._start >= size) break;
+                _dirty[i]._amount = std::min(_dirty[i]._amount, size - _dirty[i]._start);
+                if(merged && _dirty[merged-1]._start + _dirty[merged-1]._amount >= _dirty[i]._start) {
+                    InstanceRange& previous = _dirty[merged-1];
+                    previous._amount = std::max(previous._start + previous._amount, _dirty[i]._start + _dirty[i]._amount) - previous._start;
+                } else {
+                    _dirty[merged++] = _dirty[i];
+                }
+            }
+            _dirty.resize(merged);
+            for(const InstanceRange& range : _dirty) amount += range._amount;
+            return amount * sizeof(Instance);
+        }
+        /**
+         * @brief Writes the ranges merged by PrepareUpload into the ring buffer and records one batched copy
+         * Must be called outside of a render pass, the barriers around the copy are the responsibility of the caller
+         *
+         * @return If a copy was recorded
+         */
+        bool Upload(Vulkan::CommandBuffer& commandBuffer, Vulkan::RingVertexBuffer& ring) {
+            if(_dirty.empty()) return false;
+            uint32_t amount = 0;
+            for(const InstanceRange& range : _dirty) amount += range._amount;
+            uint32_t offset = ring.Allocate(amount * sizeof(Instance));
+            std::vector<VkBufferCopy> regions;
+            regions.reserve(_dirty.size());
+            for(const InstanceRange& range : _dirty) {
+                memcpy(ring.GetMappedData(offset), _instances.data() + range._start, range._amount * sizeof(Instance));
+                regions.push_back(VkBufferCopy{offset, range._start * sizeof(Instance), range._amount * sizeof(Instance)});
+                offset += range._amount * sizeof(Instance);
+            }
+            ring.CopyTo(commandBuffer, _vkBuffer, regions);
+            _dirty.clear();
+            return true;
+        }
+
+    private:
+        struct Entry {
+            InstanceRange _range;
+            // The slots owned by the entry, at least the amount of its range
+            uint32_t _reserved;
+        };
+
+        void Free(const Entry& entry) {
+            const InstanceRange& range = entry._range;
+            // The unused tail was already counted as a hole
+            _holes -= entry._reserved - range._amount;
+            if(range._start + entry._reserved == _instances.size()) {
+                // Nothing after it, no hole needed
+                _instances.resize(range._start);
+                return;
+            }
+            memset((void*)(_instances.data() + range._start), 0, range._amount * sizeof(Instance));
+            _holes += entry._reserved;
+            if(range._amount) _dirty.push_back(range);
+        }
+        // Inserts slots at the end of the entry, the following entries move back to keep the draw order
+        void Grow(typename std::unordered_map<entt::entity, Entry>::iterator it, const uint32_t amount) {
+            Entry& entry = it->second;
+            const uint32_t end = entry._range._start + entry._reserved;
+            const uint32_t extra = amount - entry._reserved;
+            entry._reserved = amount;
+            if(end == _instances.size()) {
+                _instances.resize(_instances.size() + extra);
+                return;
+            }
+            _instances.insert(_instances.begin() + end, extra, Instance{});
+            for(auto other = _ranges.begin(); other != _ranges.end(); other++) {
+                if(other != it && other->second._range._start >= end) other->second._range._start += extra;
+            }
+            // Dirty ranges of the moved entries point to their old place, everything from the entry on is uploaded again
+            std::erase_if(_dirty, [&](const InstanceRange& range) { return range._start >= entry._range._start; });
+            _dirty.push_back(InstanceRange{entry._range._start, (uint32_t)_instances.size() - entry._range._start});
+        }
+        void Compact() {
+            std::vector<Entry*> order;
+            order.reserve(_ranges.size());
+            for(auto& [entity, entry] : _ranges) order.push_back(&entry);
+            std::sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) { return a->_range._start < b->_range._start; });
+            uint32_t next = 0;
+            for(Entry* entry : order) {
+                InstanceRange& range = entry->_range;
+                if(range._start != next) memmove((void*)(_instances.data() + next), _instances.data() + range._start, range._amount * sizeof(Instance));
+                range._start = next;
+                entry->_reserved = range._amount;
+                next += range._amount;
+            }
+            _instances.resize(next);
+            _holes = 0;
+            _dirty.clear();
+            if(next) _dirty.push_back(InstanceRange{0, next});
+        }
+
+        std::vector<Instance> _instances;
+        std::unordered_map<entt::entity, Entry> _ranges;
+        // Can overlap and contain duplicates until PrepareUpload merges them
+        std::vector<InstanceRange> _dirty;
+        uint32_t _holes = 0;
+
+        Vulkan::VertexBuffer _vkBuffer;
+        uint32_t _capacity = 0;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "renderer/InstanceWriter.h"
+#include "util/Profiler.h"
+
+namespace Engine {
+namespace Renderer {
+
+    CullingStatistics InstanceWriter::Write(entt::registry& registry, const Physics::AABB camera, InstanceDataRect* rectData, const uint32_t amountRectangles, InstanceDataText* textData, const uint32_t amountText) {
+        ENGINE_PROFILE_SCOPE("InstanceWriter::Write")
+        CullingStatistics statistics;
+        WriteRectangles(registry, camera, rectData, amountRectangles, statistics);
+        WriteText(registry, camera, textData, amountText, statistics);
+        return statistics;
+    }
+
+    void InstanceWriter::WriteRectangles(entt::registry& registry, const Physics::AABB camera, InstanceDataRect* output, const uint32_t reserved, CullingStatistics& statistics) {
+        auto group = registry.group<Component::Texture>(entt::get<Component::Position>);
+        ASSERT_IF_DEBUG(group.size() <= reserved, "[Renderer::InstanceWriter] There are more rectangles in the registry than reserved")
+        const size_t count = group.size();
+        if(!_threadPool || count <= ENGINE_RENDERER_INSTANCE_BATCH_SIZE) {
+            for (const auto [entity, texture, pos] : group.each()) {
+                if(!GetBoundingBox(texture, pos).HasOverlap(camera)) {
+                    statistics._culledRectangles++;
+                    continue;
+                }
+                *output++ = GetInstanceData(texture, pos);
+                statistics._visibleRectangles++;
+            }
+            return;
+        }
+
+        const size_t batches = (count + ENGINE_RENDERER_INSTANCE_BATCH_SIZE - 1) / ENGINE_RENDERER_INSTANCE_BATCH_SIZE;
+        auto entities = group.begin();
+        // First pass, offsets[batch+1] becomes the amount of visible instances of the batch
+        std::pmr::vector<uint8_t> visible(count, _frameMemory);
+        std::pmr::vector<uint32_t> offsets(batches + 1, 0, _frameMemory);
+        _threadPool->ParallelFor(count, ENGINE_RENDERER_INSTANCE_BATCH_SIZE, [&](const size_t batch, const size_t begin, const size_t end) {
+            uint32_t amount = 0;
+            for(size_t i = begin; i < end; i++) {
+                auto [texture, pos] = group.get<Component::Texture, Component::Position>(entities[i]);
+                visible[i] = GetBoundingBox(texture, pos).HasOverlap(camera);
+                amount += visible[i];
+            }
+            offsets[batch+1] = amount;
+        });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        // Second pass, every batch writes into its own range
+        _threadPool->ParallelFor(count, ENGINE_RENDERER_INSTANCE_BATCH_SIZE, [&](const size_t batch, const size_t begin, const size_t end) {
+            InstanceDataRect* data = output + offsets[batch];
+            for(size_t i = begin; i < end; i++) {
+                if(!visible[i]) continue;
+                auto [texture, pos] = group.get<Component::Texture, Component::Position>(entities[i]);
+                *data++ = GetInstanceData(texture, pos);
+            }
+        });
+        statistics._visibleRectangles = offsets.back();
+        statistics._culledRectangles = (uint32_t)count - offsets.back();
+    }
+    void InstanceWriter::WriteText(entt::registry& registry, const Physics::AABB camera, InstanceDataText* output, const uint32_t reserved, CullingStatistics& statistics) {
+        auto group = registry.group<Component::Text>(entt::get<Component::Position>);
+        const size_t count = group.size();
+        if(!_threadPool || count <= ENGINE_RENDERER_INSTANCE_BATCH_SIZE) {
+            [[maybe_unused]] const InstanceDataText* outputEnd = output + reserved;
+            for (const auto [entity, text, pos] : group.each()) {
+                const uint32_t characters = (uint32_t)text._renderInfo.size();
+                if(!GetBoundingBox(text, pos).HasOverlap(camera)) {
+                    statistics._culledCharacters += characters;
+                    continue;
+                }
+                ASSERT_IF_DEBUG(output + characters <= outputEnd, "[Renderer::InstanceWriter] There are more characters in the registry than reserved")
+                GetInstanceData(text, pos, output);
+                output += characters;
+                statistics._visibleCharacters += characters;
+            }
+            return;
+        }
+
+        const size_t batches = (count + ENGINE_RENDERER_INSTANCE_BATCH_SIZE - 1) / ENGINE_RENDERER_INSTANCE_BATCH_SIZE;
+        auto entities = group.begin();
+        // First pass, offsets[batch+1] becomes the amount of visible characters of the batch
+        std::pmr::vector<uint8_t> visible(count, _frameMemory);
+        std::pmr::vector<uint32_t> offsets(batches + 1, 0, _frameMemory);
+        std::pmr::vector<uint32_t> culled(batches, 0, _frameMemory);
+        _threadPool->ParallelFor(count, ENGINE_RENDERER_INSTANCE_BATCH_SIZE, [&](const size_t batch, const size_t begin, const size_t end) {
+            uint32_t amount = 0;
+            for(size_t i = begin; i < end; i++) {
+                auto [text, pos] = group.get<Component::Text, Component::Position>(entities[i]);
+                visible[i] = GetBoundingBox(text, pos).HasOverlap(camera);
+                if(visible[i]) amount += (uint32_t)text._renderInfo.size();
+                else culled[batch] += (uint32_t)text._renderInfo.size();
+            }
+            offsets[batch+1] = amount;
+        });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        ASSERT_IF_DEBUG(offsets.back() <= reserved, "[Renderer::InstanceWriter] There are more characters in the registry than reserved")
+        // Second pass, every batch writes into its own range
+        _threadPool->ParallelFor(count, ENGINE_RENDERER_INSTANCE_BATCH_SIZE, [&](const size_t batch, const size_t begin, const size_t end) {
+            InstanceDataText* data = output + offsets[batch];
+            for(size_t i = begin; i < end; i++) {
+                if(!visible[i]) continue;
+                auto [text, pos] = group.get<Component::Text, Component::Position>(entities[i]);
+                GetInstanceData(text, pos, data);
+                data += text._renderInfo.size();
+            }
+        });
+        statistics._visibleCharacters = offsets.back();
+        for(const uint32_t amount : culled) statistics._culledCharacters += amount;
+    }
+
+    void InstanceWriter::Fill(entt::registry& registry, const std::pmr::vector<entt::entity>& entities, InstanceCache<InstanceDataRect>& cache, Physics::AABB* boxes) {
+        ENGINE_PROFILE_SCOPE("InstanceWriter::Fill")
+        for(const entt::entity entity : entities) cache.Set(entity, 1);
+        auto view = registry.view<Component::Texture, Component::Position>();
+        auto write = [&](const size_t batch, const size_t begin, const size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                const auto [texture, pos] = view.get<Component::Texture, Component::Position>(entities[i]);
+                *cache.GetInstances(cache.GetRange(entities[i])) = GetInstanceData(texture, pos);
+                boxes[i] = GetBoundingBox(texture, pos);
+            }
+        };
+        if(!_threadPool || entities.size() <= ENGINE_RENDERER_INSTANCE_BATCH_SIZE) write(0, 0, entities.size());
+        else _threadPool->ParallelFor(entities.size(), ENGINE_RENDERER_INSTANCE_BATCH_SIZE, write);
+    }
+    void InstanceWriter::Fill(entt::registry& registry, const std::pmr::vector<entt::entity>& entities, InstanceCache<InstanceDataText>& cache, Physics::AABB* boxes) {
+        ENGINE_PROFILE_SCOPE("InstanceWriter::Fill")
+        auto view = registry.view<Component::Text, Component::Position>();
+        for(const entt::entity entity : entities) cache.Set(entity, (uint32_t)view.get<Component::Text>(entity)._renderInfo.size());
+        auto write = [&](const size_t batch, const size_t begin, const size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                const auto [text, pos] = view.get<Component::Text, Component::Position>(entities[i]);
+                GetInstanceData(text, pos, cache.GetInstances(cache.GetRange(entities[i])));
+                boxes[i] = GetBoundingBox(text, pos);
+            }
+        };
+        if(!_threadPool || entities.size() <= ENGINE_RENDERER_INSTANCE_BATCH_SIZE) write(0, 0, entities.size());
+        else _threadPool->ParallelFor(entities.size(), ENGINE_RENDERER_INSTANCE_BATCH_SIZE, write);
+    }
+
+    InstanceDataRect InstanceWriter::GetInstanceData(const Component::Texture& texture, const Component::Position& pos) {
+        return InstanceDataRect(
+            pos._pos,
+            texture._size * 0.5f,
+            pos._rotation,
+            Util::Vec3F(1.f, 1.f, 1.f),
+            texture._textureArea,
+            texture._descriptorID
+        );
+    }
+    void InstanceWriter::GetInstanceData(const Component::Text& text, const Component::Position& pos, InstanceDataText* output) {
+        for(const Component::Text::CharRenderInfo& renderInfo : text._renderInfo) {
+            *output++ = InstanceDataText(
+                Util::Vec2F(pos._pos.x + renderInfo._position.x, pos._pos.y + renderInfo._position.y),
+                Util::Vec2F(renderInfo._position.w , renderInfo._position.h),
+                Util::Vec3F(1.f, 1.f, 1.f),
+                Util::Vec2F(renderInfo._textureArea.x, renderInfo._textureArea.y),
+                Util::Vec2F(renderInfo._textureArea.w, renderInfo._textureArea.h),
+                renderInfo._descriptorID,
+                renderInfo._pxRange
+            );
+        }
+    }
+    Physics::AABB InstanceWriter::GetBoundingBox(const Component::Texture& texture, const Component::Position& pos) {
+        // The half extents of the rotated rectangle, without rotating every corner
+        const float cos = std::abs(std::cos(pos._rotation));
+        const float sin = std::abs(std::sin(pos._rotation));
+        const Util::Vec2F extents(
+            0.5f * (cos*texture._size.x + sin*texture._size.y),
+            0.5f * (sin*texture._size.x + cos*texture._size.y)
+        );
+        return Physics::AABB::FromCorners(pos._pos - extents, pos._pos + extents);
+    }
+    Physics::AABB InstanceWriter::GetBoundingBox(const Component::Text& text, const Component::Position& pos) {
+        if(text._renderInfo.empty()) return Physics::AABB::FromCorners(pos._pos, pos._pos);
+        Util::Vec2F topLeft(std::numeric_limits<float>::max());
+        Util::Vec2F bottomRight(std::numeric_limits<float>::lowest());
+        for(const Component::Text::CharRenderInfo& renderInfo : text._renderInfo) {
+            topLeft = Util::Vec2F(std::min(topLeft.x, renderInfo._position.x), std::min(topLeft.y, renderInfo._position.y));
+            bottomRight = Util::Vec2F(std::max(bottomRight.x, renderInfo._position.x + renderInfo._position.w), std::max(bottomRight.y, renderInfo._position.y + renderInfo._position.h));
+        }
+        return Physics::AABB::FromCorners(pos._pos + topLeft, pos._pos + bottomRight);
+    }
+
+    void InstanceWriter::Benchmark(Util::ThreadPool& threadPool) {
+        InstanceWriter singleThreaded;
+        InstanceWriter multiThreaded(std::pmr::get_default_resource(), &threadPool);
+        // The camera sees a quarter of the world, so the culling is part of the measurement
+        const Physics::AABB camera = Physics::AABB::FromCorners(Util::Vec2F(-2500.f), Util::Vec2F(2500.f));
+        for(const uint32_t amount : {10'000u, 100'000u, 1'000'000u}) {
+            entt::registry registry;
+            std::mt19937 random(amount);
+            std::uniform_real_distribution<float> position(-5000.f, 5000.f);
+            std::uniform_real_distribution<float> rotation(0.f, 6.28f);
+            for(uint32_t i = 0; i < amount; i++) {
+                const entt::entity entity = registry.create();
+                registry.emplace<Component::Position>(entity, Util::Vec2F(position(random), position(random)), rotation(random));
+                Component::Texture& texture = registry.emplace<Component::Texture>(entity);
+                texture._textureArea = Util::AreaF(0.f, 0.f, 32.f, 32.f);
+                texture._descriptorID = 0;
+                texture._size = Util::Vec2F(32.f);
+            }
+            std::vector<InstanceDataRect> output(amount);
+            // The fastest of a couple of runs, the first run also creates the group
+            auto measure = [&](InstanceWriter& writer) {
+                double fastest = std::numeric_limits<double>::max();
+                for(int run = 0; run < 5; run++) {
+                    const auto start = std::chrono::steady_clock::now();
+                    writer.Write(registry, camera, output.data(), amount, nullptr, 0);
+                    fastest = std::min(fastest, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                }
+                return fastest;
+            };
+            const double single = measure(singleThreaded);
+            const double multi = measure(multiThreaded);
+            LOG("[Renderer::InstanceWriter] " + std::to_string(amount) + " sprites: " + std::to_string(single) + "ms on 1 thread, "
+                + std::to_string(multi) + "ms on " + std::to_string(threadPool.GetAmountThreads()) + " threads")
+        }
+    }
+
+}
+}
\ No newline at end of file
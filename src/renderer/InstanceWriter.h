@@ -0,0 +1,115 @@
+#ifndef ENGINE_RENDERER_INSTANCE_WRITER_H
+#define ENGINE_RENDERER_INSTANCE_WRITER_H
+
+#include "core/PCH.h"
+#include "core/Components.h"
+#include "physics/AABB.h"
+#include "renderer/InstanceCache.h"
+#include "util/ThreadPool.h"
+
+// The amount of entities one worker handles at once, registries with fewer entities are written on the calling thread
+#ifndef ENGINE_RENDERER_INSTANCE_BATCH_SIZE
+    #define ENGINE_RENDERER_INSTANCE_BATCH_SIZE 4096
+#endif
+
+namespace Engine {
+namespace Renderer {
+
+    // The corners and the rotation are calculated in rect.vert, the color is RGBA8 and the texture area is unorm16
+    struct InstanceDataRect {
+        InstanceDataRect() = default;
+        InstanceDataRect(const Util::Vec2F position, const Util::Vec2F halfSize, const float rotation, const Util::Vec3F color, const Util::AreaF textureArea, const uint32_t texture)
+         : position(position), halfSize(halfSize), rotation(rotation), texture(texture) {
+            this->color[0] = PackUNorm8(color.x);
+            this->color[1] = PackUNorm8(color.y);
+            this->color[2] = PackUNorm8(color.z);
+            this->color[3] = 255;
+            this->textureArea[0] = PackUNorm16(textureArea.x);
+            this->textureArea[1] = PackUNorm16(textureArea.y);
+            this->textureArea[2] = PackUNorm16(textureArea.w);
+            this->textureArea[3] = PackUNorm16(textureArea.h);
+        }
+        Util::Vec2F position;
+        Util::Vec2F halfSize;
+        float rotation;
+        uint8_t color[4];
+        uint16_t textureArea[4];// x, y, w, h
+        uint32_t texture;
+
+    private:
+        static inline uint8_t PackUNorm8(const float value) { return (uint8_t)std::lround(std::clamp(value, 0.f, 1.f) * 255.f); }
+        static inline uint16_t PackUNorm16(const float value) { return (uint16_t)std::lround(std::clamp(value, 0.f, 1.f) * 65535.f); }
+    };
+    // Must match the vertex input of the rect pipeline
+    static_assert(sizeof(InstanceDataRect) == 36);
+    struct InstanceDataText {
+        InstanceDataText() = default;
+        InstanceDataText(const Util::Vec2F pos, const Util::Vec2F dimensions, const Util::Vec3F color, const Util::Vec2F texturePos, const Util::Vec2F textureDimensions, const uint32_t texture, const float pxRange)
+         : pos(pos), dimensions(dimensions), color(color), texturePos(texturePos), textureDimensions(textureDimensions), texture(texture), pxRange(pxRange) {}
+        Util::Vec2F pos;
+        Util::Vec2F dimensions;
+        Util::Vec3F color;
+        Util::Vec2F texturePos;
+        Util::Vec2F textureDimensions;
+        uint32_t texture;
+        float pxRange;
+    };
+
+    // The amount of instances that were drawn and left out the previous frame
+    struct CullingStatistics {
+        uint32_t _visibleRectangles = 0;
+        uint32_t _culledRectangles = 0;
+        uint32_t _visibleCharacters = 0;
+        uint32_t _culledCharacters = 0;
+    };
+
+    /**
+     * @brief Turns the textures and texts of a registry into instance data
+     * With a thread pool large registries are split into batches. A first pass culls every batch and counts its instances,
+     * after which every batch writes its instances into its own range of the output. The output order is the same as
+     * when written on one thread. Fill does the same for the retained instance caches when they are rebuilt.
+     */
+    class InstanceWriter {
+    public:
+        // The frame memory is only used from the calling thread, the workers only write into what it allocated
+        InstanceWriter(std::pmr::memory_resource* frameMemory = std::pmr::get_default_resource(), Util::ThreadPool* threadPool = nullptr)
+         : _frameMemory(frameMemory), _threadPool(threadPool) {}
+
+        /**
+         * @brief Writes the instances inside the camera, packed at the start of the outputs
+         *
+         * @param amountRectangles The amount of instances rectData has room for
+         * @param amountText The amount of instances textData has room for
+         * @return The amount of written and culled instances
+         */
+        CullingStatistics Write(entt::registry& registry, const Physics::AABB camera, InstanceDataRect* rectData, const uint32_t amountRectangles, InstanceDataText* textData, const uint32_t amountText);
+        /**
+         * @brief Adds the entities to the cache in the given order and writes their instances (without culling) on the thread pool
+         * Used to fill an empty cache, the ranges are given out on the calling thread so the cache keeps the order of the entities
+         *
+         * @param boxes Receives the bounding box of every entity, at the same index
+         */
+        void Fill(entt::registry& registry, const std::pmr::vector<entt::entity>& entities, InstanceCache<InstanceDataRect>& cache, Physics::AABB* boxes);
+        void Fill(entt::registry& registry, const std::pmr::vector<entt::entity>& entities, InstanceCache<InstanceDataText>& cache, Physics::AABB* boxes);
+
+        static InstanceDataRect GetInstanceData(const Component::Texture& texture, const Component::Position& pos);
+        // Writes one instance per character
+        static void GetInstanceData(const Component::Text& text, const Component::Position& pos, InstanceDataText* output);
+        static Physics::AABB GetBoundingBox(const Component::Texture& texture, const Component::Position& pos);
+        static Physics::AABB GetBoundingBox(const Component::Text& text, const Component::Position& pos);
+
+        // Logs how long writing 10k up to 1M sprites takes on one thread and on the thread pool
+        static void Benchmark(Util::ThreadPool& threadPool);
+
+    private:
+        void WriteRectangles(entt::registry& registry, const Physics::AABB camera, InstanceDataRect* output, const uint32_t reserved, CullingStatistics& statistics);
+        void WriteText(entt::registry& registry, const Physics::AABB camera, InstanceDataText* output, const uint32_t reserved, CullingStatistics& statistics);
+
+        std::pmr::memory_resource* _frameMemory;
+        Util::ThreadPool* _threadPool;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -12,20 +12,63 @@ namespace Renderer {
         }
         // Sort the rectangles
         switch(_sortingAlgorithm) {
-            case SortingAlgorithm::SmallWidthFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.x < second.x; });
-            case SortingAlgorithm::BigWidthFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.x > second.x; });
-            case SortingAlgorithm::SmallHeightFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.y < second.y; });
-            case SortingAlgorithm::BigHeightFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.y > second.y; });
+            case SortingAlgorithm::SmallWidthFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.x < second.x; }); break;
+            case SortingAlgorithm::BigWidthFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.x > second.x; }); break;
+            case SortingAlgorithm::SmallHeightFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.y < second.y; }); break;
+            case SortingAlgorithm::BigHeightFirst: std::sort(_sizes.begin(), _sizes.end(), [](const auto& first, const auto& second) { return first.y > second.y; }); break;
             default: break;
         }
         // Pack them
         _result.resize(_sizes.size());
-        switch(_packingAlgorithm) {
+        _statistics.clear();
+        if(_packingAlgorithm != PackingAlgorithm::Automatic) {
+            PackWith(_packingAlgorithm);
+            return;
+        }
+        std::vector<ResultArea> bestResult;
+        std::vector<Util::Vec2U32> bestBinSizes;
+        for(const PackingAlgorithm algorithm : { PackingAlgorithm::Shelf, PackingAlgorithm::Skyline, PackingAlgorithm::MaxRects }) {
+            PackWith(algorithm);
+            const Statistics& current = _statistics.back();
+            if(_statistics.size() > 1) {
+                const Statistics& best = *std::min_element(_statistics.begin(), _statistics.end() - 1, [](const Statistics& a, const Statistics& b) {
+                    return a._amountBins < b._amountBins || (a._amountBins == b._amountBins && a._occupancy > b._occupancy);
+                });
+                if(current._amountBins > best._amountBins || (current._amountBins == best._amountBins && current._occupancy <= best._occupancy)) continue;
+            }
+            bestResult = _result;
+            bestBinSizes = _binSizes;
+        }
+        _result = std::move(bestResult);
+        _binSizes = std::move(bestBinSizes);
+    }
+    void RectanglePacker::PackWith(const PackingAlgorithm packingAlgorithm) {
+        _binSizes.clear();
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        switch(packingAlgorithm) {
             case PackingAlgorithm::Shelf: PackShelf(); break;
             case PackingAlgorithm::Skyline: PackSkyline(); break;
             case PackingAlgorithm::MaxRects: PackMaxRects(); break;
             default: THROW("[Renderer::RectanglePacker] No packing algorithm specified for RectanglePacker");
         }
+        const float packTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        _statistics.push_back(Statistics{packingAlgorithm, _binSizes.size(), GetOccupancy(), packTime});
+    }
+    float RectanglePacker::GetOccupancy() const {
+        uint64_t used = 0;
+        uint64_t total = 0;
+        for(const Util::Vec3U32& size : _sizes) used += (uint64_t)size.x * size.y;
+        for(const Util::Vec2U32& size : _binSizes) total += (uint64_t)size.x * size.y;
+        return total == 0 ? 1.f : (float)used / total;
+    }
+    const char* RectanglePacker::GetName(const PackingAlgorithm packingAlgorithm) {
+        switch(packingAlgorithm) {
+            case PackingAlgorithm::Shelf: return "shelf";
+            case PackingAlgorithm::Skyline: return "skyline";
+            case PackingAlgorithm::MaxRects: return "maxrects";
+            case PackingAlgorithm::Automatic: return "automatic";
+        }
+        return "unknown";
     }
 
     void RectanglePacker::PackShelf() {
@@ -35,12 +78,14 @@ namespace Renderer {
         uint32_t binWidth = 0;
         uint32_t bin = 0;
         for(const auto rect : _sizes) {
+            if(rect.x > _maxBinSize.x || rect.y > _maxBinSize.y) THROW("[Renderer::RectanglePacker] Cannot pack rectangles that are bigger then the maximum bin size")
             if(x + rect.x > _maxBinSize.x) {
                 if(y + rowHeight + rect.y > _maxBinSize.y) {
                     _binSizes.push_back(Util::Vec2U32(binWidth, y+rowHeight));
                     // Start a new bin
                     y = 0;
                     x = 0;
+                    binWidth = 0;
                     rowHeight = rect.y;
                     bin++;
                 } else {
@@ -58,11 +103,148 @@ namespace Renderer {
         _binSizes.push_back(Util::Vec2U32(binWidth, y+rowHeight));
     }
     void RectanglePacker::PackSkyline() {
-        THROW("[Renderer::RectanglePacker] Sorry, skyline packing is not implemented yet");
+        std::vector<Skyline> bins;
+        std::vector<Util::Vec2U32> used;
+        for(const auto rect : _sizes) {
+            uint32_t bin = 0;
+            Util::AreaU32 area;
+            // The first bin it fits in, the earlier bins are filled up with the smaller rectangles
+            for(; bin < bins.size(); bin++) {
+                if(bins[bin].Insert(Util::Vec2U32(rect.x, rect.y), area)) break;
+            }
+            if(bin == bins.size()) {
+                bins.emplace_back(_maxBinSize);
+                used.push_back(Util::Vec2U32(0, 0));
+                if(!bins[bin].Insert(Util::Vec2U32(rect.x, rect.y), area))
+                    THROW("[Renderer::RectanglePacker] Cannot pack rectangles that are bigger then the maximum bin size")
+            }
+            _result[rect.z] = ResultArea(bin, area, rect.z);
+            used[bin] = Util::Vec2U32(std::max(used[bin].x, area.x + area.w), std::max(used[bin].y, area.y + area.h));
+        }
+        _binSizes.insert(_binSizes.end(), used.begin(), used.end());
     }
-    void RectanglePacker::PackMaxRects() {
-        THROW("[Renderer::RectanglePacker] Sorry, maxrects packing is not implemented yet");
+    bool RectanglePacker::Skyline::Insert(const Util::Vec2U32 size, Util::AreaU32& area) {
+        uint32_t x = 0, y = 0;
+        const size_t segment = FindPosition(size, x, y);
+        if(segment == SIZE_MAX) return false;
+        area = Util::AreaU32(x, y, size.x, size.y);
+        if(size.x > 0 && size.y > 0) AddLevel(segment, area);
+        return true;
+    }
+    size_t RectanglePacker::Skyline::FindPosition(const Util::Vec2U32 size, uint32_t& bestX, uint32_t& bestY) const {
+        size_t bestSegment = SIZE_MAX;
+        uint32_t bestBottom = UINT32_MAX;
+        for(size_t i = 0; i < _segments.size(); i++) {
+            const uint32_t x = _segments[i]._x;
+            if(x + size.x > _size.x) break;
+            // Rests on the highest segment below it
+            uint32_t y = 0;
+            uint32_t covered = 0;
+            for(size_t j = i; j < _segments.size() && (covered < size.x || j == i); j++) {
+                y = std::max(y, _segments[j]._y);
+                covered += _segments[j]._width;
+            }
+            if(y + size.y > _size.y) continue;
+            if(y + size.y < bestBottom) {
+                bestBottom = y + size.y;
+                bestX = x;
+                bestY = y;
+                bestSegment = i;
+            }
+        }
+        return bestSegment;
+    }
+    void RectanglePacker::Skyline::AddLevel(const size_t segment, const Util::AreaU32 area) {
+        _segments.insert(_segments.begin() + segment, Segment{area.x, area.y + area.h, area.w});
+        // Remove or shorten the segments below the new one
+        const uint32_t end = area.x + area.w;
+        for(size_t i = segment + 1; i < _segments.size();) {
+            if(_segments[i]._x >= end) break;
+            const uint32_t segmentEnd = _segments[i]._x + _segments[i]._width;
+            if(segmentEnd <= end) {
+                _segments.erase(_segments.begin() + i);
+                continue;
+            }
+            _segments[i]._width = segmentEnd - end;
+            _segments[i]._x = end;
+            break;
+        }
+        // Merge the neighbours with the same height
+        for(size_t i = 0; i + 1 < _segments.size();) {
+            if(_segments[i]._y == _segments[i+1]._y) {
+                _segments[i]._width += _segments[i+1]._width;
+                _segments.erase(_segments.begin() + i + 1);
+            } else i++;
+        }
     }
 
+    void RectanglePacker::PackMaxRects() {
+        std::vector<std::vector<Util::AreaU32>> freeRects;
+        std::vector<Util::Vec2U32> used;
+        for(const auto rect : _sizes) {
+            uint32_t bin = 0;
+            size_t freeRect = SIZE_MAX;
+            for(; bin < freeRects.size(); bin++) {
+                freeRect = FindMaxRectsPosition(freeRects[bin], rect);
+                if(freeRect != SIZE_MAX) break;
+            }
+            if(bin == freeRects.size()) {
+                freeRects.push_back({ Util::AreaU32(0, 0, _maxBinSize.x, _maxBinSize.y) });
+                used.push_back(Util::Vec2U32(0, 0));
+                freeRect = FindMaxRectsPosition(freeRects[bin], rect);
+                if(freeRect == SIZE_MAX) THROW("[Renderer::RectanglePacker] Cannot pack rectangles that are bigger then the maximum bin size")
+            }
+            const Util::AreaU32 area(freeRects[bin][freeRect].x, freeRects[bin][freeRect].y, rect.x, rect.y);
+            if(rect.x > 0 && rect.y > 0) SplitFreeRects(freeRects[bin], area);
+            _result[rect.z] = ResultArea(bin, area, rect.z);
+            used[bin] = Util::Vec2U32(std::max(used[bin].x, area.x + area.w), std::max(used[bin].y, area.y + area.h));
+        }
+        _binSizes.insert(_binSizes.end(), used.begin(), used.end());
+    }
+    size_t RectanglePacker::FindMaxRectsPosition(const std::vector<Util::AreaU32>& freeRects, const Util::Vec3U32 rect) {
+        size_t best = SIZE_MAX;
+        uint32_t bestShortSide = UINT32_MAX;
+        uint32_t bestLongSide = UINT32_MAX;
+        for(size_t i = 0; i < freeRects.size(); i++) {
+            const Util::AreaU32& free = freeRects[i];
+            if(free.w < rect.x || free.h < rect.y) continue;
+            const uint32_t shortSide = std::min(free.w - rect.x, free.h - rect.y);
+            const uint32_t longSide = std::max(free.w - rect.x, free.h - rect.y);
+            if(shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
+                best = i;
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+            }
+        }
+        return best;
+    }
+    void RectanglePacker::SplitFreeRects(std::vector<Util::AreaU32>& freeRects, const Util::AreaU32 used) {
+        std::vector<Util::AreaU32> split;
+        split.reserve(freeRects.size() + 4);
+        for(const Util::AreaU32& free : freeRects) {
+            if(used.x >= free.x + free.w || used.x + used.w <= free.x || used.y >= free.y + free.h || used.y + used.h <= free.y) {
+                split.push_back(free);
+                continue;
+            }
+            // The (overlapping) maximal rectangles left, right, above and below the used area
+            if(used.x > free.x) split.push_back(Util::AreaU32(free.x, free.y, used.x - free.x, free.h));
+            if(used.x + used.w < free.x + free.w) split.push_back(Util::AreaU32(used.x + used.w, free.y, free.x + free.w - used.x - used.w, free.h));
+            if(used.y > free.y) split.push_back(Util::AreaU32(free.x, free.y, free.w, used.y - free.y));
+            if(used.y + used.h < free.y + free.h) split.push_back(Util::AreaU32(free.x, used.y + used.h, free.w, free.y + free.h - used.y - used.h));
+        }
+        // Remove the rectangles that are inside another one, of two equal rectangles the first is kept
+        auto contains = [](const Util::AreaU32& a, const Util::AreaU32& b) {
+            return b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+        };
+        freeRects.clear();
+        for(size_t i = 0; i < split.size(); i++) {
+            bool redundant = false;
+            for(size_t j = 0; j < split.size() && !redundant; j++) {
+                if(i == j || !contains(split[j], split[i])) continue;
+                redundant = !contains(split[i], split[j]) || j < i;
+            }
+            if(!redundant) freeRects.push_back(split[i]);
+        }
+    }
 }
 }
\ No newline at end of file
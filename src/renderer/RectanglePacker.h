@@ -23,9 +23,11 @@ namespace Renderer {
         void SetSortingAlgorithm(const SortingAlgorithm sortingAlgorithm) { _sortingAlgorithm = sortingAlgorithm; }
         enum class PackingAlgorithm {
             Shelf,
-            Skyline,
-            MaxRects
+            Skyline,// Bottom left
+            MaxRects,// Best short side fit
+            Automatic// Tries all the above and keeps the one with the least bins, or the least unused area when equal
         };
+        static const char* GetName(const PackingAlgorithm packingAlgorithm);
         void SetPackingAlgorithm(const PackingAlgorithm packingAlgorithm) { _packingAlgorithm = packingAlgorithm; }
         void SetMaximumBinSize(const Util::Vec2U32 size) { _maxBinSize = size; }
 
@@ -47,12 +49,51 @@ namespace Renderer {
         size_t GetAmountResults() { return _result.size(); }
         Util::Vec2U32* GetBinSizes() { return _binSizes.data(); }
         size_t GetAmountBins() { return _binSizes.size(); }
+        // The area of the rectangles divided by the area of the bins
+        float GetOccupancy() const;
+
+        struct Statistics {
+            PackingAlgorithm _algorithm;
+            size_t _amountBins;
+            float _occupancy;
+            float _packTime;// In milliseconds
+        };
+        // One entry per algorithm tried by the last Pack, more than one when the packing algorithm is automatic
+        const std::vector<Statistics>& GetStatistics() const { return _statistics; }
+
+        // The skyline of one bin, rectangles are placed as low as possible (and then as far left as possible)
+        class Skyline {
+        public:
+            Skyline(const Util::Vec2U32 size) : _size(size), _segments{ Segment{0, 0, size.x} } {}
+            // Returns false when the rectangle does not fit anymore, area is only set when it fits
+            bool Insert(const Util::Vec2U32 size, Util::AreaU32& area);
+
+        private:
+            struct Segment {
+                uint32_t _x;
+                uint32_t _y;// The first free y
+                uint32_t _width;
+            };
+            // Returns the segment the rectangle starts at with the lowest bottom edge, SIZE_MAX if it does not fit
+            size_t FindPosition(const Util::Vec2U32 size, uint32_t& x, uint32_t& y) const;
+            void AddLevel(const size_t segment, const Util::AreaU32 area);
+
+            Util::Vec2U32 _size;
+            std::vector<Segment> _segments;
+        };
 
     private:
 
+        // Packs all the rectangles with the algorithm and adds its statistics
+        void PackWith(const PackingAlgorithm packingAlgorithm);
         void PackShelf();
         void PackSkyline();
         void PackMaxRects();
+
+        // Returns the free rectangle with the smallest leftover on the short side, SIZE_MAX if it does not fit
+        static size_t FindMaxRectsPosition(const std::vector<Util::AreaU32>& freeRects, const Util::Vec3U32 rect);
+        // Splits every free rectangle that overlaps the used area and removes the free rectangles inside another
+        static void SplitFreeRects(std::vector<Util::AreaU32>& freeRects, const Util::AreaU32 used);
         
         std::vector<Util::Vec3U32> _sizes; // x=width, y=height, z=index at time of insertion by user
         SortingAlgorithm _sortingAlgorithm = SortingAlgorithm::None;
@@ -61,6 +102,7 @@ namespace Renderer {
 
         std::vector<ResultArea> _result;
         std::vector<Util::Vec2U32> _binSizes;
+        std::vector<Statistics> _statistics;
 
     };
 
@@ -0,0 +1,54 @@
+#include "renderer/SpatialGrid.h"
+
+namespace Engine {
+namespace Renderer {
+
+    void SpatialGrid::Set(const entt::entity entity, const Physics::AABB aabb) {
+        const CellRange range = GetCellRange(aabb);
+        auto [it, inserted] = _entries.try_emplace(entity, Entry{aabb, range});
+        if(inserted) {
+            AddToCells(entity, range);
+            return;
+        }
+        it->second._aabb = aabb;
+        if(it->second._cells == range) return;// Still in the same cells
+        RemoveFromCells(entity, it->second._cells);
+        AddToCells(entity, range);
+        it->second._cells = range;
+    }
+    void SpatialGrid::Remove(const entt::entity entity) {
+        auto it = _entries.find(entity);
+        if(it == _entries.end()) return;
+        RemoveFromCells(entity, it->second._cells);
+        _entries.erase(it);
+    }
+    void SpatialGrid::Clear() {
+        _cells.clear();
+        _entries.clear();
+    }
+
+    void SpatialGrid::AddToCells(const entt::entity entity, const CellRange range) {
+        for(int32_t y = range._minY; y <= range._maxY; y++) {
+            for(int32_t x = range._minX; x <= range._maxX; x++) {
+                _cells[GetCellKey(x, y)].push_back(entity);
+            }
+        }
+    }
+    void SpatialGrid::RemoveFromCells(const entt::entity entity, const CellRange range) {
+        for(int32_t y = range._minY; y <= range._maxY; y++) {
+            for(int32_t x = range._minX; x <= range._maxX; x++) {
+                auto cell = _cells.find(GetCellKey(x, y));
+                if(cell == _cells.end()) continue;
+                std::vector<entt::entity>& entities = cell->second;
+                auto it = std::find(entities.begin(), entities.end(), entity);
+                if(it == entities.end()) continue;
+                // The order within a cell does not matter
+                *it = entities.back();
+                entities.pop_back();
+                if(entities.empty()) _cells.erase(cell);
+            }
+        }
+    }
+
+}
+}
\ No newline at end of file
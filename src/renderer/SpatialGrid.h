@@ -0,0 +1,85 @@
+#ifndef ENGINE_RENDERER_SPATIAL_GRID_H
+#define ENGINE_RENDERER_SPATIAL_GRID_H
+
+#include "core/PCH.h"
+#include "physics/AABB.h"
+
+// The width and height in pixels of one cell of the culling grid
+#ifndef ENGINE_RENDERER_CULLING_CELL_SIZE
+    #define ENGINE_RENDERER_CULLING_CELL_SIZE 256
+#endif
+
+namespace Engine {
+namespace Renderer {
+
+    /**
+     * @brief A uniform grid of entities, used to find the entities that are inside the camera
+     * Every entity is stored in all the cells its bounding box touches. Unlike the physics quadtree the
+     * world has no bounds and moving an entity only touches the grid when it enters another cell.
+     */
+    class SpatialGrid {
+    public:
+        SpatialGrid(const float cellSize = ENGINE_RENDERER_CULLING_CELL_SIZE) : _cellSize(cellSize) {}
+
+        // Inserts the entity or moves it to the new bounding box
+        void Set(const entt::entity entity, const Physics::AABB aabb);
+        void Remove(const entt::entity entity);
+        void Clear();
+
+        inline size_t GetAmountEntities() const { return _entries.size(); }
+        // Appends every entity with a bounding box that overlaps the area (once), in no particular order
+        template<class Allocator>
+        void Query(const Physics::AABB area, std::vector<entt::entity, Allocator>& result) {
+            const CellRange range = GetCellRange(area);
+            _queryID++;
+            for(int32_t y = range._minY; y <= range._maxY; y++) {
+                for(int32_t x = range._minX; x <= range._maxX; x++) {
+                    auto cell = _cells.find(GetCellKey(x, y));
+                    if(cell == _cells.end()) continue;
+                    for(const entt::entity entity : cell->second) {
+                        Entry& entry = _entries[entity];
+                        // Already added by another cell
+                        if(entry._queryID == _queryID) continue;
+                        entry._queryID = _queryID;
+                        if(entry._aabb.HasOverlap(area)) result.push_back(entity);
+                    }
+                }
+            }
+        }
+
+    private:
+        struct CellRange {
+            int32_t _minX, _minY, _maxX, _maxY;
+
+            inline bool operator==(const CellRange& other) const {
+                return _minX == other._minX && _minY == other._minY && _maxX == other._maxX && _maxY == other._maxY;
+            }
+        };
+        struct Entry {
+            Physics::AABB _aabb;
+            CellRange _cells;
+            uint32_t _queryID = 0;
+        };
+
+        inline CellRange GetCellRange(const Physics::AABB aabb) const {
+            return CellRange{
+                (int32_t)std::floor(aabb._topLeft.x / _cellSize), (int32_t)std::floor(aabb._topLeft.y / _cellSize),
+                (int32_t)std::floor(aabb._bottomRight.x / _cellSize), (int32_t)std::floor(aabb._bottomRight.y / _cellSize)
+            };
+        }
+        static inline uint64_t GetCellKey(const int32_t x, const int32_t y) {
+            return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+        }
+        void AddToCells(const entt::entity entity, const CellRange range);
+        void RemoveFromCells(const entt::entity entity, const CellRange range);
+
+        float _cellSize;
+        std::unordered_map<uint64_t, std::vector<entt::entity>> _cells;
+        std::unordered_map<entt::entity, Entry> _entries;
+        uint32_t _queryID = 0;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "renderer/TextLayout.h"
+
+#include "util/Profiler.h"
+
+namespace Engine {
+namespace Renderer {
+
+    TextAssetGlyphs::TextAssetGlyphs(const uint32_t asset, std::shared_ptr<TextRenderInfo> info, const uint32_t size)
+     : _asset(asset), _info(info), _size(size) {
+        _sizeIndex = _info? _info->GetSizeIndex(size) : UINT32_MAX;
+        ASSERT(_sizeIndex != UINT32_MAX, "[Renderer::TextAssetGlyphs] Text size is not loaded, cannot lay out text of a size that is not loaded")
+    }
+
+    void TextLayout::Layout(GlyphSource& glyphs, const std::u32string& previousText, const std::u32string& text, const Component::TextOptions& options, const bool emitEmpty, std::vector<Component::Text::CharRenderInfo>& renderInfo) {
+        ENGINE_PROFILE_SCOPE("TextLayout::Layout")
+        const uint64_t font = glyphs.GetFontKey();
+        CachedRun* cached = Find(font, options, text);
+        if(cached) {
+            Emit(glyphs, text, options, cached->_run, emitEmpty, renderInfo);
+            return;
+        }
+
+        ShapedRun run;
+        uint32_t firstLine = 0;
+        CachedRun* previous = previousText.empty()? nullptr : Find(font, options, previousText);
+        if(previous) {
+            // The lines before the line of the first change keep their characters,
+            // the line before it is shaped again as the changed word may fit on it now
+            const size_t common = std::mismatch(previousText.begin(), previousText.end(), text.begin(), text.end()).first - previousText.begin();
+            run = previous->_run;
+            auto line = std::upper_bound(run._lineStarts.begin(), run._lineStarts.end(), (uint32_t)common);
+            firstLine = (uint32_t)std::max<ptrdiff_t>(line - run._lineStarts.begin() - 2, 0);
+        }
+        Shape(glyphs, text, options, firstLine, run);
+        if(run._complete) Insert(font, glyphs.GetAsset(), options, text, run);
+        Emit(glyphs, text, options, run, emitEmpty, renderInfo);
+    }
+
+    Component::Text::CharRenderInfo TextLayout::GetCharRenderInfo(const CharInfo& charInfo, const float x, const float y) {
+        return {
+            Util::AreaF(
+                std::floor(x - ENGINE_RENDERER_SDF_PADDING) + charInfo._min.x,
+                y - charInfo._max.y - ENGINE_RENDERER_SDF_PADDING,
+                charInfo._max.x - charInfo._min.x + 2*ENGINE_RENDERER_SDF_PADDING,
+                charInfo._max.y - charInfo._min.y + 2*ENGINE_RENDERER_SDF_PADDING
+            ),
+            charInfo._textureArea,
+            charInfo._boundTexture,
+            (float)ENGINE_RENDERER_PX_RANGE_FACTOR*(float)sqrt((charInfo._max.x-charInfo._min.x)*(charInfo._max.x-charInfo._min.x)+(charInfo._max.y-charInfo._min.y)*(charInfo._max.y-charInfo._min.y))
+        };
+    }
+
+    uint64_t TextLayout::GetKey(const uint64_t font, const Component::TextOptions& options, const std::u32string& text) {
+        uint64_t key = std::hash<std::u32string>()(text);
+        key ^= font + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+        key ^= ((uint64_t)std::bit_cast<uint32_t>(options._wrapWidth) << 32 | std::bit_cast<uint32_t>(options._lineHeight)) + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+        key ^= options._alignment + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+        return key;
+    }
+    TextLayout::CachedRun* TextLayout::Find(const uint64_t font, const Component::TextOptions& options, const std::u32string& text) {
+        auto it = _runs.find(GetKey(font, options, text));
+        // A different run with the same key is a miss
+        if(it == _runs.end() || it->second._font != font || !(it->second._options == options) || it->second._text != text) return nullptr;
+        _leastRecentlyUsed.splice(_leastRecentlyUsed.begin(), _leastRecentlyUsed, it->second._leastRecentlyUsed);
+        return &it->second;
+    }
+    void TextLayout::RemoveAssetRuns(const uint32_t mask, const uint32_t value) {
+        for(auto it = _runs.begin(); it != _runs.end();) {
+            if(it->second._asset == UINT32_MAX || (it->second._asset & mask) != value) { it++; continue; }
+            _leastRecentlyUsed.erase(it->second._leastRecentlyUsed);
+            it = _runs.erase(it);
+        }
+    }
+    void TextLayout::Insert(const uint64_t font, const uint32_t asset, const Component::TextOptions& options, const std::u32string& text, const ShapedRun& run) {
+        const uint64_t key = GetKey(font, options, text);
+        auto it = _runs.find(key);
+        if(it != _runs.end()) _leastRecentlyUsed.erase(it->second._leastRecentlyUsed);
+        else if(_runs.size() >= ENGINE_RENDERER_TEXTLAYOUT_CACHE_SIZE) {
+            _runs.erase(_leastRecentlyUsed.back());
+            _leastRecentlyUsed.pop_back();
+        }
+        _leastRecentlyUsed.push_front(key);
+        _runs.insert_or_assign(key, CachedRun{ font, asset, options, text, run, _leastRecentlyUsed.begin() });
+    }
+
+    void TextLayout::Shape(GlyphSource& glyphs, const std::u32string& text, const Component::TextOptions& options, const uint32_t firstLine, ShapedRun& run) {
+        const uint32_t start = firstLine < run._lineStarts.size()? run._lineStarts[firstLine] : 0;
+        run._lineStarts.resize(std::min((size_t)firstLine, run._lineStarts.size()));
+        run._lineWidths.resize(run._lineStarts.size());
+        run._x.resize(text.size());
+        run._complete = true;
+
+        uint32_t lineStart = start;
+        uint32_t lastSpace = UINT32_MAX;// The last space on the line, where it is broken when a word does not fit anymore
+        float currentX = 0;
+        float lineWidth = 0;// Up to the end of the last character that is not a space
+        float widthBeforeSpace = 0;
+        run._lineStarts.push_back(start);
+        auto newLine = [&](const uint32_t next, const float width) {
+            run._lineWidths.push_back(width);
+            run._lineStarts.push_back(next);
+            lineStart = next;
+            lastSpace = UINT32_MAX;
+            currentX = 0;
+            lineWidth = 0;
+        };
+        uint32_t i = start;
+        while(i < text.size()) {
+            const char32_t c = text[i];
+            if(c == U'\n') {
+                run._x[i] = currentX;
+                newLine(i + 1, lineWidth);
+                i++;
+                continue;
+            }
+            const CharInfo* charInfo = glyphs.GetGlyph(c);
+            if(!charInfo) {
+                charInfo = glyphs.GetPlaceholder();
+                if(charInfo) run._complete = false;
+            }
+            if(!charInfo) {
+                // Not in the font, left out
+                run._x[i] = currentX;
+                i++;
+                continue;
+            }
+            float x = currentX;
+            if(i > lineStart) x += glyphs.GetKerning(text[i-1], c) + charInfo->_leftSideBearing;
+            const float end = currentX + charInfo->_advance;
+            if(options._wrapWidth > 0 && c != U' ' && end > options._wrapWidth && i > lineStart) {
+                // Moves the word to the next line, or breaks it when it is the only word on the line
+                if(lastSpace != UINT32_MAX) {
+                    const uint32_t next = lastSpace + 1;
+                    newLine(next, widthBeforeSpace);
+                    i = next;
+                } else {
+                    newLine(i, lineWidth);
+                }
+                continue;
+            }
+            run._x[i] = x;
+            if(c == U' ') {
+                if(lastSpace == UINT32_MAX || lastSpace + 1 != i) widthBeforeSpace = lineWidth;
+                lastSpace = i;
+            } else {
+                lineWidth = end;
+            }
+            currentX = end;
+            i++;
+        }
+        run._lineWidths.push_back(lineWidth);
+    }
+    void TextLayout::Emit(GlyphSource& glyphs, const std::u32string& text, const Component::TextOptions& options, const ShapedRun& run, const bool emitEmpty, std::vector<Component::Text::CharRenderInfo>& renderInfo) {
+        renderInfo.clear();
+        renderInfo.reserve(text.size());
+        const float lineHeight = options._lineHeight > 0? options._lineHeight : ENGINE_RENDERER_LINE_HEIGHT_FACTOR*glyphs.GetSize();
+        // Without a wrap width the lines are aligned to the widest line
+        const float width = options._wrapWidth > 0? options._wrapWidth : *std::max_element(run._lineWidths.begin(), run._lineWidths.end());
+        const CharInfo* placeholder = glyphs.GetPlaceholder();
+
+        uint32_t line = 0;
+        float offset = 0;
+        for(uint32_t i = 0; i < text.size(); i++) {
+            if(i == 0 || (line + 1 < run._lineStarts.size() && run._lineStarts[line + 1] <= i)) {
+                while(line + 1 < run._lineStarts.size() && run._lineStarts[line + 1] <= i) line++;
+                if(options._alignment == Component::TextOptions::Center) offset = std::floor((width - run._lineWidths[line])*0.5f);
+                else if(options._alignment == Component::TextOptions::Right) offset = width - run._lineWidths[line];
+            }
+            const float y = line*lineHeight;
+            const CharInfo* charInfo = text[i] == U'\n'? nullptr : glyphs.GetGlyph(text[i]);
+            if(!charInfo && text[i] != U'\n') charInfo = placeholder;
+            if(charInfo && charInfo->_boundTexture!=UINT32_MAX && charInfo->_textureArea.w!=0 && charInfo->_textureArea.h!=0) {
+                renderInfo.push_back(GetCharRenderInfo(*charInfo, run._x[i] + offset, y));
+            } else if(emitEmpty) {
+                // Nothing is drawn, the quad only keeps the amount of render infos equal to the amount of characters
+                renderInfo.push_back({ Util::AreaF(run._x[i] + offset, y, 0, 0), placeholder? placeholder->_textureArea : Util::AreaF(0), placeholder? placeholder->_boundTexture : 0, 1 });
+            }
+        }
+    }
+
+}
+}
\ No newline at end of file
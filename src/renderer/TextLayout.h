@@ -0,0 +1,120 @@
+#ifndef ENGINE_RENDERER_TEXTLAYOUT_H
+#define ENGINE_RENDERER_TEXTLAYOUT_H
+
+#include "core/PCH.h"
+#include <list>
+
+#include "core/Components.h"
+#include "renderer/TextLoader.h"
+#include "renderer/GlyphCache.h"
+
+// The distance between two lines as a factor of the size, when the options of the text do not set a line height
+#ifndef ENGINE_RENDERER_LINE_HEIGHT_FACTOR
+#define ENGINE_RENDERER_LINE_HEIGHT_FACTOR 1.25f
+#endif
+// The amount of shaped runs the text layout keeps, the least recently used runs are dropped
+#ifndef ENGINE_RENDERER_TEXTLAYOUT_CACHE_SIZE
+#define ENGINE_RENDERER_TEXTLAYOUT_CACHE_SIZE 256
+#endif
+
+namespace Engine {
+namespace Renderer {
+
+    // Where the text layout gets the glyphs from
+    class GlyphSource {
+    public:
+        // Returns nullptr when the font does not have the glyph (yet)
+        virtual const CharInfo* GetGlyph(const char32_t c) = 0;
+        virtual int16_t GetKerning(const char32_t left, const char32_t right) = 0;
+        // Drawn instead of the glyphs that are not rendered yet, nullptr when missing glyphs are left out
+        virtual const CharInfo* GetPlaceholder() { return nullptr; }
+        // Identifies the font and the size for the cache of the text layout
+        virtual uint64_t GetFontKey() const = 0;
+        virtual uint32_t GetSize() const = 0;
+        // The asset the glyphs come from, UINT32_MAX when they are not from an asset
+        virtual uint32_t GetAsset() const { return UINT32_MAX; }
+    };
+    // The glyphs of one size of a loaded text asset
+    class TextAssetGlyphs : public GlyphSource {
+    public:
+        TextAssetGlyphs(const uint32_t asset, std::shared_ptr<TextRenderInfo> info, const uint32_t size);
+
+        inline const CharInfo* GetGlyph(const char32_t c) override { return _info->FindGlyph(_sizeIndex, c); }
+        inline int16_t GetKerning(const char32_t left, const char32_t right) override { return _info->GetKerning(_sizeIndex, left, right); }
+        inline uint64_t GetFontKey() const override { return ((uint64_t)_asset << 32) | _size; }
+        inline uint32_t GetSize() const override { return _size; }
+        inline uint32_t GetAsset() const override { return _asset; }
+
+    private:
+        uint32_t _asset;
+        std::shared_ptr<TextRenderInfo> _info;
+        uint32_t _size;
+        uint32_t _sizeIndex;
+    };
+    // The glyphs of a glyph cache, the missing glyphs are queued and drawn as a placeholder
+    class GlyphCacheGlyphs : public GlyphSource {
+    public:
+        GlyphCacheGlyphs(const uint32_t glyphCacheID, GlyphCache& glyphCache) : _glyphCacheID(glyphCacheID), _glyphCache(glyphCache) {}
+
+        inline const CharInfo* GetGlyph(const char32_t c) override { return _glyphCache.GetGlyph(c); }
+        inline int16_t GetKerning(const char32_t left, const char32_t right) override { return _glyphCache.GetKerning(left, right); }
+        inline const CharInfo* GetPlaceholder() override { return &_glyphCache.GetPlaceholder(); }
+        inline uint64_t GetFontKey() const override { return (1ull << 63) | _glyphCacheID; }
+        inline uint32_t GetSize() const override { return _glyphCache.GetSize(); }
+
+    private:
+        uint32_t _glyphCacheID;
+        GlyphCache& _glyphCache;
+    };
+
+    /**
+     * @brief Places the characters of a text on lines and writes the quads of the glyphs
+     * The shaped runs (the lines and the position of every character before alignment) are cached per font, size, options and string.
+     * When the text of a component changes, the run of its previous text is reused up to the line before the first changed character,
+     * so a score counter or a chat box only shapes its last line again.
+     * Lines are broken at the spaces when they get wider than the wrap width, and always at a newline.
+     */
+    class TextLayout {
+    public:
+        // Writes the quads of the text into renderInfo, previousText is the text the render info was made for (empty when it is new)
+        // Every character gets a quad when emitEmpty is set (an empty one for spaces and missing glyphs), otherwise only the visible characters
+        void Layout(GlyphSource& glyphs, const std::u32string& previousText, const std::u32string& text, const Component::TextOptions& options, const bool emitEmpty, std::vector<Component::Text::CharRenderInfo>& renderInfo);
+
+        static Component::Text::CharRenderInfo GetCharRenderInfo(const CharInfo& charInfo, const float x, const float y);
+        // Drops the runs of the assets for which (asset & mask) == value
+        // Must be called when asset IDs are given out again, the font key of a new asset would find the runs of the old one
+        void RemoveAssetRuns(const uint32_t mask, const uint32_t value);
+
+    private:
+        // The characters of a text placed on lines, without the alignment
+        struct ShapedRun {
+            std::vector<float> _x;// The pen position of every character on its line
+            std::vector<uint32_t> _lineStarts;// The first character of every line
+            std::vector<float> _lineWidths;
+            bool _complete = true;// False when a placeholder was used, those runs are not cached
+        };
+        struct CachedRun {
+            uint64_t _font;
+            uint32_t _asset;
+            Component::TextOptions _options;
+            std::u32string _text;
+            ShapedRun _run;
+            std::list<uint64_t>::iterator _leastRecentlyUsed;
+        };
+
+        static uint64_t GetKey(const uint64_t font, const Component::TextOptions& options, const std::u32string& text);
+        // Returns nullptr when the run is not cached
+        CachedRun* Find(const uint64_t font, const Component::TextOptions& options, const std::u32string& text);
+        void Insert(const uint64_t font, const uint32_t asset, const Component::TextOptions& options, const std::u32string& text, const ShapedRun& run);
+        // Shapes the text from the start of firstLine on, the lines before it are kept
+        static void Shape(GlyphSource& glyphs, const std::u32string& text, const Component::TextOptions& options, const uint32_t firstLine, ShapedRun& run);
+        static void Emit(GlyphSource& glyphs, const std::u32string& text, const Component::TextOptions& options, const ShapedRun& run, const bool emitEmpty, std::vector<Component::Text::CharRenderInfo>& renderInfo);
+
+        std::unordered_map<uint64_t, CachedRun> _runs;
+        std::list<uint64_t> _leastRecentlyUsed;// The back is dropped first
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -1,9 +1,51 @@
 #include "renderer/TextLoader.h"
+#include "util/serialization/Binary.h"
+#include "util/Profiler.h"
 
 #define FLOAT_MAX std::numeric_limits<float>::max()
 
 namespace Engine {
 namespace Renderer {
+
+    void TextRenderInfo::Init(const std::vector<uint32_t>& sizes, std::vector<char32_t> characters) {
+        std::sort(characters.begin(), characters.end());
+        characters.erase(std::unique(characters.begin(), characters.end()), characters.end());
+        _sizes = sizes;
+        _ranges.clear();
+        for(uint32_t i = 0; i < characters.size(); i++) {
+            if(!_ranges.empty() && _ranges.back()._last + 1 == characters[i]) _ranges.back()._last++;
+            else _ranges.push_back(Range{ characters[i], characters[i], i });
+        }
+        _amountCharacters = (uint32_t)characters.size();
+        _glyphs = std::vector<CharInfo>(_sizes.size()*_amountCharacters);
+        _kerning.clear();
+    }
+    uint32_t TextRenderInfo::GetSizeIndex(const uint32_t size) const {
+        for(uint32_t i = 0; i < _sizes.size(); i++) {
+            if(_sizes[i] == size) return i;
+        }
+        return UINT32_MAX;
+    }
+    uint32_t TextRenderInfo::GetCharacterIndex(const char32_t c) const {
+        // The first range that starts after c, the range before it is the only one that can contain c
+        auto range = std::upper_bound(_ranges.begin(), _ranges.end(), c, [](const char32_t c, const Range& range) { return c < range._first; });
+        if(range == _ranges.begin()) return UINT32_MAX;
+        range--;
+        if(c > range->_last) return UINT32_MAX;
+        return range->_index + (uint32_t)(c - range->_first);
+    }
+    const CharInfo* TextRenderInfo::FindGlyph(const uint32_t sizeIndex, const char32_t c) const {
+        const uint32_t index = GetCharacterIndex(c);
+        if(index == UINT32_MAX) return nullptr;
+        return &_glyphs[(size_t)sizeIndex*_amountCharacters + index];
+    }
+    int16_t TextRenderInfo::GetKerning(const uint32_t sizeIndex, const char32_t left, const char32_t right) const {
+        if(_kerning.empty()) return 0;
+        const KerningPair pair{ sizeIndex, left, right, 0 };
+        auto it = std::lower_bound(_kerning.begin(), _kerning.end(), pair);
+        if(it == _kerning.end() || it->_size != sizeIndex || it->_left != left || it->_right != right) return 0;
+        return it->_kerning;
+    }
     
     TextLoader::TextLoader(const std::string file, const Characters characters, const std::initializer_list<uint32_t> sizes)
     :  _file(Util::FileManager::Get(file)) 
@@ -20,18 +62,28 @@ namespace Renderer {
     size_t TextLoader::GetAmountTextures() {
         return _characters._characterCount * _sizes.size();
     }
-    void TextLoader::SetTextureSizes(Util::Vec3U32* start) {
-        TTFFontParser fontParser = TTFFontParser(_file, _characters);
+    void TextLoader::SetTextureSizes(Util::Vec3U32* start, Util::ThreadPool* threadPool) {
+        // Only parsed when one of the sizes is not in the cache
+        std::unique_ptr<TTFFontParser> fontParser;
+        // The glyphs of a size are only hinted in parallel when there are more glyphs than one batch
+        if(_characters._characterCount <= ENGINE_RENDERER_TTF_HINTING_BATCH_SIZE) threadPool = nullptr;
         size_t i = 0;
         _fontData.resize(_sizes.size());
         _textureAreas.resize(_sizes.size()*_characters._characterCount);
         for(const uint32_t fontSize : _sizes) {
-            if(fontSize < ENGINE_RENDERER_FONTPROGRAM_MAXSIZE)
-                _fontData[i] = fontParser.GetScaledData(fontSize);
-            else
-                _fontData[i] = fontParser.GetNonScaledData();
+            double generalScale;
+            if(!ReadFontData(fontSize, _fontData[i], generalScale)) {
+                if(!fontParser) fontParser = std::make_unique<TTFFontParser>(_file, _characters);
+                if(fontSize < ENGINE_RENDERER_FONTPROGRAM_MAXSIZE) {
+                    _fontData[i] = fontParser->GetScaledData(fontSize, threadPool);
+                } else {
+                    _fontData[i] = fontParser->GetNonScaledData();
+                }
+                generalScale = fontParser->GetScale(ENGINE_RENDERER_GENERAL_RENDERSIZE);
+                WriteFontData(fontSize, *_fontData[i], generalScale);
+            }
             
-            float scalingFactor = fontSize<ENGINE_RENDERER_FONTPROGRAM_MAXSIZE ? 1.f : (float)fontParser.GetScale(ENGINE_RENDERER_GENERAL_RENDERSIZE);
+            float scalingFactor = fontSize<ENGINE_RENDERER_FONTPROGRAM_MAXSIZE ? 1.f : (float)generalScale;
             for(const char32_t c : _characters) {
                 if(_fontData[i]->_glyphs[c]._contours.size() == 0) { start++; continue; }
                 Util::Vec2F size = (_fontData[i]->_glyphs[c]._max - _fontData[i]->_glyphs[c]._min) * scalingFactor;
@@ -44,22 +96,24 @@ namespace Renderer {
     void TextLoader::RenderTexture(Util::AreaU8* texture, const Util::Vec2U32 textureSize, const Util::AreaU32 area, const size_t id) {
         const uint32_t fontID = (uint32_t)std::floor(id / _characters._characterCount);
         const uint32_t fontSize = _sizes[(size_t)fontID];
-        TTFFontParser::FontData* fontData = _fontData[(size_t)std::floor(id / _characters._characterCount)].get();
+        const TTFFontParser::FontData* fontData = _fontData[(size_t)std::floor(id / _characters._characterCount)].get();
         const char32_t c = _characters[(uint32_t)id - fontID*(uint32_t)_characters._characterCount];
+        const TTFFontParser::FontData::GlyphInfo& glyph = fontData->_glyphs.at(c);
         
+        // Local, as multiple textures are rendered at the same time
         size_t amountCurves = 0;
-        for(const auto& contour : fontData->_glyphs[c]._contours) { amountCurves += (size_t)contour._contourLength; }
-        _renderingCurves.resize(amountCurves);
+        for(const auto& contour : glyph._contours) { amountCurves += (size_t)contour._contourLength; }
+        std::vector<TriCurve> curves(amountCurves);
         if(amountCurves == 0) return;
 
         size_t renderCurve = 0;
-        for(const auto& contour : fontData->_glyphs[c]._contours) {
+        for(const auto& contour : glyph._contours) {
             for(size_t i = contour._contourStart; i < contour._contourStart + contour._contourLength; i++) {
                 const TTFFontParser::BezierCurve prev = fontData->_curves[i==contour._contourStart? contour._contourStart+contour._contourLength-1 : i-1];
                 const TTFFontParser::BezierCurve curve = fontData->_curves[i];
                 const TTFFontParser::BezierCurve next = fontData->_curves[i==contour._contourStart+contour._contourLength-1? contour._contourStart : i+1];
                 // TODO: Contour offset and scaling
-                _renderingCurves[renderCurve] = TriCurve(
+                curves[renderCurve] = TriCurve(
                     Curve(
                         prev.degree<4? FLOAT_MAX : (prev.p4 - prev.p3*3 + prev.p2*3 - prev.p1),   
                         prev.degree<3? FLOAT_MAX : (prev.p3 - prev.p2*2 + prev.p1),   
@@ -85,7 +139,7 @@ namespace Renderer {
         /*
         if(id == 'x'-'a') {
             int i = 0;
-            for(TriCurve& c : _renderingCurves) {
+            for(TriCurve& c : curves) {
                 Curve& curve = c.curve;
                 if(curve.p2.x == FLOAT_MAX && curve.p2.y == FLOAT_MAX) {
                     std::cout << "B" << i << "=KROMME(t*("<<curve.p1.x<<","<<curve.p1.y<<")+("<<curve.P0.x<<","<<curve.P0.y<<"), t, 0, 1)\n";
@@ -98,15 +152,11 @@ namespace Renderer {
             }
         }*/
 
-        _renderingMaxDistance = ENGINE_RENDERER_PX_RANGE_FACTOR*(float)sqrt(area.w*area.w + area.h*area.h);
-        Util::Vec2F min = _fontData[fontID]->_glyphs[c]._min;
-        Util::Vec2F max = _fontData[fontID]->_glyphs[c]._max;
+        const float maxDistance = ENGINE_RENDERER_PX_RANGE_FACTOR*(float)sqrt(area.w*area.w + area.h*area.h);
+        const CurveGrid grid = CreateCurveGrid(curves, Util::Vec2U32(area.w, area.h), glyph._min, glyph._max);
 
         for(uint32_t y = 0; y < area.h; y++) {
-            Util::AreaU8* row = texture + (area.y+y)*textureSize.x + area.x;
-            for(uint32_t x = 0; x < area.w; x++) {
-                *(row+x) = CalculateSignedField(x+0.5f+min.x-ENGINE_RENDERER_SDF_PADDING, max.y-(y+0.5f-ENGINE_RENDERER_SDF_PADDING));
-            }
+            CalculateSignedFieldRow(curves, grid, maxDistance, y, area.w, glyph._min, glyph._max, texture + (area.y+y)*textureSize.x + area.x);
         }
         return;
     }
@@ -115,31 +165,169 @@ namespace Renderer {
         _textureAreas[id] = std::pair<Util::AreaF, uint32_t>(area, boundTexture);
     }
     std::shared_ptr<uint8_t> TextLoader::GetRenderInfo() {
-        std::shared_ptr<TextRenderInfo> ret = std::make_shared<TextRenderInfo>();
+        std::shared_ptr<TextRenderInfo> ret = std::make_shared<TextRenderInfo>(GetMetrics());
 
         uint32_t id = 0;
-        uint32_t fontDataID = 0;
-        for(const uint32_t size : _sizes) {
-            TTFFontParser::FontData* fontData = _fontData[fontDataID].get();
-            ret->insert(std::pair(size, std::map<char32_t, CharInfo>()));
+        for(uint32_t sizeIndex = 0; sizeIndex < _sizes.size(); sizeIndex++) {
             for(const char32_t c : _characters) {
-                CharInfo* info = &ret->at(size)[c];
+                CharInfo* info = &ret->GetGlyphAt(sizeIndex, ret->GetCharacterIndex(c));
                 if(_textureAreas[id].first != Util::AreaF(0)) {
                     info->_textureArea = _textureAreas[id].first;
                     info->_boundTexture = _textureAreas[id].second;
                 }
+                id++;
+            }
+        }
+                
+        return std::reinterpret_pointer_cast<uint8_t>(ret);
+    }
+    TextRenderInfo TextLoader::GetMetrics() {
+        if(_fontData.empty()) return _cachedMetrics;
+        TextRenderInfo ret;
+        std::vector<char32_t> characters;
+        characters.reserve(_characters._characterCount);
+        for(const char32_t c : _characters) characters.push_back(c);
+        ret.Init(_sizes, characters);
+        for(uint32_t sizeIndex = 0; sizeIndex < _sizes.size(); sizeIndex++) {
+            TTFFontParser::FontData* fontData = _fontData[sizeIndex].get();
+            for(const char32_t c : _characters) {
+                CharInfo* info = &ret.GetGlyphAt(sizeIndex, ret.GetCharacterIndex(c));
                 info->_min = fontData->_glyphs[c]._min;
                 info->_max = fontData->_glyphs[c]._max;
                 info->_advance = fontData->_glyphs[c]._advance;
                 info->_leftSideBearing = fontData->_glyphs[c]._leftSideBearing;
-                info->_horizontalKerning = fontData->_glyphs[c]._horizontalKerning;
+                // The font data stores the kerning at the right character, with the left character as key
+                for(const auto& [left, kerning] : fontData->_glyphs[c]._horizontalKerning) {
+                    ret._kerning.push_back(TextRenderInfo::KerningPair{ sizeIndex, left, c, kerning });
+                }
+            }
+        }
+        std::sort(ret._kerning.begin(), ret._kerning.end());
+        // Duplicate characters add their pairs twice
+        ret._kerning.erase(std::unique(ret._kerning.begin(), ret._kerning.end(), [](const TextRenderInfo::KerningPair& a, const TextRenderInfo::KerningPair& b) {
+            return !(a < b) && !(b < a);
+        }), ret._kerning.end());
+        return ret;
+    }
 
-                id++;
+    std::string TextLoader::GetCacheKey() {
+        // The version changes with the layout of the render info
+        std::string key = "text2:" + _file.String() + ":";
+        for(const uint32_t size : _sizes) key += std::to_string(size) + ",";
+        key += ":";
+        for(const char32_t c : _characters) key += std::to_string((uint32_t)c) + ",";
+        return key;
+    }
+    std::vector<Util::File> TextLoader::GetSourceFiles() {
+        return { _file };
+    }
+    void TextLoader::WriteCache(std::vector<uint8_t>& data) {
+        TextRenderInfo metrics = GetMetrics();
+        Util::BinarySerializer serializer;
+        serializer.Serialize(metrics, data);
+    }
+    void TextLoader::ReadCache(std::vector<uint8_t>& data) {
+        Util::BinaryDeserializer deserializer;
+        deserializer.Deserialize(_cachedMetrics, data);
+        _textureAreas.resize(_sizes.size()*_characters._characterCount);
+    }
+
+    std::string TextLoader::GetFontDataKey(const uint32_t size) {
+        // The version changes with the layout of the font data
+        std::string key = "fontdata1:" + _file.String() + ":" + std::to_string(size) + ":";
+        for(const char32_t c : _characters) key += std::to_string((uint32_t)c) + ",";
+        return key;
+    }
+    bool TextLoader::ReadFontData(const uint32_t size, std::unique_ptr<TTFFontParser::FontData>& fontData, double& generalScale) {
+        if(!_cacheFontData) return false;
+        ENGINE_PROFILE_SCOPE("TextLoader::ReadFontData")
+        const std::string key = GetFontDataKey(size);
+        if(!Util::FileManager::CanUseCache(key + ".fontdata", std::vector<Util::File>{ _file })) return false;
+        CachedFontData cache;
+        try {
+            std::vector<uint8_t> data;
+            Util::FileManager::Cache(key + ".fontdata").Read(data);
+            Util::BinaryDeserializer deserializer;
+            deserializer.Deserialize(cache, data);
+        } catch(...) {
+            WARNING("[Renderer::TextLoader] Failed to read the cached font data of '" + _file.String() + "', parsing the font again")
+            return false;
+        }
+        if(cache._key != key) return false;
+        fontData = std::make_unique<TTFFontParser::FontData>(std::move(cache._fontData));
+        generalScale = cache._generalScale;
+        return true;
+    }
+    void TextLoader::WriteFontData(const uint32_t size, const TTFFontParser::FontData& fontData, const double generalScale) {
+        if(!_cacheFontData) return;
+        ENGINE_PROFILE_SCOPE("TextLoader::WriteFontData")
+        CachedFontData cache{ GetFontDataKey(size), generalScale, fontData };
+        try {
+            std::vector<uint8_t> data;
+            Util::BinarySerializer serializer;
+            serializer.Serialize(cache, data);
+            Util::FileManager::Cache(cache._key + ".fontdata").Write(data);
+        } catch(...) {
+            WARNING("[Renderer::TextLoader] Failed to write the font data of '" + _file.String() + "' to the cache")
+        }
+    }
+
+    TextLoader::CurveBox TextLoader::GetBoundingBox(const Curve& curve) {
+        // The control points from the power basis (see RenderTexture)
+        Util::Vec2D points[4];
+        size_t amountPoints = 2;// First degree
+        points[0] = curve.P0;
+        points[1] = curve.P0 + curve.p1;
+        if(curve.p2.x != FLOAT_MAX || curve.p2.y != FLOAT_MAX) {
+            // Second degree
+            points[2] = curve.p2 + curve.p1*2 + curve.P0;
+            amountPoints = 3;
+        }
+        if(curve.p3.x != FLOAT_MAX || curve.p3.y != FLOAT_MAX) {
+            // Third degree
+            points[3] = curve.p3 + curve.p2*3 + curve.p1*3 + curve.P0;
+            amountPoints = 4;
+        }
+        CurveBox box{ points[0], points[0] };
+        for(size_t i = 1; i < amountPoints; i++) {
+            box._min = Util::Vec2D(std::min(box._min.x, points[i].x), std::min(box._min.y, points[i].y));
+            box._max = Util::Vec2D(std::max(box._max.x, points[i].x), std::max(box._max.y, points[i].y));
+        }
+        return box;
+    }
+    double TextLoader::BoxDistance(const CurveBox& a, const CurveBox& b) {
+        const double x = std::max({ 0., a._min.x - b._max.x, b._min.x - a._max.x });
+        const double y = std::max({ 0., a._min.y - b._max.y, b._min.y - a._max.y });
+        return std::sqrt(x*x + y*y);
+    }
+    TextLoader::CurveGrid TextLoader::CreateCurveGrid(const std::vector<TriCurve>& curves, const Util::Vec2U32 size, const Util::Vec2F glyphMin, const Util::Vec2F glyphMax) {
+        CurveGrid grid;
+        grid._width = (size.x + ENGINE_RENDERER_SDF_GRID_CELL_SIZE - 1) / ENGINE_RENDERER_SDF_GRID_CELL_SIZE;
+        const uint32_t height = (size.y + ENGINE_RENDERER_SDF_GRID_CELL_SIZE - 1) / ENGINE_RENDERER_SDF_GRID_CELL_SIZE;
+        grid._boxes.reserve(curves.size());
+        for(const TriCurve& curve : curves) grid._boxes.push_back(GetBoundingBox(curve.curve));
+        grid._cells.resize((size_t)grid._width * height);
+        for(uint32_t cellY = 0; cellY < height; cellY++) {
+            for(uint32_t cellX = 0; cellX < grid._width; cellX++) {
+                // The box around the points of the first and the last pixel of the cell
+                const Util::Vec2F first = GetPixelPoint(cellX*ENGINE_RENDERER_SDF_GRID_CELL_SIZE, cellY*ENGINE_RENDERER_SDF_GRID_CELL_SIZE, glyphMin, glyphMax);
+                const Util::Vec2F last = GetPixelPoint(
+                    std::min((cellX+1)*ENGINE_RENDERER_SDF_GRID_CELL_SIZE, size.x) - 1,
+                    std::min((cellY+1)*ENGINE_RENDERER_SDF_GRID_CELL_SIZE, size.y) - 1,
+                    glyphMin, glyphMax
+                );
+                const CurveBox cell{ Util::Vec2D(first.x, last.y), Util::Vec2D(last.x, first.y) };
+                std::vector<CurveGrid::Entry>& entries = grid._cells[(size_t)cellY*grid._width + cellX];
+                entries.reserve(curves.size());
+                for(uint32_t i = 0; i < curves.size(); i++) {
+                    entries.push_back(CurveGrid::Entry{ BoxDistance(grid._boxes[i], cell), i });
+                }
+                std::sort(entries.begin(), entries.end(), [](const CurveGrid::Entry& a, const CurveGrid::Entry& b) {
+                    return a._bound < b._bound || (a._bound == b._bound && a._curve < b._curve);
+                });
             }
-            fontDataID++;
         }
-                
-        return std::reinterpret_pointer_cast<uint8_t>(ret);
+        return grid;
     }
 
     float TextLoader::Orthogonality(const Curve& curve, const Util::Vec2D p, const bool start) {
@@ -238,16 +426,122 @@ namespace Renderer {
         }
         return (float)distance*(float)sign;
     }
-    Util::AreaU8 TextLoader::CalculateSignedField(const float x, const float y) {
-        float lowestDistance = FLOAT_MAX;
-        for(const TriCurve& curve : _renderingCurves) {
-            const float distance = Distance(curve.prev, curve.curve, curve.next, Util::Vec2F(x, y), false);
-            if(std::abs(distance) < std::abs(lowestDistance)) lowestDistance = distance;
+    void TextLoader::DistanceBatch(const TriCurve& triCurve, const float* x, const float y, const bool* active, float* distance) {
+        const Curve& curve = triCurve.curve;
+        double pixelDistance[ENGINE_RENDERER_SDF_BATCH_SIZE];
+        double pixelT[ENGINE_RENDERER_SDF_BATCH_SIZE];
+        double pixelSign[ENGINE_RENDERER_SDF_BATCH_SIZE];
+        if(curve.p2.x == FLOAT_MAX && curve.p2.y == FLOAT_MAX) {
+            // First degree
+            const double lengthSquared = curve.p1*curve.p1;
+            for(uint32_t pixel = 0; pixel < ENGINE_RENDERER_SDF_BATCH_SIZE; pixel++) {
+                const Util::Vec2D p(x[pixel], y);
+                const double t = std::clamp(((p - curve.P0)*curve.p1)/lengthSquared, 0., 1.);
+                Util::Vec2D BMinusP =  curve.p1*t + curve.P0 - p;// p1*t + P0 - p
+                pixelDistance[pixel] = BMinusP.length();
+                pixelSign[pixel] = SIGN(curve.p1.cross(BMinusP));// (p1)*BMinusP
+                pixelT[pixel] = t;
+            }
+        } else {
+            // Second degree, only the last two coefficients depend on the point
+            const double a = (curve.p2*curve.p2)                             / 133296128.;// t^3
+            const double b = (curve.p1*curve.p2*3)                           / 133296128.;// t^2
+            const double c = curve.p1*curve.p1*2;
+            for(uint32_t pixel = 0; pixel < ENGINE_RENDERER_SDF_BATCH_SIZE; pixel++) {
+                pixelDistance[pixel] = FLOAT_MAX;
+                pixelT[pixel] = FLOAT_MAX;
+                pixelSign[pixel] = 1.;
+                if(!active[pixel]) continue;
+                const Util::Vec2D p(x[pixel], y);
+                double solutions[3];
+                const int amountSolutions = Util::SolveCubic(solutions, a, b,
+                    (c-curve.p2*(p - curve.P0))   / 133296128.,// t
+                    ((p - curve.P0)*curve.p1*-1)  / 133296128.
+                );
+                for(int i = 0; i < amountSolutions; i++) {
+                    solutions[i] = std::clamp(solutions[i], 0., 1.);
+                    Util::Vec2D BMinusP = (curve.p2*solutions[i]+curve.p1*2)*solutions[i]+curve.P0 - p;// p2*t^2 + 2*p1*t + P0 - p
+                    double distanceLocal = BMinusP.length();
+                    if(distanceLocal < pixelDistance[pixel]) {
+                        pixelDistance[pixel] = distanceLocal;
+                        pixelSign[pixel] = SIGN((curve.p2*solutions[i]*2+curve.p1*2).cross(BMinusP));// (2*p2*t + 2*p1)*BMinusP
+                        pixelT[pixel] = solutions[i];
+                    }
+                }
+            }
+        }
+        // The corners, see Distance
+        for(uint32_t pixel = 0; pixel < ENGINE_RENDERER_SDF_BATCH_SIZE; pixel++) {
+            if(!active[pixel]) continue;
+            distance[pixel] = (float)pixelDistance[pixel]*(float)pixelSign[pixel];
+            const Util::Vec2D p(x[pixel], y);
+            if(pixelT[pixel] >= 0.999) {
+                if(Orthogonality(curve, p, false) < Orthogonality(triCurve.next, p, true)) distance[pixel] = FLOAT_MAX;
+            } else if(pixelT[pixel] <= 0.001) {
+                if(Orthogonality(curve, p, true) < Orthogonality(triCurve.prev, p, false)) distance[pixel] = FLOAT_MAX;
+            }
+            ASSERT_IF_DEBUG(IsSameDistance(distance[pixel], Distance(triCurve.prev, curve, triCurve.next, p, false)), "[Renderer::TextLoader] DistanceBatch does not match Distance, the batches calculate a different field than the reference")
+        }
+    }
+    void TextLoader::CalculateSignedFieldRow(const std::vector<TriCurve>& curves, const CurveGrid& grid, const float maxDistance, const uint32_t pixelY, const uint32_t width, const Util::Vec2F glyphMin, const Util::Vec2F glyphMax, Util::AreaU8* output) {
+        // The same as evaluating every curve in order and keeping the first of the closest ones
+        // A small margin covers the rounding of the distance calculation, the curve is never further out of its box than that
+        auto couldBeCloser = [](const double bound, const float distance) { return bound <= std::abs(distance)*(1. + 1e-4) + 1e-3; };
+        const float y = GetPixelPoint(0, pixelY, glyphMin, glyphMax).y;
+        for(uint32_t start = 0; start < width; start += ENGINE_RENDERER_SDF_BATCH_SIZE) {
+            // The pixels of a batch are all in the same cell, so they share its sorted curves
+            const uint32_t amount = std::min<uint32_t>(ENGINE_RENDERER_SDF_BATCH_SIZE, width - start);
+            const std::vector<CurveGrid::Entry>& cell = grid._cells[(pixelY/ENGINE_RENDERER_SDF_GRID_CELL_SIZE)*grid._width + start/ENGINE_RENDERER_SDF_GRID_CELL_SIZE];
+            float x[ENGINE_RENDERER_SDF_BATCH_SIZE];
+            float lowestDistance[ENGINE_RENDERER_SDF_BATCH_SIZE];
+            uint32_t lowestCurve[ENGINE_RENDERER_SDF_BATCH_SIZE];
+            bool active[ENGINE_RENDERER_SDF_BATCH_SIZE];
+            for(uint32_t pixel = 0; pixel < ENGINE_RENDERER_SDF_BATCH_SIZE; pixel++) {
+                // The pixels past the row repeat the last one, they are never active
+                x[pixel] = GetPixelPoint(start + std::min(pixel, amount-1), pixelY, glyphMin, glyphMax).x;
+                lowestDistance[pixel] = FLOAT_MAX;
+                lowestCurve[pixel] = UINT32_MAX;
+            }
+            for(const CurveGrid::Entry& entry : cell) {
+                bool anyInCell = false;
+                bool anyActive = false;
+                for(uint32_t pixel = 0; pixel < ENGINE_RENDERER_SDF_BATCH_SIZE; pixel++) {
+                    const bool inCell = pixel < amount && couldBeCloser(entry._bound, lowestDistance[pixel]);
+                    const CurveBox point{ Util::Vec2D(x[pixel], y), Util::Vec2D(x[pixel], y) };
+                    active[pixel] = inCell && couldBeCloser(BoxDistance(grid._boxes[entry._curve], point), lowestDistance[pixel]);
+                    anyInCell |= inCell;
+                    anyActive |= active[pixel];
+                }
+                // Sorted, so none of the next curves can be closer either
+                if(!anyInCell) break;
+                if(!anyActive) continue;
+
+                const TriCurve& curve = curves[entry._curve];
+                float distance[ENGINE_RENDERER_SDF_BATCH_SIZE];
+                if(curve.curve.p3.x == FLOAT_MAX && curve.curve.p3.y == FLOAT_MAX) {
+                    DistanceBatch(curve, x, y, active, distance);
+                } else {
+                    for(uint32_t pixel = 0; pixel < ENGINE_RENDERER_SDF_BATCH_SIZE; pixel++) {
+                        if(active[pixel]) distance[pixel] = Distance(curve.prev, curve.curve, curve.next, Util::Vec2F(x[pixel], y), false);
+                    }
+                }
+                for(uint32_t pixel = 0; pixel < ENGINE_RENDERER_SDF_BATCH_SIZE; pixel++) {
+                    if(!active[pixel]) continue;
+                    if(std::abs(distance[pixel]) < std::abs(lowestDistance[pixel]) || (std::abs(distance[pixel]) == std::abs(lowestDistance[pixel]) && entry._curve < lowestCurve[pixel])) {
+                        lowestDistance[pixel] = distance[pixel];
+                        lowestCurve[pixel] = entry._curve;
+                    }
+                }
+            }
+            for(uint32_t pixel = 0; pixel < amount; pixel++) {
+                output[start + pixel] = GetFieldColor(lowestDistance[pixel], maxDistance);
+            }
         }
-        float color = std::clamp(((lowestDistance/_renderingMaxDistance)+0.5f), 0.f, 1.f);
+    }
+    Util::AreaU8 TextLoader::GetFieldColor(const float distance, const float maxDistance) {
+        float color = std::clamp(((distance/maxDistance)+0.5f), 0.f, 1.f);
         color = pow(color, 1.0f / 2.2f)*255.f;// UNORM -> SRGB
         return Util::AreaU8((uint8_t)color, (uint8_t)color, (uint8_t)color, 255);
     }
-
 }
 }
\ No newline at end of file
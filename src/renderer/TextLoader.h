@@ -15,6 +15,12 @@ namespace Renderer {
     #define ENGINE_RENDERER_GENERAL_RENDERSIZE 32
     #define ENGINE_RENDERER_SDF_PADDING 2
     #define ENGINE_RENDERER_PX_RANGE_FACTOR 0.5f
+    // The size in pixels of the cells the curves of a glyph are sorted for
+    #define ENGINE_RENDERER_SDF_GRID_CELL_SIZE 8
+    // The amount of pixels of a row that are compared to a curve at once, the cells of the grid must be a multiple of it
+    // The batches share the culling and the coefficients of the curves, the math is the same double precision as Distance
+    #define ENGINE_RENDERER_SDF_BATCH_SIZE 8
+    static_assert(ENGINE_RENDERER_SDF_GRID_CELL_SIZE % ENGINE_RENDERER_SDF_BATCH_SIZE == 0);
 
     struct CharInfo {
         Util::AreaF _textureArea;
@@ -23,11 +29,49 @@ namespace Renderer {
         Util::Vec2F _min;
         Util::Vec2F _max;
 
-        float _leftSideBearing;
-        float _advance;
-        std::map<char32_t, int16_t> _horizontalKerning;
+        float _leftSideBearing = 0;
+        float _advance = 0;
+    };
+    /**
+     * @brief The glyphs of every size of a text asset in one flat array
+     * Every size has the same characters, a character finds the index of its glyph through the ranges of consecutive characters.
+     * The kerning pairs of all the sizes are in one table, sorted on the size and then on the characters.
+     */
+    struct TextRenderInfo {
+        struct Range {
+            char32_t _first;
+            char32_t _last;
+            uint32_t _index;// The index of the first character
+        };
+        struct KerningPair {
+            uint32_t _size;// The index of the size
+            char32_t _left;
+            char32_t _right;
+            int16_t _kerning;
+
+            friend bool operator<(const KerningPair& a, const KerningPair& b) {
+                return std::tie(a._size, a._left, a._right) < std::tie(b._size, b._left, b._right);
+            }
+        };
+
+        // Sets the sizes and the characters (duplicates are removed), every glyph starts without texture and metrics
+        void Init(const std::vector<uint32_t>& sizes, std::vector<char32_t> characters);
+        // Returns UINT32_MAX when the size is not loaded
+        uint32_t GetSizeIndex(const uint32_t size) const;
+        // Returns UINT32_MAX when the character is not loaded
+        uint32_t GetCharacterIndex(const char32_t c) const;
+        inline CharInfo& GetGlyphAt(const uint32_t sizeIndex, const uint32_t characterIndex) { return _glyphs[(size_t)sizeIndex*_amountCharacters + characterIndex]; }
+        // Returns nullptr when the character is not loaded
+        const CharInfo* FindGlyph(const uint32_t sizeIndex, const char32_t c) const;
+        // The kerning of right when it follows left, 0 when the pair has no kerning
+        int16_t GetKerning(const uint32_t sizeIndex, const char32_t left, const char32_t right) const;
+
+        std::vector<uint32_t> _sizes;
+        std::vector<Range> _ranges;// Sorted on the characters
+        uint32_t _amountCharacters = 0;
+        std::vector<CharInfo> _glyphs;// All the characters of the first size, then all of the second size, ...
+        std::vector<KerningPair> _kerning;// Sorted
     };
-    typedef std::map<uint32_t, std::map<char32_t, CharInfo>> TextRenderInfo;
 
     class TextLoader : public AssetLoader {
     public:
@@ -36,13 +80,35 @@ namespace Renderer {
 
         void Init() override;
         size_t GetAmountTextures() override;
-        void SetTextureSizes(Util::Vec3U32* start) override;
+        void SetTextureSizes(Util::Vec3U32* start, Util::ThreadPool* threadPool) override;
         void RenderTexture(Util::AreaU8* texture, const Util::Vec2U32 textureSize, const Util::AreaU32 area, const size_t id) override;
 
         void SetTextureRenderInfo(const Util::AreaF area, const uint32_t boundTexture, const size_t id) override;
         std::shared_ptr<uint8_t> GetRenderInfo() override;
 
+        std::string GetCacheKey() override;
+        std::vector<Util::File> GetSourceFiles() override;
+        void WriteCache(std::vector<uint8_t>& data) override;
+        void ReadCache(std::vector<uint8_t>& data) override;
+
+        // The parsed and hinted outlines of every size are cached on disk by default, so the font is only parsed when it changed
+        // Disable it for loaders of which the characters change every time (like the batches of the glyph cache)
+        inline void DisableFontDataCache() { _cacheFontData = false; }
+
     private:
+        // What is stored in the cache of the outlines of one size
+        struct CachedFontData {
+            std::string _key;
+            double _generalScale;// The scale of ENGINE_RENDERER_GENERAL_RENDERSIZE, used for the sizes without font program
+            TTFFontParser::FontData _fontData;
+        };
+        // The ID of the cache of the outlines of the size, the key stored inside it identifies it completely
+        std::string GetFontDataKey(const uint32_t size);
+        bool ReadFontData(const uint32_t size, std::unique_ptr<TTFFontParser::FontData>& fontData, double& generalScale);
+        void WriteFontData(const uint32_t size, const TTFFontParser::FontData& fontData, const double generalScale);
+
+        // The render info without the texture areas, from the font data or from the cache
+        TextRenderInfo GetMetrics();
         struct Curve {
             Curve(const Util::Vec2D p3, const Util::Vec2D p2, const Util::Vec2D p1, const Util::Vec2D P0) : p3(p3), p2(p2), p1(p1), P0(P0) {}
             Curve() {}
@@ -58,20 +124,61 @@ namespace Renderer {
             Curve curve;
             Curve next;
         };
+        // The bounding box of the control points, the curve never leaves it
+        struct CurveBox {
+            Util::Vec2D _min;
+            Util::Vec2D _max;
+        };
+        /**
+         * @brief A grid over the pixels of a glyph, every cell has the curves sorted on their lowest possible distance to the cell
+         * A pixel walks the curves of its cell and stops at the first curve that cannot be closer than the closest one found,
+         * the result is the same as when every curve is evaluated.
+         */
+        struct CurveGrid {
+            struct Entry {
+                double _bound;// No pixel of the cell is closer to the curve
+                uint32_t _curve;
+            };
+            uint32_t _width = 0;
+            std::vector<CurveBox> _boxes;
+            std::vector<std::vector<Entry>> _cells;
+        };
+        static CurveBox GetBoundingBox(const Curve& curve);
+        // The distance between the two boxes, 0 when they overlap
+        static double BoxDistance(const CurveBox& a, const CurveBox& b);
+        // The point of a pixel of the texture in the coordinates of the glyph, y is flipped
+        static inline Util::Vec2F GetPixelPoint(const uint32_t x, const uint32_t y, const Util::Vec2F glyphMin, const Util::Vec2F glyphMax) {
+            return Util::Vec2F(x+0.5f+glyphMin.x-ENGINE_RENDERER_SDF_PADDING, glyphMax.y-(y+0.5f-ENGINE_RENDERER_SDF_PADDING));
+        }
+        static CurveGrid CreateCurveGrid(const std::vector<TriCurve>& curves, const Util::Vec2U32 size, const Util::Vec2F glyphMin, const Util::Vec2F glyphMax);
             
         inline float Orthogonality(const Curve& curve, const Util::Vec2D p, const bool start);
         inline float Distance(const Curve prev, const Curve curve, const Curve next, const Util::Vec2D p, const bool pseudo);
-        Util::AreaU8 CalculateSignedField(const float x, const float y);
+        /**
+         * @brief The same as Distance (not pseudo) for the active pixels of a batch of ENGINE_RENDERER_SDF_BATCH_SIZE points on one row
+         * The second degree calculates the coefficients of its cubic only once for the batch and solves the cubic per pixel.
+         * Third degree curves go through Distance.
+         * Debug builds compare every pixel with Distance.
+         */
+        void DistanceBatch(const TriCurve& curve, const float* x, const float y, const bool* active, float* distance);
+        // Whether the distance of a batch matches the distance of the reference within the rounding of the calculation
+        static inline bool IsSameDistance(const float batch, const float reference) {
+            // The sign of a curve without a closest point is not defined
+            return std::abs(batch) == std::abs(reference) || std::abs(batch - reference) <= 1e-3f + 1e-4f*std::abs(reference);
+        }
+        // Calculates a row of the signed distance field, a batch of pixels at the time
+        void CalculateSignedFieldRow(const std::vector<TriCurve>& curves, const CurveGrid& grid, const float maxDistance, const uint32_t pixelY, const uint32_t width, const Util::Vec2F glyphMin, const Util::Vec2F glyphMax, Util::AreaU8* output);
+        static Util::AreaU8 GetFieldColor(const float distance, const float maxDistance);
 
         Util::File _file;
         Characters _characters;
         std::vector<uint32_t> _sizes;
+        bool _cacheFontData = true;
             
         std::vector<std::unique_ptr<TTFFontParser::FontData>> _fontData;
         std::vector<std::pair<Util::AreaF, uint32_t>> _textureAreas;
-            
-        std::vector<TriCurve> _renderingCurves;
-        float _renderingMaxDistance;
+        // Only filled when the cache is used, the font is not parsed then
+        TextRenderInfo _cachedMetrics;
 
     };
 
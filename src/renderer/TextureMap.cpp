@@ -1,5 +1,8 @@
 #include "renderer/TextureMap.h"
 
+#include "util/Profiler.h"
+#include "util/serialization/Binary.h"
+
 namespace Engine {
 namespace Renderer {
 
@@ -7,6 +10,19 @@ namespace Renderer {
 
     }
     void TextureMap::Cleanup(Vulkan::Context& context, std::initializer_list<Vulkan::Pipeline*> boundToPipelines) {
+        // Stopped while uploading
+        if(_uploading) FinishUpload(context);
+        if(_uploadFence.size()) {
+            _uploadCommandBuffer.Cleanup(context);
+            _uploadCommandBuffer = Vulkan::CommandBuffer();
+            _uploadFence.clear();
+        }
+        _preparedTextures.clear();
+        _packedAreas.clear();
+        _packedAssetLoaders.clear();
+        _renderedAreas = 0;
+        _amountPreparedTextures = 0;
+        _uploadedTextures = 0;
         for(Vulkan::Texture& texture : _textures) {
             uint32_t slot = texture.GetBoundDescriptorSlot();
             for(Vulkan::Pipeline* pipeline : boundToPipelines) {
@@ -33,92 +49,277 @@ namespace Renderer {
         _cacheName = name;
     }
     void TextureMap::EndLoading(Vulkan::Context& context, std::initializer_list<Vulkan::Pipeline*> bindToPipelines) {
-        if(_amountTextures == 0) return;        
+        ENGINE_PROFILE_SCOPE("TextureMap::EndLoading")
+        Prepare();
+        while(!Upload(context, bindToPipelines, true)) {}
+    }
+
+    void TextureMap::Prepare(const bool render) {
+        ENGINE_PROFILE_SCOPE("TextureMap::Prepare")
+        if(_amountTextures == 0) return;
+        InitAssetLoaders();
+        if(ReadCache()) return;
+
+        // Its own pool, as Prepare can run next to the game loop that uses the pool of the game
+        // Shared by the loaders (one at a time) and the rendering of the areas
+        Util::ThreadPool threadPool;
+
         // Retrieve needed texture sizes
         RectanglePacker packer;
         packer.SetMaximumBinSize(ENGINE_RENDERER_MAX_IMAGE_SIZE);
         packer.SetAmountRectangles(_amountTextures);
         Util::Vec3U32* inputPtr = packer.GetRectangleInputPtr();// Get the location where the input should go
-        size_t currentTexture = 0;
         for(const auto& assetLoader : _assetLoaders) {
-            // Set all the variables
-            assetLoader->_firstTexture = currentTexture;
-            currentTexture += assetLoader->GetAmountTextures();
-            assetLoader->_lastTexture = currentTexture-1;
-            assetLoader->Init();
-
             // Retrieve the texture sizes needed for the loader
-            assetLoader->SetTextureSizes(inputPtr);
+            assetLoader->SetTextureSizes(inputPtr, &threadPool);
             inputPtr += assetLoader->GetAmountTextures();
         }
 
         // Pack
-        packer.SetPackingAlgorithm(RectanglePacker::PackingAlgorithm::Shelf);
+        packer.SetPackingAlgorithm(RectanglePacker::PackingAlgorithm::Automatic);
         packer.SetSortingAlgorithm(RectanglePacker::SortingAlgorithm::BigHeightFirst);
         packer.Pack();
+        for(const RectanglePacker::Statistics& statistics : packer.GetStatistics()) {
+            INFO("[Renderer::TextureMap] Packed " + std::to_string(_amountTextures) + " assets with " + RectanglePacker::GetName(statistics._algorithm) + " into "
+                + std::to_string(statistics._amountBins) + " textures, " + std::to_string((int)(statistics._occupancy * 100.f)) + "% occupied in " + std::to_string(statistics._packTime) + "ms")
+        }
 
-        // Create and render the textures
-        _textures.resize(packer.GetAmountBins());
-        _renderInfos.resize(_amountTextures);
+        _packedAreas.assign(packer.GetResults(), packer.GetResults() + _amountTextures);
+        _packedAssetLoaders.resize(_amountTextures);
+        for(size_t j = 0; j < _amountTextures; j++) {
+            _packedAssetLoaders[j] = GetAssetLoader(_packedAreas[j]._origID);
+        }
+        _preparedTextures.resize(packer.GetAmountBins());
         Util::Vec2U32* binSizePtr = packer.GetBinSizes();
-        Vulkan::CommandBuffer commandBuffer;
-        Vulkan::QueueType queueType = context.GetQueue(Vulkan::QueueType::TransferQueue)==VK_NULL_HANDLE? Vulkan::QueueType::GraphicsQueue : Vulkan::QueueType::TransferQueue;
-        commandBuffer.Init(context, queueType, 1);
-        for(size_t i = 0; i < _textures.size(); i++) {// i = current packed bin/current texture
-            _textures[i].Init(context, *binSizePtr, VK_FORMAT_R8G8B8A8_SRGB);
-            // Make sure all the pipelines when binding this descriptor return the same DescriptorBindingID
-            uint32_t descriptorBinding = (*bindToPipelines.begin())->BindTextureDescriptor(context, _textures[i]);
-            for(Vulkan::Pipeline* const* p = bindToPipelines.begin()+1; p<bindToPipelines.end(); p++) {
-                if(descriptorBinding!=(*p)->BindTextureDescriptor(context, _textures[i])) 
-                    THROW("[Renderer::TextureMap] EndLoading should receive pipelines with equal amount of textures and with exclusive acces to the bindings (nothing else should bind textures)")
-            }
+        for(size_t i = 0; i < _preparedTextures.size(); i++) {
+            _preparedTextures[i]._size = binSizePtr[i];
+        }
+        _amountPreparedTextures.store(_preparedTextures.size(), std::memory_order_relaxed);
+        if(!render) return;
 
-            _textures[i].StartTransferingData(context);
-            // Go through all the textures and render the once with this bin
-            // Going through them one-by-one to not overload the amount of transfer memory needed
-            RectanglePacker::ResultArea* resultPtr = packer.GetResults();
-            Util::AreaU8* texturePtr = reinterpret_cast<Util::AreaU8*>(_textures[i].GetTransferLocation());
-            for(size_t j = 0; j < _amountTextures; j++) {
-                // Check if this rectangle should be rendered on texture with ID=i
-                if(resultPtr->_bin != i) { resultPtr++; continue; }
-                // Get the asset loader the area belongs to
-                size_t assetLoader;
-                for(assetLoader = 0; assetLoader < _assetLoaders.size(); assetLoader++) {
-                    if(_assetLoaders[assetLoader]->_firstTexture <= resultPtr->_origID &&
-                    _assetLoaders[assetLoader]->_lastTexture >= resultPtr->_origID) break;
+        // Render the textures into CPU memory, the upload copies them to the transfer memory one texture at a time
+        for(PreparedTexture& texture : _preparedTextures) {
+            texture._pixels.resize((size_t)texture._size.x * texture._size.y);
+        }
+        {
+            ENGINE_PROFILE_SCOPE("TextureMap::RenderTextures")
+            // The areas do not overlap, so every area can be rendered by another thread
+            // The pool cannot throw, the first error is thrown again after all the areas are done
+            std::exception_ptr error;
+            std::mutex errorMutex;
+            threadPool.ParallelFor(_amountTextures, 1, [&](const size_t batch, const size_t j, const size_t end) {
+                try {
+                    PreparedTexture& texture = _preparedTextures[_packedAreas[j]._bin];
+                    const std::shared_ptr<AssetLoader>& assetLoader = _assetLoaders[_packedAssetLoaders[j]];
+                    assetLoader->RenderTexture(texture._pixels.data(), texture._size, _packedAreas[j]._area, j-assetLoader->_firstTexture);
+                } catch(...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if(!error) error = std::current_exception();
                 }
-                ASSERT(assetLoader < _assetLoaders.size(), "[TextureMap::EndLoading] Failed to find the asset loader associated with a packed texture")
-                // Render the texture with the asset loader
-                _assetLoaders[assetLoader]->RenderTexture(texturePtr, *binSizePtr, resultPtr->_area, j-_assetLoaders[assetLoader]->_firstTexture);
-                _assetLoaders[assetLoader]->SetTextureRenderInfo(
-                    Util::AreaF((float)resultPtr->_area.x/binSizePtr->x, (float)resultPtr->_area.y/binSizePtr->y, (float)resultPtr->_area.w/binSizePtr->x, (float)resultPtr->_area.h/binSizePtr->y), 
-                    descriptorBinding, 
-                    j-_assetLoaders[assetLoader]->_firstTexture
-                );
-
-                resultPtr++;
+                _renderedAreas.fetch_add(1, std::memory_order_relaxed);
+            });
+            if(error) std::rethrow_exception(error);
+        }
+        WriteCache();
+    }
+    void TextureMap::InitAssetLoaders() {
+        size_t currentTexture = 0;
+        for(const auto& assetLoader : _assetLoaders) {
+            assetLoader->_firstTexture = currentTexture;
+            currentTexture += assetLoader->GetAmountTextures();
+            assetLoader->_lastTexture = currentTexture-1;
+            assetLoader->Init();
+        }
+    }
+
+    std::string TextureMap::GetCacheKey() const {
+        // Everything that changes the packing is part of the key as well
+        const Util::Vec2U32 maxSize = ENGINE_RENDERER_MAX_IMAGE_SIZE;
+        std::string key = std::to_string(maxSize.x) + "x" + std::to_string(maxSize.y);
+        for(const auto& assetLoader : _assetLoaders) {
+            const std::string loaderKey = assetLoader->GetCacheKey();
+            if(loaderKey.empty()) return "";
+            key += ";" + loaderKey;
+        }
+        return key;
+    }
+    bool TextureMap::ReadCache() {
+        ENGINE_PROFILE_SCOPE("TextureMap::ReadCache")
+        if(_cacheName.empty()) return false;
+        const std::string key = GetCacheKey();
+        if(key.empty()) return false;
+        std::vector<Util::File> sourceFiles;
+        for(const auto& assetLoader : _assetLoaders) {
+            std::vector<Util::File> files = assetLoader->GetSourceFiles();
+            sourceFiles.insert(sourceFiles.end(), files.begin(), files.end());
+        }
+        if(!Util::FileManager::CanUseCache(_cacheName + ".texturemap", sourceFiles)) return false;
+
+        CachedTextureMap cache;
+        std::vector<PreparedTexture> textures;
+        try {
+            std::vector<uint8_t> data;
+            Util::FileManager::Cache(_cacheName + ".texturemap").Read(data);
+            Util::BinaryDeserializer deserializer;
+            deserializer.Deserialize(cache, data);
+            if(cache._key != key || cache._packedAreas.size() != _amountTextures || cache._assetLoaderData.size() != _assetLoaders.size()) return false;
+
+            textures.resize(cache._textureSizes.size());
+            for(size_t i = 0; i < textures.size(); i++) {
+                const Util::File file = Util::FileManager::Cache(_cacheName + "_" + std::to_string(i) + ".texture");
+                textures[i]._size = cache._textureSizes[i];
+                textures[i]._pixels.resize((size_t)textures[i]._size.x * textures[i]._size.y);
+                if(!file.Exists() || file.GetSize() != textures[i]._pixels.size()*sizeof(Util::AreaU8)) return false;
+                file.Read(textures[i]._pixels.data(), textures[i]._pixels.size());
+            }
+            for(size_t i = 0; i < _assetLoaders.size(); i++) {
+                _assetLoaders[i]->ReadCache(cache._assetLoaderData[i]);
             }
-            binSizePtr++;
-            if(i!=0) {
-                context.WaitQueueIdle(queueType);
-                _textures[i-1].TransferCompleteOnCommandBuffer(context);
+        } catch(...) {
+            WARNING("[Renderer::TextureMap] Failed to read the cached texture map '" + _cacheName + "', rendering the assets again")
+            return false;
+        }
+        _packedAreas = std::move(cache._packedAreas);
+        _packedAssetLoaders.resize(_amountTextures);
+        for(size_t j = 0; j < _amountTextures; j++) {
+            _packedAssetLoaders[j] = GetAssetLoader(_packedAreas[j]._origID);
+        }
+        _preparedTextures = std::move(textures);
+        _amountPreparedTextures.store(_preparedTextures.size(), std::memory_order_relaxed);
+        _renderedAreas.store(_amountTextures, std::memory_order_relaxed);
+        INFO("[Renderer::TextureMap] Loaded the texture map '" + _cacheName + "' from the cache")
+        return true;
+    }
+    void TextureMap::WriteCache() {
+        ENGINE_PROFILE_SCOPE("TextureMap::WriteCache")
+        if(_cacheName.empty()) return;
+        CachedTextureMap cache;
+        cache._key = GetCacheKey();
+        if(cache._key.empty()) {
+            WARNING("[Renderer::TextureMap] Not every asset loader of '" + _cacheName + "' can be cached, the texture map is not cached")
+            return;
+        }
+        try {
+            // The pixels first, the texture map file is what is checked against the source files
+            for(size_t i = 0; i < _preparedTextures.size(); i++) {
+                PreparedTexture& texture = _preparedTextures[i];
+                Util::FileManager::Cache(_cacheName + "_" + std::to_string(i) + ".texture").Write(texture._pixels.data(), texture._pixels.size());
+                cache._textureSizes.push_back(texture._size);
             }
-            commandBuffer.StartRecording(context, UINT32_MAX, true);
-            _textures[i].EndTransferingData(context, commandBuffer);
-            commandBuffer.EndRecording();
-            commandBuffer.Submit(context);
-            
+            cache._packedAreas = _packedAreas;
+            cache._assetLoaderData.resize(_assetLoaders.size());
+            for(size_t i = 0; i < _assetLoaders.size(); i++) {
+                _assetLoaders[i]->WriteCache(cache._assetLoaderData[i]);
+            }
+            std::vector<uint8_t> data;
+            Util::BinarySerializer serializer;
+            serializer.Serialize(cache, data);
+            Util::FileManager::Cache(_cacheName + ".texturemap").Write(data);
+        } catch(...) {
+            WARNING("[Renderer::TextureMap] Failed to write the cache of the texture map '" + _cacheName + "'")
+        }
+    }
+
+    bool TextureMap::Upload(Vulkan::Context& context, std::initializer_list<Vulkan::Pipeline*> bindToPipelines, const bool wait, const std::function<void()>& beforeBinding) {
+        ENGINE_PROFILE_SCOPE("TextureMap::Upload")
+        if(_amountTextures == 0) return true;
+        if(_uploading) {
+            if(!wait && !_uploadCommandBuffer.IsFenceSignaled(context, _uploadFence)) return false;
+            FinishUpload(context);
+        }
+        const size_t uploaded = _uploadedTextures.load(std::memory_order_relaxed);
+        if(uploaded == _preparedTextures.size()) {
+            StoreRenderInfos();
+            _uploadCommandBuffer.Cleanup(context);
+            _uploadCommandBuffer = Vulkan::CommandBuffer();
+            _uploadFence.clear();
+            return true;
         }
-        context.WaitQueueIdle(queueType);
-        _textures[_textures.size() - 1].TransferCompleteOnCommandBuffer(context);
 
-        // Render infos
+        if(uploaded == 0) {
+            _textures.reserve(_preparedTextures.size());
+            _uploadQueue = context.GetQueue(Vulkan::QueueType::TransferQueue)==VK_NULL_HANDLE? Vulkan::QueueType::GraphicsQueue : Vulkan::QueueType::TransferQueue;
+            _uploadCommandBuffer.Init(context, _uploadQueue, 1);
+            _uploadFence = _uploadCommandBuffer.CreateFence(context, false);
+        }
+        const size_t i = uploaded;
+        PreparedTexture& prepared = _preparedTextures[i];
+        // Only add the texture now, so a cleanup while uploading only sees initialized textures
+        _textures.emplace_back();
+        _textures[i].Init(context, prepared._size, VK_FORMAT_R8G8B8A8_SRGB);
+        if(beforeBinding) beforeBinding();
+        // Make sure all the pipelines when binding this descriptor return the same DescriptorBindingID
+        uint32_t descriptorBinding = (*bindToPipelines.begin())->BindTextureDescriptor(context, _textures[i]);
+        for(Vulkan::Pipeline* const* p = bindToPipelines.begin()+1; p<bindToPipelines.end(); p++) {
+            if(descriptorBinding!=(*p)->BindTextureDescriptor(context, _textures[i])) 
+                THROW("[Renderer::TextureMap] EndLoading should receive pipelines with equal amount of textures and with exclusive acces to the bindings (nothing else should bind textures)")
+        }
+        // The descriptor binding is only known now
+        SetTextureRenderInfos(i, descriptorBinding);
+
+        _textures[i].StartTransferingData(context);
+        std::memcpy(_textures[i].GetTransferLocation(), prepared._pixels.data(), prepared._pixels.size()*sizeof(Util::AreaU8));
+        prepared._pixels = std::vector<Util::AreaU8>();
+        _uploadCommandBuffer.StartRecording(context, UINT32_MAX, true);
+        _textures[i].EndTransferingData(context, _uploadCommandBuffer);
+        _uploadCommandBuffer.EndRecording();
+        _uploadCommandBuffer.Submit(context, {}, {}, _uploadFence);
+        _uploading = true;
+        return false;
+    }
+    void TextureMap::SkipUpload() {
+        if(_amountTextures == 0) return;
+        for(size_t i = 0; i < _preparedTextures.size(); i++) SetTextureRenderInfos(i, 0);
+        StoreRenderInfos();
+    }
+    void TextureMap::SetTextureRenderInfos(const size_t bin, const uint32_t descriptorBinding) {
+        const Util::Vec2U32 size = _preparedTextures[bin]._size;
+        for(size_t j = 0; j < _amountTextures; j++) {
+            if(_packedAreas[j]._bin != bin) continue;
+            const Util::AreaU32 area = _packedAreas[j]._area;
+            const std::shared_ptr<AssetLoader>& assetLoader = _assetLoaders[_packedAssetLoaders[j]];
+            assetLoader->SetTextureRenderInfo(
+                Util::AreaF((float)area.x/size.x, (float)area.y/size.y, (float)area.w/size.x, (float)area.h/size.y), 
+                descriptorBinding, 
+                j-assetLoader->_firstTexture
+            );
+        }
+    }
+    void TextureMap::StoreRenderInfos() {
+        _renderInfos.resize(_assetLoaders.size());
         for(size_t i = 0; i < _assetLoaders.size(); i++) {
             _renderInfos[i] = _assetLoaders[i]->GetRenderInfo();
         }
 
         // Remove the loaders
         _assetLoaders.clear();
+        _preparedTextures.clear();
+        _packedAreas.clear();
+        _packedAssetLoaders.clear();
+    }
+    void TextureMap::FinishUpload(Vulkan::Context& context) {
+        _uploadCommandBuffer.WaitFence(context, _uploadFence);
+        const size_t uploaded = _uploadedTextures.load(std::memory_order_relaxed);
+        _textures[uploaded].TransferCompleteOnCommandBuffer(context);
+        _uploadedTextures.store(uploaded+1, std::memory_order_relaxed);
+        _uploading = false;
+    }
+
+    float TextureMap::GetProgress() const {
+        if(_amountTextures == 0) return 1;
+        // Rendering an area and uploading a texture count as one step each
+        const size_t steps = _amountTextures + _amountPreparedTextures.load(std::memory_order_relaxed);
+        const size_t done = _renderedAreas.load(std::memory_order_relaxed) + _uploadedTextures.load(std::memory_order_relaxed);
+        return (float)done/steps;
+    }
+
+    size_t TextureMap::GetAssetLoader(const size_t textureID) const {
+        // The loaders are sorted on their first texture, the owner is the last loader that starts at or before the texture
+        auto it = std::upper_bound(_assetLoaders.begin(), _assetLoaders.end(), textureID, [](const size_t id, const std::shared_ptr<AssetLoader>& assetLoader) {
+            return id < assetLoader->_firstTexture;
+        });
+        ASSERT(it != _assetLoaders.begin() && textureID <= (*(it-1))->_lastTexture, "[TextureMap::EndLoading] Failed to find the asset loader associated with a packed texture")
+        return (size_t)(it - _assetLoaders.begin()) - 1;
     }
     
     std::shared_ptr<uint8_t> TextureMap::GetRenderInfo(const uint32_t id) {
@@ -9,6 +9,7 @@
 #include "renderer/RectanglePacker.h"
 
 #include "util/FileManager.h"
+#include "util/ThreadPool.h"
 
 #ifndef ENGINE_RENDERER_MAX_IMAGE_SIZE
 #define ENGINE_RENDERER_MAX_IMAGE_SIZE Util::Vec2U32(1920, 1080)
@@ -29,9 +30,11 @@ namespace Renderer {
         // Only the x and y has to be set, the z is for internal use
         // If the cache is not used, this function will be the first to be called (you can init your loading utilities here)
         // Garantueed to only be called once
-        virtual void SetTextureSizes(Util::Vec3U32* start) = 0;
+        // The thread pool can be used to split up the work, it is nullptr when the caller has none
+        virtual void SetTextureSizes(Util::Vec3U32* start, Util::ThreadPool* threadPool) = 0;
         // Should render the texture with requested id on the requested texture at the requested area
         // ID=n is the nth texture returned in SetTextureSizes
+        // Is called from multiple threads at the same time (with different IDs), so it should only write to the given area
         virtual void RenderTexture(Util::AreaU8* texture, const Util::Vec2U32 textureSize, const Util::AreaU32 area, const size_t id) = 0;
 
         // Called with the area and descriptor binding for the ID
@@ -42,6 +45,16 @@ namespace Renderer {
         // Called after every texture has been called to render
         // Needs to return the information neccesary to render the assets
         virtual std::shared_ptr<uint8_t> GetRenderInfo() = 0;
+
+        // The functions below are optional, a texture map is only cached when all its loaders implement them (see TextureMap::SetCacheName)
+        // Should return an identifier of everything besides the source files that changes the textures, an empty string disables the cache
+        virtual std::string GetCacheKey() { return ""; }
+        // Should return the files the textures are made from, the cache is rebuilt when one of them changed
+        virtual std::vector<Util::File> GetSourceFiles() { return {}; }
+        // Should write everything GetRenderInfo needs besides the texture render info, called after all the textures are rendered
+        virtual void WriteCache(std::vector<uint8_t>& data) {}
+        // Called instead of SetTextureSizes and RenderTexture when the cache is used, with the data written by WriteCache
+        virtual void ReadCache(std::vector<uint8_t>& data) {}
     
     private:
         friend class TextureMap;
@@ -57,8 +70,24 @@ namespace Renderer {
 
         void StartLoading();
         uint32_t AddTextureLoader(std::shared_ptr<AssetLoader> textureLoader);
+        // Stores the packed textures in the cache directory under this name, the next Prepare reads them instead of rendering the assets
         void SetCacheName(const std::string name);
+        // Same as calling Prepare and then Upload until it returns true
         void EndLoading(Vulkan::Context& context, std::initializer_list<Vulkan::Pipeline*> bindToPipelines);
+        // Decodes, packs and renders all the assets into CPU memory, the assets are rendered on multiple threads
+        // Does not use vulkan, so it can run on a worker thread while the other texture maps are used for drawing
+        // Without render only the texture sizes are retrieved and packed, for SkipUpload
+        void Prepare(const bool render = true);
+        // Uploads one prepared texture per call on the transfer queue, returns true when all the assets are loaded
+        // Must be called from the thread that draws, between two frames
+        // If wait is false it returns immediately when the previous upload is still busy
+        // beforeBinding is called right before the descriptor sets are updated, so the caller can wait for the frames that use them
+        bool Upload(Vulkan::Context& context, std::initializer_list<Vulkan::Pipeline*> bindToPipelines, const bool wait, const std::function<void()>& beforeBinding = {});
+        // Instead of Upload when there is no GPU, gives the assets their render info without creating textures
+        // Nothing can be drawn with the assets, but their sizes and metrics can be used
+        void SkipUpload();
+        // Between 0 and 1, safe to call from any thread
+        float GetProgress() const;
 
         std::shared_ptr<uint8_t> GetRenderInfo(const uint32_t id);
 
@@ -70,6 +99,44 @@ namespace Renderer {
         std::string _cacheName;
         std::vector<Vulkan::Texture> _textures;
 
+        // Filled by Prepare, consumed by Upload
+        struct PreparedTexture {
+            Util::Vec2U32 _size;
+            std::vector<Util::AreaU8> _pixels;
+        };
+        std::vector<PreparedTexture> _preparedTextures;
+        std::vector<RectanglePacker::ResultArea> _packedAreas;
+        std::vector<size_t> _packedAssetLoaders;// The asset loader of every packed area
+        std::atomic<size_t> _renderedAreas = 0;
+        std::atomic<size_t> _amountPreparedTextures = 0;
+        std::atomic<size_t> _uploadedTextures = 0;
+        Vulkan::CommandBuffer _uploadCommandBuffer;
+        Vulkan::Fence _uploadFence;
+        Vulkan::QueueType _uploadQueue;
+        bool _uploading = false;
+
+        // What is stored in the cache next to the pixels of every texture
+        struct CachedTextureMap {
+            std::string _key;
+            std::vector<Util::Vec2U32> _textureSizes;
+            std::vector<RectanglePacker::ResultArea> _packedAreas;
+            std::vector<std::vector<uint8_t>> _assetLoaderData;
+        };
+
+        size_t GetAssetLoader(const size_t textureID) const;
+        void FinishUpload(Vulkan::Context& context);
+        // Gives the asset loaders the area of their textures in the bin
+        void SetTextureRenderInfos(const size_t bin, const uint32_t descriptorBinding);
+        // Retrieves the render infos and drops the asset loaders and everything prepared for them
+        void StoreRenderInfos();
+        // Sets the texture range of every asset loader and initializes them
+        void InitAssetLoaders();
+        // Returns an empty string when one of the loaders cannot be cached
+        std::string GetCacheKey() const;
+        // Fills the prepared textures from the cache, returns false when the cache cannot be used
+        bool ReadCache();
+        void WriteCache();
+
     };
 
 }
@@ -1,10 +1,14 @@
 #include "renderer/Window.h"
 #include <bitset>
 
+#include "util/Profiler.h"
+
 namespace Engine {
 namespace Renderer {
     
-    void Window::Init(const uint32_t textureMapSlots) {
+    void Window::Init(const uint32_t textureMapSlots, const uint32_t framesInFlight) {
+        ASSERT(framesInFlight > 0, "[Renderer::Window] Needs at least one frame in flight")
+        _framesInFlight = framesInFlight;
         glfwSetErrorCallback([](int errorCode, const char* error) {
             WARNING("[Renderer::Window] GLFW error: '" + std::string(error) + "'")
         });
@@ -43,9 +47,9 @@ namespace Renderer {
         // Rect pipeline
         Vulkan::PipelineCreator rectPipelineInfo;
         rectPipelineInfo.SetShaders({ "engine/shaders/rect.vert", "engine/shaders/rect.frag" });
-        rectPipelineInfo.SetVertexInput({Vulkan::Vertex::UInt }, { Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec3, Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2, Vulkan::Vertex::UInt });
+        rectPipelineInfo.SetVertexInput({Vulkan::Vertex::UInt }, { Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2, Vulkan::Vertex::Float, Vulkan::Vertex::UNorm8Vec4, Vulkan::Vertex::UNorm16Vec4, Vulkan::Vertex::UInt });
         rectPipelineInfo.SetDynamicState({ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR });
-        rectPipelineInfo.SetDescriptorInfo(2, 16, 2, 0);
+        rectPipelineInfo.SetDescriptorInfo(_framesInFlight, 16, 2, 0);
         rectPipelineInfo.SetPushConstantInput({ Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2 }, VK_SHADER_STAGE_VERTEX_BIT);
         rectPipelineInfo.EnableAlphaBlending();
         _vkRectPipeline.Init(rectPipelineInfo, _vkContext, _vkRenderPass, 0);
@@ -55,12 +59,12 @@ namespace Renderer {
         textPipelineInfo.SetShaders({ "engine/shaders/text.vert", "engine/shaders/text.frag" });
         textPipelineInfo.SetVertexInput({Vulkan::Vertex::Vec2 }, { Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec3, Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2, Vulkan::Vertex::UInt, Vulkan::Vertex::Float });
         textPipelineInfo.SetDynamicState({ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR });
-        textPipelineInfo.SetDescriptorInfo(2, 16, 2, 0);
+        textPipelineInfo.SetDescriptorInfo(_framesInFlight, 16, 2, 0);
         textPipelineInfo.SetPushConstantInput({ Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2 }, VK_SHADER_STAGE_VERTEX_BIT);
         textPipelineInfo.EnableAlphaBlending();
         _vkTextPipeline.Init(textPipelineInfo, _vkContext, _vkRenderPass, 1);
 
-        _vkCommandBuffer.Init(_vkContext, Vulkan::QueueType::GraphicsQueue, 2);
+        _vkCommandBuffer.Init(_vkContext, Vulkan::QueueType::GraphicsQueue, _framesInFlight);
         _vkInFlightFence = _vkCommandBuffer.CreateFence(_vkContext, true);
         _vkImageAvailableSemaphore = _vkCommandBuffer.CreateSemaphore(_vkContext);
         _vkRenderFinishedSemaphore = _vkCommandBuffer.CreateSemaphore(_vkContext);
@@ -73,8 +77,9 @@ namespace Renderer {
         _vkTextPerVertexBuffer.Init(_vkContext, sizeof(VertexDataText) * 4);
         _vkTextPerVertexBuffer.SetData(_vkContext, textRectangleData);
 
-        _vkRectVertexBuffer.Init(_vkContext, sizeof(InstanceDataRect) * 4);
-        _vkTextVertexBuffer.Init(_vkContext, sizeof(InstanceDataText) * 4);
+        _vkInstanceBuffer.Init(_vkContext, ENGINE_RENDERER_INSTANCE_BUFFER_SIZE, _framesInFlight);
+        _rectCache.Init(_vkContext, ENGINE_RENDERER_INSTANCE_BUFFER_SIZE / sizeof(InstanceDataRect));
+        _textCache.Init(_vkContext, ENGINE_RENDERER_INSTANCE_BUFFER_SIZE / sizeof(InstanceDataText));
 
         Vulkan::TransferBuffer indexTransfer;
         indexTransfer.Init(_vkContext, 6*sizeof(uint16_t));
@@ -83,7 +88,10 @@ namespace Renderer {
         indexTransfer.CopyTo(_vkContext, &_vkIndexBuffer);
         indexTransfer.Cleanup(_vkContext);
         
-        _textureMaps.resize(textureMapSlots);
+        // Texture maps can't be moved (they are shared with the loading threads), so construct them in place
+        ASSERT(textureMapSlots < ENGINE_RENDERER_DYNAMIC_TEXTUREMAP_ID, "[Renderer::Window] The last texture map ID is used by the dynamic assets")
+        _textureMaps = std::vector<TextureMap>(textureMapSlots);
+        _dynamicTextureMap.Init(_framesInFlight);
         
         _pixelSampler.Init(_vkContext, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
         _vkRectPipeline.BindSamplerDescriptor(_vkContext, _pixelSampler, 0);
@@ -98,16 +106,32 @@ namespace Renderer {
         debugPipelineInfo.SetShaders({ "engine/shaders/debug.vert", "engine/shaders/debug.frag" });
         debugPipelineInfo.SetVertexInput({ Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec3 });
         debugPipelineInfo.SetDynamicState({ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR });
-        debugPipelineInfo.SetDescriptorInfo(2, 0, 0, 0);
+        debugPipelineInfo.SetDescriptorInfo(_framesInFlight, 0, 0, 0);
         debugPipelineInfo.SetPushConstantInput({ Vulkan::Vertex::Vec2, Vulkan::Vertex::Vec2 }, VK_SHADER_STAGE_VERTEX_BIT);
         debugPipelineInfo.SetInputAssembly(VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_LINE_LIST, 0);
         debugPipelineInfo.EnableAlphaBlending();
         _vkDebugPipeline.Init(debugPipelineInfo, _vkContext, _vkRenderPass, 2);
-
-        _vkDebugVertexBuffer.Init(_vkContext, 1);
 #endif
     }
+    void Window::InitHeadless(const uint32_t textureMapSlots) {
+        _headless = true;
+        ASSERT(textureMapSlots < ENGINE_RENDERER_DYNAMIC_TEXTUREMAP_ID, "[Renderer::Window] The last texture map ID is used by the dynamic assets")
+        _textureMaps = std::vector<TextureMap>(textureMapSlots);
+        _dynamicTextureMap.Init(1, true);
+    }
     void Window::Cleanup() {
+        if(_headless) {
+            // Nothing was created on the GPU
+            for(TextureMap& textureMap : _textureMaps) {
+                textureMap.Cleanup(_vkContext, {});
+            }
+            for(std::unique_ptr<GlyphCache>& glyphCache : _glyphCaches) {
+                glyphCache->Cleanup(_dynamicTextureMap);
+            }
+            _glyphCaches.clear();
+            _dynamicTextureMap.Cleanup(_vkContext, {});
+            return;
+        }
         _vkContext.WaitIdle();
 
         _pixelSampler.Cleanup(_vkContext);
@@ -116,15 +140,20 @@ namespace Renderer {
         for(TextureMap& textureMap : _textureMaps) {
             textureMap.Cleanup(_vkContext, { &_vkRectPipeline, &_vkTextPipeline });
         }
+        for(std::unique_ptr<GlyphCache>& glyphCache : _glyphCaches) {
+            glyphCache->Cleanup(_dynamicTextureMap);
+        }
+        _glyphCaches.clear();
+        _dynamicTextureMap.Cleanup(_vkContext, { &_vkRectPipeline, &_vkTextPipeline });
         _vkIndexBuffer.Cleanup(_vkContext);
         _vkRectPerVertexBuffer.Cleanup(_vkContext);
-        _vkRectVertexBuffer.Cleanup(_vkContext);
         _vkTextPerVertexBuffer.Cleanup(_vkContext);
-        _vkTextVertexBuffer.Cleanup(_vkContext);
+        _vkInstanceBuffer.Cleanup(_vkContext);
+        _rectCache.Cleanup(_vkContext);
+        _textCache.Cleanup(_vkContext);
 
 #if ENGINE_ENABLE_DEBUG_GRAPHICS
         _vkDebugPipeline.Cleanup(_vkContext);
-        _vkDebugVertexBuffer.Cleanup(_vkContext);
 #endif
 
         _vkCommandBuffer.Cleanup(_vkContext);
@@ -147,7 +176,8 @@ namespace Renderer {
     void Window::Update() {
         glfwPollEvents();
     }
-    void Window::Draw(entt::registry& registry, const uint32_t amountRectangles, const uint32_t amountText) {
+    void Window::Draw(entt::registry& registry, const uint32_t amountRectangles, const uint32_t amountText, const ChangeTracker* changes) {
+        ENGINE_PROFILE_SCOPE("Window::Draw")
         if(_framebufferResized) {
             _framebufferResized = false; 
             int width = 0, height = 0;
@@ -159,50 +189,61 @@ namespace Renderer {
         }
         if(_framebufferSize.x == 0 || _framebufferSize.y == 0) return;
 
-        _vkRectVertexBuffer.Resize(_vkContext, amountRectangles*sizeof(InstanceDataRect));
-        _vkTextVertexBuffer.Resize(_vkContext, amountText*sizeof(InstanceDataText));
-
-        {// Rectangle data
-			auto group = registry.group<Component::Texture>(entt::get<Component::Position>);
-            _vkRectVertexBuffer.StartTransferingData(_vkContext);
-			for (const auto [entity, texture, pos] : group.each()) {
-				_vkRectVertexBuffer.AddData(InstanceDataRect(
-                    pos.GetPrecalculated(texture._size.x, texture._size.y),
-                    Util::Vec3F(1.f, 1.f, 1.f),
-                    Util::Vec2F(texture._textureArea.x, texture._textureArea.y),
-                    Util::Vec2F(texture._textureArea.w, texture._textureArea.h),
-                    texture._descriptorID
-                ));
-			}
-            _vkRectVertexBuffer.EndTransferingData(_vkContext, _vkCommandBuffer);
-		}
-        {// Text data
-			auto group = registry.group<Component::Text>(entt::get<Component::Position>);
-            _vkTextVertexBuffer.StartTransferingData(_vkContext);
-			for (const auto [entity, text, pos] : group.each()) {
-                float x = pos._pos.x;
-                float y = pos._pos.y;
-            for(const auto renderInfo : text._renderInfo) {
-                x = pos._pos.x + renderInfo._position.x;
-                y = pos._pos.y + renderInfo._position.y;
-                _vkTextVertexBuffer.AddData(InstanceDataText(
-                    Util::Vec2F(x , y),
-                    Util::Vec2F(renderInfo._position.w , renderInfo._position.h),
-                    Util::Vec3F(1.f, 1.f, 1.f),
-                    Util::Vec2F(renderInfo._textureArea.x, renderInfo._textureArea.y), 
-                    Util::Vec2F(renderInfo._textureArea.w, renderInfo._textureArea.h),
-                    renderInfo._descriptorID,
-                    renderInfo._pxRange
-                ));
+        // Wait until the GPU is done with the command buffer and instance buffers of this frame in flight
+        _vkCommandBuffer.NextFrameInFlight();
+        const uint32_t frame = _vkCommandBuffer.GetCurrentFrameInFlight();
+        _vkCommandBuffer.WaitFence(_vkContext, _vkInFlightFence);
+        _vkCommandBuffer.StartRecording(_vkContext);
+        // The assets added since the last frame
+        _dynamicTextureMap.Upload(_vkContext, _vkCommandBuffer, frame);
+
+#if ENGINE_ENABLE_DEBUG_GRAPHICS
+        const uint32_t debugSize = (uint32_t)(_debugLines.size()*sizeof(DebugLine));
+#else
+        const uint32_t debugSize = 0;
+#endif
+        uint32_t rectOffset = 0;
+        uint32_t textOffset = 0;
+        [[maybe_unused]] uint32_t debugOffset = 0;
+        // The instances to draw, everything outside the camera is left out
+        const Physics::AABB camera = Physics::AABB::FromCorners(_cameraPosition - (_framebufferSize*0.5f), _cameraPosition + (_framebufferSize*0.5f));
+        std::pmr::vector<InstanceRange> rectRuns(_frameMemory);
+        std::pmr::vector<InstanceRange> textRuns(_frameMemory);
+        if(changes) {
+            // Retained mode, only the instances that changed are copied into the gpu local caches
+            SyncInstanceCaches(registry, *changes);
+            const uint32_t rectUpload = _rectCache.PrepareUpload(_vkContext);
+            const uint32_t textUpload = _textCache.PrepareUpload(_vkContext);
+            _vkInstanceBuffer.StartFrame(_vkContext, frame, { rectUpload, textUpload, debugSize });
+            if(rectUpload || textUpload) {
+                // The frames in flight may still read the instances that get overwritten
+                _vkCommandBuffer.PipelineBarrier(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+                _rectCache.Upload(_vkCommandBuffer, _vkInstanceBuffer);
+                _textCache.Upload(_vkCommandBuffer, _vkInstanceBuffer);
+                _vkCommandBuffer.PipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
             }
-			}
-            _vkTextVertexBuffer.EndTransferingData(_vkContext, _vkCommandBuffer);
-		}
+            CullInstanceCaches(camera, rectRuns, textRuns);
+        } else {
+            const uint32_t rectSize = amountRectangles*sizeof(InstanceDataRect);
+            const uint32_t textSize = amountText*sizeof(InstanceDataText);
+            _vkInstanceBuffer.StartFrame(_vkContext, frame, { rectSize, textSize, debugSize });
+            rectOffset = _vkInstanceBuffer.Allocate(rectSize);
+            textOffset = _vkInstanceBuffer.Allocate(textSize);
+            _cullingStatistics = _instanceWriter.Write(
+                registry, camera,
+                static_cast<InstanceDataRect*>(_vkInstanceBuffer.GetMappedData(rectOffset)), amountRectangles,
+                static_cast<InstanceDataText*>(_vkInstanceBuffer.GetMappedData(textOffset)), amountText
+            );
+            rectRuns.push_back(InstanceRange{0, _cullingStatistics._visibleRectangles});
+            textRuns.push_back(InstanceRange{0, _cullingStatistics._visibleCharacters});
+        }
+        debugOffset = _vkInstanceBuffer.Allocate(debugSize);
+#if ENGINE_ENABLE_DEBUG_GRAPHICS
+        if(debugSize) memcpy(_vkInstanceBuffer.GetMappedData(debugOffset), _debugLines.data(), debugSize);
+#endif
+        _vkInstanceBuffer.EndFrame(_vkContext);
 
         _vkCommandBuffer.AcquireNextSwapchainFrame(_vkContext, _vkSwapchain, _vkImageAvailableSemaphore);
-        _vkCommandBuffer.WaitFence(_vkContext, _vkInFlightFence);
-
-        _vkCommandBuffer.StartRecording(_vkContext);
         _vkCommandBuffer.BeginRenderPass(_vkRenderPass, _vkSwapchain, {{{0,0,0,1.f}}}, true);
 
         struct PushConstants {
@@ -214,9 +255,10 @@ namespace Renderer {
         _vkCommandBuffer.SetPushConstantData(_vkRectPipeline, pushConstants, VK_SHADER_STAGE_VERTEX_BIT);
         _vkCommandBuffer.BindDescriptorSet(_vkRectPipeline);
         _vkCommandBuffer.BindVertexBuffer(_vkRectPerVertexBuffer, 0);
-        _vkCommandBuffer.BindVertexBuffer(_vkRectVertexBuffer, 1);
+        if(changes) _vkCommandBuffer.BindVertexBuffer(_rectCache.GetBuffer(), 1);
+        else _vkCommandBuffer.BindVertexBuffer(_vkInstanceBuffer, 1, rectOffset);
         _vkCommandBuffer.BindIndexBuffer(_vkIndexBuffer);
-        _vkCommandBuffer.DrawIndexed(6, amountRectangles);
+        for(const InstanceRange& run : rectRuns) _vkCommandBuffer.DrawIndexed(6, run._amount, 0, 0, run._start);
 
         _vkCommandBuffer.NextSubPass();
 
@@ -224,21 +266,18 @@ namespace Renderer {
         _vkCommandBuffer.SetPushConstantData(_vkTextPipeline, pushConstants, VK_SHADER_STAGE_VERTEX_BIT);
         _vkCommandBuffer.BindDescriptorSet(_vkTextPipeline);
         _vkCommandBuffer.BindVertexBuffer(_vkTextPerVertexBuffer, 0);
-        _vkCommandBuffer.BindVertexBuffer(_vkTextVertexBuffer, 1);
+        if(changes) _vkCommandBuffer.BindVertexBuffer(_textCache.GetBuffer(), 1);
+        else _vkCommandBuffer.BindVertexBuffer(_vkInstanceBuffer, 1, textOffset);
         _vkCommandBuffer.BindIndexBuffer(_vkIndexBuffer);
-        _vkCommandBuffer.DrawIndexed(6, amountText);
+        for(const InstanceRange& run : textRuns) _vkCommandBuffer.DrawIndexed(6, run._amount, 0, 0, run._start);
 
 #if ENGINE_ENABLE_DEBUG_GRAPHICS
-        _vkDebugVertexBuffer.Resize(_vkContext, (uint32_t)(_debugLines.size()*sizeof(DebugLine)));
-        _vkDebugVertexBuffer.SetData(_vkContext, _debugLines);
-
         _vkCommandBuffer.NextSubPass();
 
         _vkCommandBuffer.BindGraphicsPipeline(_vkDebugPipeline);
         _vkCommandBuffer.SetPushConstantData(_vkDebugPipeline, pushConstants, VK_SHADER_STAGE_VERTEX_BIT);
-        _vkCommandBuffer.BindVertexBuffer(_vkDebugVertexBuffer, 0);
+        _vkCommandBuffer.BindVertexBuffer(_vkInstanceBuffer, 0, debugOffset);
         _vkCommandBuffer.Draw((int)_debugLines.size()*2, 1);
-        _debugLines.clear();
 #endif
 
         _vkCommandBuffer.EndRenderPass();
@@ -251,9 +290,99 @@ namespace Renderer {
             _vkInFlightFence
         );
         _vkCommandBuffer.PresentResult(_vkContext, _vkSwapchain, { _vkRenderFinishedSemaphore });
-        _vkContext.WaitIdle();
+    }
+    void Window::ResetInstanceCaches() {
+        _instanceCachesValid = false;
     }
 
+    void Window::CullInstanceCaches(const Physics::AABB camera, std::pmr::vector<InstanceRange>& rectRuns, std::pmr::vector<InstanceRange>& textRuns) {
+        ENGINE_PROFILE_SCOPE("Window::CullInstanceCaches")
+        std::pmr::vector<entt::entity> visible(_frameMemory);
+        _rectGrid.Query(camera, visible);
+        for(const entt::entity entity : visible) rectRuns.push_back(_rectCache.GetRange(entity));
+        visible.clear();
+        _textGrid.Query(camera, visible);
+        for(const entt::entity entity : visible) textRuns.push_back(_textCache.GetRange(entity));
+
+        _cullingStatistics._visibleRectangles = MergeRuns(rectRuns);
+        _cullingStatistics._culledRectangles = _rectCache.GetAmountUsedInstances() - _cullingStatistics._visibleRectangles;
+        _cullingStatistics._visibleCharacters = MergeRuns(textRuns);
+        _cullingStatistics._culledCharacters = _textCache.GetAmountUsedInstances() - _cullingStatistics._visibleCharacters;
+    }
+    uint32_t Window::MergeRuns(std::pmr::vector<InstanceRange>& runs) {
+        // Neighbouring instances are drawn with one draw call
+        std::sort(runs.begin(), runs.end(), [](const InstanceRange& a, const InstanceRange& b) { return a._start < b._start; });
+        uint32_t instances = 0;
+        size_t merged = 0;
+        for(const InstanceRange& run : runs) {
+            if(run._amount == 0) continue;
+            instances += run._amount;
+            if(merged && runs[merged-1]._start + runs[merged-1]._amount == run._start) runs[merged-1]._amount += run._amount;
+            else runs[merged++] = run;
+        }
+        runs.resize(merged);
+        return instances;
+    }
+    void Window::SyncInstanceCaches(entt::registry& registry, const ChangeTracker& changes) {
+        ENGINE_PROFILE_SCOPE("Window::SyncInstanceCaches")
+        if(!_instanceCachesValid || !changes.CanQuerySince(_instanceCachesFrame)) {
+            // Missed changes, start over
+            _rectCache.Clear();
+            _textCache.Clear();
+            _rectGrid.Clear();
+            _textGrid.Clear();
+            // Written on the thread pool, only the grids are filled on this thread
+            std::pmr::vector<entt::entity> entities(_frameMemory);
+            std::pmr::vector<Physics::AABB> boxes(_frameMemory);
+            auto rects = registry.view<Component::Texture, Component::Position>();
+            entities.assign(rects.begin(), rects.end());
+            boxes.resize(entities.size());
+            _instanceWriter.Fill(registry, entities, _rectCache, boxes.data());
+            for(size_t i = 0; i < entities.size(); i++) _rectGrid.Set(entities[i], boxes[i]);
+            auto texts = registry.view<Component::Text, Component::Position>();
+            entities.assign(texts.begin(), texts.end());
+            boxes.resize(entities.size());
+            _instanceWriter.Fill(registry, entities, _textCache, boxes.data());
+            for(size_t i = 0; i < entities.size(); i++) _textGrid.Set(entities[i], boxes[i]);
+            _instanceCachesValid = true;
+        } else {
+            const FrameID since = _instanceCachesFrame;
+            auto updateRect = [&](const entt::entity entity) { UpdateCachedRect(registry, entity); };
+            auto updateText = [&](const entt::entity entity) { UpdateCachedText(registry, entity); };
+            // Removals first, an entity that got the component back is in the changed list as well
+            changes.ForEachRemovedSince<Component::Position>(since, updateRect);
+            changes.ForEachRemovedSince<Component::Texture>(since, updateRect);
+            changes.ForEachChangedSince<Component::Position>(registry, since, updateRect);
+            changes.ForEachChangedSince<Component::Texture>(registry, since, updateRect);
+            changes.ForEachRemovedSince<Component::Position>(since, updateText);
+            changes.ForEachRemovedSince<Component::Text>(since, updateText);
+            changes.ForEachChangedSince<Component::Position>(registry, since, updateText);
+            changes.ForEachChangedSince<Component::Text>(registry, since, updateText);
+        }
+        _instanceCachesFrame = changes.GetFrame();
+    }
+    void Window::UpdateCachedRect(entt::registry& registry, const entt::entity entity) {
+        if(!registry.valid(entity) || !registry.all_of<Component::Texture, Component::Position>(entity)) {
+            _rectCache.Remove(entity);
+            _rectGrid.Remove(entity);
+            return;
+        }
+        const Component::Texture& texture = registry.get<Component::Texture>(entity);
+        Component::Position& pos = registry.get<Component::Position>(entity);
+        *_rectCache.Set(entity, 1) = InstanceWriter::GetInstanceData(texture, pos);
+        _rectGrid.Set(entity, InstanceWriter::GetBoundingBox(texture, pos));
+    }
+    void Window::UpdateCachedText(entt::registry& registry, const entt::entity entity) {
+        if(!registry.valid(entity) || !registry.all_of<Component::Text, Component::Position>(entity)) {
+            _textCache.Remove(entity);
+            _textGrid.Remove(entity);
+            return;
+        }
+        const Component::Text& text = registry.get<Component::Text>(entity);
+        const Component::Position& pos = registry.get<Component::Position>(entity);
+        InstanceWriter::GetInstanceData(text, pos, _textCache.Set(entity, (uint32_t)text._renderInfo.size()));
+        _textGrid.Set(entity, InstanceWriter::GetBoundingBox(text, pos));
+    }
     
     void Window::StartAssetLoading(const size_t textureMapID) {
         _textureMaps[textureMapID].StartLoading();
@@ -268,11 +397,64 @@ namespace Renderer {
             _textureMaps[textureMapID].AddTextureLoader(assetLoader)
         );
     }
+    // The asset functions update descriptor sets and destroy textures, which the frames in flight may still use.
+    // UploadAssets is called every frame while a scene loads, so it only waits when it is about to bind a texture
+    void Window::WaitForFramesInFlight() {
+        if(_headless) return;
+        _vkCommandBuffer.WaitAllFences(_vkContext, _vkInFlightFence);
+    }
     void Window::EndAssetLoading(const size_t textureMapID) {
+        if(_headless) {
+            _textureMaps[textureMapID].Prepare(false);
+            _textureMaps[textureMapID].SkipUpload();
+            return;
+        }
+        WaitForFramesInFlight();
         _textureMaps[textureMapID].EndLoading(_vkContext, { &_vkRectPipeline, &_vkTextPipeline });
     }
+    void Window::PrepareAssets(const size_t textureMapID) {
+        _textureMaps[textureMapID].Prepare(!_headless);
+    }
+    bool Window::UploadAssets(const size_t textureMapID) {
+        if(_headless) {
+            _textureMaps[textureMapID].SkipUpload();
+            return true;
+        }
+        return _textureMaps[textureMapID].Upload(_vkContext, { &_vkRectPipeline, &_vkTextPipeline }, false, [this]() { WaitForFramesInFlight(); });
+    }
+    float Window::GetAssetLoadingProgress(const size_t textureMapID) const {
+        return _textureMaps[textureMapID].GetProgress();
+    }
     void Window::CleanupAssets(const size_t textureMapID) {
+        WaitForFramesInFlight();
         _textureMaps[textureMapID].Cleanup(_vkContext, { &_vkRectPipeline, &_vkTextPipeline });
+        // The next assets of this texture map get the same IDs
+        _textLayout.RemoveAssetRuns(0xFFFFFFFF << ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS, (uint32_t)textureMapID << ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS);
+    }
+    AssetID Window::AddDynamicAsset(std::shared_ptr<AssetLoader> assetLoader, const uint32_t assetTypeID) {
+        const uint32_t id = _dynamicTextureMap.AddTextureLoader(_vkContext, assetLoader, { &_vkRectPipeline, &_vkTextPipeline });
+        ASSERT(id <= (0xFFFFFFFF >> ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS), "[Renderer::Window] Too many dynamic assets to fit in an AssetID")
+        return (AssetID)(
+            (ENGINE_RENDERER_DYNAMIC_TEXTUREMAP_ID << ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS) | 
+            (assetTypeID << ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS) | 
+            id
+        );
+    }
+    void Window::RemoveDynamicAsset(const AssetID asset) {
+        ASSERT((asset >> ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS) == ENGINE_RENDERER_DYNAMIC_TEXTUREMAP_ID, "[Renderer::Window] Can only remove assets added with AddDynamicAsset")
+        _dynamicTextureMap.Remove(asset & (0xFFFFFFFF >> ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS));
+        // The ID is given out again to the next dynamic asset
+        _textLayout.RemoveAssetRuns(0xFFFFFFFF, asset);
+    }
+    uint32_t Window::AddGlyphCache(const std::string file, const uint32_t size, const size_t memoryBudget) {
+        _glyphCaches.push_back(std::make_unique<GlyphCache>(file, size, memoryBudget));
+        _glyphCaches.back()->Init(_vkContext, _dynamicTextureMap, { &_vkRectPipeline, &_vkTextPipeline });
+        return (uint32_t)(_glyphCaches.size() - 1);
+    }
+    void Window::UpdateGlyphCaches() {
+        for(std::unique_ptr<GlyphCache>& glyphCache : _glyphCaches) {
+            glyphCache->Update(_vkContext, _dynamicTextureMap, { &_vkRectPipeline, &_vkTextPipeline });
+        }
     }
     
     void Window::SetCameraPosition(const Util::Vec2F pos) {
@@ -282,16 +464,18 @@ namespace Renderer {
     std::shared_ptr<ImageRenderInfo> Window::GetTextureInfo(AssetID asset) {
         if(Util::GetBits<uint32_t>(asset, ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS, ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS) != ENGINE_RENDERER_ASSETTYPE_TEXTURE) 
             THROW("[Renderer::Window] Cannot acces an asset that is not a texture with the GetTextureInfo function")
-        return reinterpret_pointer_cast<ImageRenderInfo>(
-            _textureMaps[asset >> ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS].GetRenderInfo(asset & (0xFFFFFFFF >> ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS))
-        );
+        return reinterpret_pointer_cast<ImageRenderInfo>(GetRenderInfo(asset));
     }
     std::shared_ptr<TextRenderInfo> Window::GetTextInfo(AssetID asset) {
         if(Util::GetBits<uint32_t>(asset, ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS, ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS) != ENGINE_RENDERER_ASSETTYPE_TEXT) 
             THROW("[Renderer::Window] Cannot acces an asset that is not text with the GetTextInfo function")
-        return reinterpret_pointer_cast<TextRenderInfo>(
-            _textureMaps[asset >> ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS].GetRenderInfo(asset & (0xFFFFFFFF >> ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS))
-        );
+        return reinterpret_pointer_cast<TextRenderInfo>(GetRenderInfo(asset));
+    }
+    std::shared_ptr<uint8_t> Window::GetRenderInfo(const AssetID asset) {
+        const uint32_t textureMapID = asset >> ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS;
+        const uint32_t id = asset & (0xFFFFFFFF >> ENGINE_RENDERER_ASSETTYPE_TEXTUREMAPID_SHIFT_BITS);
+        if(textureMapID == ENGINE_RENDERER_DYNAMIC_TEXTUREMAP_ID) return _dynamicTextureMap.GetRenderInfo(id);
+        return _textureMaps[textureMapID].GetRenderInfo(id);
     }
 
     std::string Window::GetVulkanDeviceLimits() {
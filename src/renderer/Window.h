@@ -3,6 +3,7 @@
 
 #include "core/PCH.h"
 #include "core/Components.h"
+#include "core/ChangeTracker.h"
 
 #include "renderer/vulkan/Context.h"
 #include "renderer/vulkan/Renderpass.h"
@@ -12,11 +13,18 @@
 #include "renderer/vulkan/Texture.h"
 
 #include "renderer/TextureMap.h"
+#include "renderer/DynamicTextureMap.h"
+#include "renderer/GlyphCache.h"
+#include "renderer/TextLayout.h"
+#include "renderer/InstanceCache.h"
+#include "renderer/SpatialGrid.h"
+#include "renderer/InstanceWriter.h"
 #include "renderer/ImageLoader.h"
 #include "renderer/TextLoader.h"
 
 #include "util/BitMask.h"
 #include "util/FileManager.h"
+#include "util/ThreadPool.h"
 
 // The amount of bits the asset vs the texturemap will use of the AssetID
 // Defaults to 24 bits for the asset and 8 bits for the texturemap
@@ -33,6 +41,18 @@
     #define ENGINE_ENABLE_DEBUG_GRAPHICS __DEBUG__
 #endif
 
+// The amount of frames the CPU may record ahead of the GPU, more frames means more throughput but also more input latency
+#ifndef ENGINE_RENDERER_FRAMES_IN_FLIGHT
+    #define ENGINE_RENDERER_FRAMES_IN_FLIGHT 2
+#endif
+// The amount of bytes of instance data every frame in flight starts with, grows when a frame needs more
+#ifndef ENGINE_RENDERER_INSTANCE_BUFFER_SIZE
+    #define ENGINE_RENDERER_INSTANCE_BUFFER_SIZE 256*1024
+#endif
+
+// The texture map ID of the assets added with AddDynamicAsset, the highest ID that fits in the AssetID
+#define ENGINE_RENDERER_DYNAMIC_TEXTUREMAP_ID ((1u << (32 - ENGINE_RENDERER_ASSETID_TEXTUREMAPID_SHIFT_BITS)) - 1)
+
 #define ENGINE_RENDERER_ASSETTYPE_TEXTURE 1
 #define ENGINE_RENDERER_ASSETTYPE_TEXT 2
 
@@ -45,40 +65,37 @@ namespace Renderer {
     struct VertexDataText {
         Util::Vec2F dimensions;
     };
-    struct InstanceDataRect {
-        InstanceDataRect(const Component::Position::Precalculated area, const Util::Vec3F color, const Util::Vec2F texturePos, const Util::Vec2F textureDimensions, const uint32_t texture)
-         : topLeft(area._topLeft), bottomRight(area._bottomRight), deltaPosition(area._deltaPosition), color(color), texturePos(texturePos), textureDimensions(textureDimensions), texture(texture) {}
-        Util::Vec2F topLeft;
-        Util::Vec2F bottomRight;
-        Util::Vec2F deltaPosition;
-        Util::Vec3F color;
-        Util::Vec2F texturePos;
-        Util::Vec2F textureDimensions;
-        uint32_t texture;
-    };
-    struct InstanceDataText {
-        InstanceDataText(const Util::Vec2F pos, const Util::Vec2F dimensions, const Util::Vec3F color, const Util::Vec2F texturePos, const Util::Vec2F textureDimensions, const uint32_t texture, const float pxRange)
-         : pos(pos), dimensions(dimensions), color(color), texturePos(texturePos), textureDimensions(textureDimensions), texture(texture), pxRange(pxRange) {}
-        Util::Vec2F pos;
-        Util::Vec2F dimensions;
-        Util::Vec3F color;
-        Util::Vec2F texturePos;
-        Util::Vec2F textureDimensions;
-        uint32_t texture;
-        float pxRange;
-    };
     typedef uint32_t AssetID;
 
     class Window {
     public:
-
-        void Init(const uint32_t textureMapSlots);
+        // The frame memory must stay valid during the lifetime of the window and is reset by the owner after every Draw
+        // Without a thread pool the instances are written on the thread calling Draw
+        Window(std::pmr::memory_resource* frameMemory = std::pmr::get_default_resource(), Util::ThreadPool* threadPool = nullptr)
+         : _frameMemory(frameMemory), _instanceWriter(frameMemory, threadPool) {}
+
+        void Init(const uint32_t textureMapSlots, const uint32_t framesInFlight = ENGINE_RENDERER_FRAMES_IN_FLIGHT);
+        // Without a window and without a GPU, for running the game without drawing (like a replay)
+        // The assets are only loaded on the CPU for their render info, Update, ShouldClose and Draw cannot be used
+        void InitHeadless(const uint32_t textureMapSlots);
+        inline bool IsHeadless() const { return _headless; }
         void Cleanup();
 
         bool ShouldClose();
         bool IsMinimized();
         void Update();
-        void Draw(entt::registry& registry, const uint32_t amountRectangles, const uint32_t amountText);
+        /**
+         * @brief Draws all the entities with a position and a texture or text
+         *
+         * @param amountRectangles The amount of textures in the registry
+         * @param amountText The amount of characters in the registry
+         * @param changes When given, the instances are kept on the GPU and only the changed entities are uploaded
+         *      (the amounts are then ignored), otherwise all the instances are written every frame
+         */
+        void Draw(entt::registry& registry, const uint32_t amountRectangles, const uint32_t amountText, const ChangeTracker* changes = nullptr);
+        // Must be called when Draw gets another registry, the next Draw will upload every instance
+        void ResetInstanceCaches();
+        inline const CullingStatistics& GetCullingStatistics() const { return _cullingStatistics; }
 
         static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData);
         static void FramebufferResize(GLFWwindow* window, int width, int height);
@@ -87,7 +104,25 @@ namespace Renderer {
         void SetAssetLoadingCacheName(const size_t textureMapID, const std::string cacheName);
         AssetID AddAsset(const size_t textureMapID, std::shared_ptr<AssetLoader> textureLoader, const uint32_t assetTypeID);
         void EndAssetLoading(const size_t textureMapID);
+        // The asynchronous version of EndAssetLoading, first call PrepareAssets and then UploadAssets until it returns true
+        // Safe to call from a worker thread while drawing, as long as the texture map is not used by anything else
+        void PrepareAssets(const size_t textureMapID);
+        // Uploads a part of the prepared assets, call it between frames on the main thread
+        bool UploadAssets(const size_t textureMapID);
+        // Between 0 and 1, safe to call from any thread
+        float GetAssetLoadingProgress(const size_t textureMapID) const;
         void CleanupAssets(const size_t textureMapID);
+        // Adds an asset while the game is running, it can be drawn immediately (it is uploaded by the next Draw)
+        AssetID AddDynamicAsset(std::shared_ptr<AssetLoader> assetLoader, const uint32_t assetTypeID);
+        // Nothing may draw the asset anymore, its area is reused for the next dynamic assets
+        void RemoveDynamicAsset(const AssetID asset);
+        // A font size of which the glyphs are rendered when they are first used, returns the ID to create text with
+        // The glyphs are placed in the dynamic texture map, the cache stays until the window is cleaned up
+        uint32_t AddGlyphCache(const std::string file, const uint32_t size, const size_t memoryBudget);
+        inline GlyphCache& GetGlyphCache(const uint32_t id) { return *_glyphCaches[id]; }
+        // Places the glyphs rendered since the previous call, the text of the caches that changed must be laid out again before the next Draw
+        void UpdateGlyphCaches();
+        inline TextLayout& GetTextLayout() { return _textLayout; }
 
         void SetCameraPosition(const Util::Vec2F pos);
 
@@ -101,13 +136,31 @@ namespace Renderer {
         void AddDebugLine(const Util::Vec2F start, const Util::Vec2F end, const Util::Vec3F color) {
             _debugLines.push_back(DebugLine{start, color, end, color});
         }
+        // Must be called whenever the frame memory is reset, drops the storage as well (even when nothing was drawn)
+        void DiscardDebugLines() {
+            _debugLines = std::pmr::vector<DebugLine>(_frameMemory);
+        }
 #else
         // Makes sure the next frame a line gets drawn on the screen, will only last for one frame
         void AddDebugLine(const Util::Vec2F start, const Util::Vec2F end, const Util::Vec3F color) {}
+        void DiscardDebugLines() {}
 #endif
 
     private:
+        std::shared_ptr<uint8_t> GetRenderInfo(const AssetID asset);
+        // Waits until the GPU is done with all the submitted frames, after that the descriptor sets can be updated
+        //      and the textures they use destroyed (the uploads on the transfer queue keep running)
+        void WaitForFramesInFlight();
+        void SyncInstanceCaches(entt::registry& registry, const ChangeTracker& changes);
+        // Appends the instances of the cached entities inside the camera, merged into as few draws as possible
+        void CullInstanceCaches(const Physics::AABB camera, std::pmr::vector<InstanceRange>& rectRuns, std::pmr::vector<InstanceRange>& textRuns);
+        // Sorts and merges the neighbouring runs, returns the total amount of instances
+        static uint32_t MergeRuns(std::pmr::vector<InstanceRange>& runs);
+        void UpdateCachedRect(entt::registry& registry, const entt::entity entity);
+        void UpdateCachedText(entt::registry& registry, const entt::entity entity);
+
         GLFWwindow* _window = nullptr;
+        bool _headless = false;
         Vulkan::Context _vkContext;
         Vulkan::RenderPass _vkRenderPass;
         Vulkan::Swapchain _vkSwapchain;
@@ -119,8 +172,18 @@ namespace Renderer {
         Vulkan::Semaphore _vkImageAvailableSemaphore;
         Vulkan::Semaphore _vkRenderFinishedSemaphore;
 
-        Vulkan::EfficientVertexBuffer _vkRectVertexBuffer;
-        Vulkan::EfficientVertexBuffer _vkTextVertexBuffer;
+        uint32_t _framesInFlight = 1;
+        // The rect, text and debug instance data of all the frames in flight
+        Vulkan::RingVertexBuffer _vkInstanceBuffer;
+        // The instances of the retained mode
+        InstanceCache<InstanceDataRect> _rectCache;
+        InstanceCache<InstanceDataText> _textCache;
+        bool _instanceCachesValid = false;
+        FrameID _instanceCachesFrame = 0;
+        // Used to cull the cached instances
+        SpatialGrid _rectGrid;
+        SpatialGrid _textGrid;
+        CullingStatistics _cullingStatistics;
         Vulkan::IndexBuffer _vkIndexBuffer;
         Vulkan::EfficientVertexBuffer _vkRectPerVertexBuffer;
         Vulkan::EfficientVertexBuffer _vkTextPerVertexBuffer;
@@ -133,17 +196,22 @@ namespace Renderer {
         Util::Vec2F _cameraPosition = Util::Vec2F(0);
 
         std::vector<TextureMap> _textureMaps;
+        DynamicTextureMap _dynamicTextureMap;
+        std::vector<std::unique_ptr<GlyphCache>> _glyphCaches;// Pointers, the workers reference their cache
+        TextLayout _textLayout;
+        std::pmr::memory_resource* _frameMemory;
+        // Writes the instances of the immediate mode
+        InstanceWriter _instanceWriter;
 
 #if ENGINE_ENABLE_DEBUG_GRAPHICS
         Vulkan::Pipeline _vkDebugPipeline;
-        Vulkan::EfficientVertexBuffer _vkDebugVertexBuffer;
         struct DebugLine {
             Util::Vec2F _start;
             Util::Vec3F _colorStart;
             Util::Vec2F _end;
             Util::Vec3F _colorEnd;
         };
-        std::vector<DebugLine> _debugLines;
+        std::pmr::vector<DebugLine> _debugLines{_frameMemory};
 #endif
     };
 
@@ -1,5 +1,7 @@
 #include "renderer/ttf/FontParser.h"
 
+#include "util/Profiler.h"
+
 namespace Engine {
 namespace Renderer {
 
@@ -49,6 +51,7 @@ namespace Renderer {
 			_instructionExecutor.SetMaxStorageAreaSize(_maxp._maxStorage);
 			_instructionExecutor.SetMaxFunctions(_maxp._maxFunctionDefs);
 			_instructionExecutor.SetMaxTwilightPoints(_maxp._maxTwilightPoints);
+			_instructionExecutor.SetMaxStackElements(_maxp._maxStackElements);
 
 			LoadLOCATable();
 			LoadGLYFTable();
@@ -456,9 +459,16 @@ namespace Renderer {
 
 				// Instructions
 				uint16_t instructionLength = GetUint16();
-				_glyf._glyphs[c]._instructions.reserve(instructionLength);
+				std::vector<uint8_t> instructions;
+				instructions.reserve(instructionLength);
 				for (size_t i = 0; i < instructionLength; i++) {
-					_glyf._glyphs[c]._instructions.push_back(GetUint8());
+					instructions.push_back(GetUint8());
+				}
+				// Decoded once for all the sizes
+				try {
+					if (!instructions.empty()) info->_program = TTFInstructionExecutor::Decode(instructions);
+				} catch(std::exception exc) {
+					WARNING("[Renderer::TTFFontParser] Failed to decode the instructions of '" + std::string(1, c) + "', decoder returned the error:\n" + std::string(exc.what()))
 				}
 
 				// Flags
@@ -557,12 +567,13 @@ namespace Renderer {
 		if (!IsTTF())
 			return;
 		uint32_t tableSize = GetTableSize({ 'f', 'p', 'g', 'm' });
-		_instructionExecutor.ReserveInstructionStreamSpace(tableSize);
+		std::vector<uint8_t> program;
+		program.reserve(tableSize);
 		for (uint32_t i = 0; i < tableSize; i++) {
-			_instructionExecutor.AddToInstructionStream(GetUint8());
+			program.push_back(GetUint8());
 		}
 		try {
-			_instructionExecutor.ExecuteStack();
+			_instructionExecutor.Execute(TTFInstructionExecutor::Decode(program));
 		} catch(std::exception exc) {
 			WARNING("[Renderer::TTFFontParser] Failed to execute instructions of the font-program, executor returned the error:\n" + std::string(exc.what()))
 		}
@@ -576,9 +587,16 @@ namespace Renderer {
 		if (!IsTTF())
 			return;
 		uint32_t tableSize = GetTableSize({ 'p', 'r', 'e', 'p' });
-		_prep._program.reserve(tableSize);
+		std::vector<uint8_t> program;
+		program.reserve(tableSize);
 		for (uint32_t i = 0; i < tableSize; i++) {
-			_prep._program.push_back(GetUint8());
+			program.push_back(GetUint8());
+		}
+		// Decoded once, executed for every size
+		try {
+			_prep._program = TTFInstructionExecutor::Decode(program);
+		} catch(std::exception exc) {
+			WARNING("[Renderer::TTFFontParser] Failed to decode the instructions of the PREP, decoder returned the error:\n" + std::string(exc.what()))
 		}
 	}
 
@@ -631,42 +649,139 @@ namespace Renderer {
 		return GetGlyphData(&_glyf._glyphs, 1.f);
 	}
 
-	std::unique_ptr<TTFFontParser::FontData> TTFFontParser::GetScaledData(const uint32_t size) {
-		TTFInstructionExecutor executor = _instructionExecutor; // Yes, copying the executor, we may modify the executor and we don't want to have to reexecute the fpgm
+	std::unique_ptr<TTFFontParser::FontData> TTFFontParser::GetScaledData(const uint32_t size, Util::ThreadPool* threadPool) {
+		ENGINE_PROFILE_SCOPE("TTFFontParser::GetScaledData")
+		// Copying the executor, we may modify the executor and we don't want to have to reexecute the fpgm
+		// The functions the fpgm defined are shared with the copy
+		TTFInstructionExecutor executor = _instructionExecutor;
 		double scale = GetScale(size);
 		executor.SetScale(_head._unitsPerEm, size);
-		executor.AddToInstructionStream(&_prep._program);
 		try {
-			executor.ExecuteStack();
+			if (_prep._program) executor.Execute(_prep._program);
 		} catch(std::exception exc) {
 			WARNING("[Renderer::TTFFontParser] Failed to execute instructions of the PREP, executor returned the error:\n" + std::string(exc.what()))
 		}
 		executor.StoreGraphicsState();
 
-		std::map<char32_t, GLYFTable::GlyphInfo> glyphs;
+		// After the PREP every glyph program only depends on the stored state (including the CVT and the storage area),
+		// so the glyphs can be hinted in any order and give the same outlines with or without a pool
+		struct HintedGlyph {
+			char32_t _character;
+			const GLYFTable::GlyphInfo* _info;
+			int32_t _leftSideBearing;
+			int32_t _advance;
+			GLYFTable::GlyphInfo _result;
+		};
+		std::vector<HintedGlyph> hinted;
+		hinted.reserve(_glyf._glyphs.size());
 		for (auto const& [c, info] : _glyf._glyphs) {
-
-			executor.BindStoredGraphicsState();
-			executor.SetOriginalGlyphInfo(info._flags, info._points, info._endPoints);
-			executor.AddPhantomPoints(info._min, info._max, GetLeftSideBearing(c), GetGlyphAdvance(c), 0, 0);
-			executor.AddToInstructionStream(&info._instructions);
+			// The metrics are read up front, the workers only touch their own glyphs
+			hinted.push_back({ c, &info, GetLeftSideBearing(c), GetGlyphAdvance(c) });
+		}
+		auto hint = [](TTFInstructionExecutor& glyphExecutor, HintedGlyph& glyph) {
+			const GLYFTable::GlyphInfo& info = *glyph._info;
+			glyphExecutor.BindStoredGraphicsState();
+			glyphExecutor.SetOriginalGlyphInfo(info._flags, info._points, info._endPoints);
+			glyphExecutor.AddPhantomPoints(info._min, info._max, glyph._leftSideBearing, glyph._advance, 0, 0);
 
 			try {
-				executor.ExecuteStack();
+				if (info._program) glyphExecutor.Execute(info._program);
 			} catch(std::exception exc) {
-				WARNING("[Renderer::TTFFontParser] Failed to execute instructions of '" + std::string(1, c) + "', executor returned the error:\n" + std::string(exc.what()))
+				WARNING("[Renderer::TTFFontParser] Failed to execute instructions of '" + std::string(1, glyph._character) + "', executor returned the error:\n" + std::string(exc.what()))
 			}
 
-			glyphs[c]._min = Util::Vec2F(info._min.x, info._min.y);
-			glyphs[c]._max = Util::Vec2F(info._max.x, info._max.y);
-			glyphs[c]._endPoints = info._endPoints;
-			glyphs[c]._flags = *executor.GetNewFlags();
-			glyphs[c]._points = *executor.GetNewPoints();
+			glyph._result._min = Util::Vec2F(info._min.x, info._min.y);
+			glyph._result._max = Util::Vec2F(info._max.x, info._max.y);
+			glyph._result._endPoints = info._endPoints;
+			glyph._result._flags = *glyphExecutor.GetNewFlags();
+			glyph._result._points = *glyphExecutor.GetNewPoints();
+		};
+		if (threadPool && hinted.size() > ENGINE_RENDERER_TTF_HINTING_BATCH_SIZE) {
+			// The pool cannot throw, the first error is thrown again after all the batches are done
+			std::exception_ptr error;
+			std::mutex errorMutex;
+			threadPool->ParallelFor(hinted.size(), ENGINE_RENDERER_TTF_HINTING_BATCH_SIZE, [&](const size_t batch, const size_t begin, const size_t end) {
+				try {
+					// Every batch gets its own copy, the copies share the functions of the fpgm
+					TTFInstructionExecutor batchExecutor = executor;
+					for (size_t i = begin; i < end; i++) hint(batchExecutor, hinted[i]);
+				} catch(...) {
+					std::lock_guard<std::mutex> lock(errorMutex);
+					if (!error) error = std::current_exception();
+				}
+			});
+			if (error) std::rethrow_exception(error);
+		}
+		else {
+			for (HintedGlyph& glyph : hinted) hint(executor, glyph);
+		}
+
+		// Merged in the order of the characters, the same map as when the glyphs are hinted one after the other
+		std::map<char32_t, GLYFTable::GlyphInfo> glyphs;
+		for (HintedGlyph& glyph : hinted) {
+			glyphs.emplace_hint(glyphs.end(), glyph._character, std::move(glyph._result));
 		}
 
 		return GetGlyphData(&glyphs, scale);
 	}
 
+	Characters TTFFontParser::GetMappedCharacters() const {
+		Characters characters;
+		for (auto const& [c, id] : _glyphIDs) characters.AddCharacter(c);
+		return characters;
+	}
+
+	void TTFFontParser::Benchmark(const Util::File file, Util::ThreadPool& threadPool) {
+		// Only the general tables are read to find the glyphs of the font, the glyphs themselves are parsed once for all the sizes
+		TTFFontParser cmap;
+		cmap.SetCharacters(Characters(0x20, 0xFFFD));
+		cmap.LoadFile(file);
+		cmap.LoadGeneralTables();
+		const Characters characters = cmap.GetMappedCharacters();
+		if (characters._characterCount == 0) {
+			WARNING("[Renderer::TTFFontParser] The font '" + file.String() + "' does not map any characters, nothing to benchmark")
+			return;
+		}
+		TTFFontParser parser(file, characters);
+
+		// Every glyph starts from the state after the PREP, so the thread pool must give exactly the same outlines
+		auto isSameData = [](const FontData& a, const FontData& b) {
+			if (a._curves.size() != b._curves.size() || a._glyphs.size() != b._glyphs.size()) return false;
+			for (size_t i = 0; i < a._curves.size(); i++) {
+				const BezierCurve& curveA = a._curves[i];
+				const BezierCurve& curveB = b._curves[i];
+				if (curveA.degree != curveB.degree || curveA.p1 != curveB.p1 || curveA.p2 != curveB.p2 || curveA.p3 != curveB.p3 || curveA.p4 != curveB.p4) return false;
+			}
+			for (auto itA = a._glyphs.begin(), itB = b._glyphs.begin(); itA != a._glyphs.end(); itA++, itB++) {
+				if (itA->first != itB->first || itA->second._min != itB->second._min || itA->second._max != itB->second._max) return false;
+			}
+			return true;
+		};
+		uint32_t mismatches = 0;
+
+		for (const uint32_t size : {8u, 12u, 16u, 24u, 32u}) {
+			if (!isSameData(*parser.GetScaledData(size), *parser.GetScaledData(size, &threadPool))) {
+				WARNING("[Renderer::TTFFontParser] Hinting on the thread pool gives different outlines than on one thread at " + std::to_string(size) + "px")
+				mismatches++;
+			}
+			// The fastest of a couple of runs
+			auto measure = [&](Util::ThreadPool* pool) {
+				double fastest = std::numeric_limits<double>::max();
+				for (int run = 0; run < 5; run++) {
+					const auto start = std::chrono::steady_clock::now();
+					parser.GetScaledData(size, pool);
+					fastest = std::min(fastest, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+				}
+				return fastest;
+			};
+			const double single = measure(nullptr);
+			const double multi = measure(&threadPool);
+			LOG("[Renderer::TTFFontParser] " + std::to_string(characters._characterCount) + " glyphs at " + std::to_string(size) + "px: "
+				+ std::to_string(single) + "ms on 1 thread, " + std::to_string(multi) + "ms on " + std::to_string(threadPool.GetAmountThreads()) + " threads")
+		}
+		if (mismatches == 0) LOG("[Renderer::TTFFontParser] Hinting on the thread pool gives the same outlines as on one thread at every size")
+	}
+
 	std::unique_ptr<TTFFontParser::FontData> TTFFontParser::GetGlyphData(std::map<char32_t, GLYFTable::GlyphInfo>* glyphInfo, const double renderScale) {
 		std::unique_ptr<FontData> data = std::make_unique<FontData>();
 
@@ -8,6 +8,12 @@
 
 #include "renderer/ttf/InstructionExecutor.h"
 #include "util/FileManager.h"
+#include "util/ThreadPool.h"
+
+// The amount of glyphs one worker hints with its copy of the executor
+#ifndef ENGINE_RENDERER_TTF_HINTING_BATCH_SIZE
+#define ENGINE_RENDERER_TTF_HINTING_BATCH_SIZE 32
+#endif
 
 namespace Engine {
 namespace Renderer {
@@ -343,7 +349,7 @@ namespace Renderer {
 
 				std::vector<uint16_t> _endPoints;
 				std::vector<uint8_t> _flags;
-				std::vector<uint8_t> _instructions;
+				std::shared_ptr<const TTFInstructionExecutor::Program> _program;// nullptr without instructions
 				std::vector<Util::Vec2F> _points;
 			};
 			std::map<char32_t, GlyphInfo> _glyphs;
@@ -361,7 +367,7 @@ namespace Renderer {
 
 		// PREP data
 		struct PREPTable {
-			std::vector<uint8_t> _program;
+			std::shared_ptr<const TTFInstructionExecutor::Program> _program;
 		} _prep;
 
 		TTFInstructionExecutor _instructionExecutor;
@@ -408,6 +414,7 @@ namespace Renderer {
 					std::map<char32_t, int16_t> _horizontalKerning;
 
 					struct Contour {
+						Contour() {}// Used by the deserializer
 						Contour(uint16_t contourStart, uint16_t contourLength) : _contourStart(contourStart), _contourLength(contourLength) {}
 
 						uint16_t _contourStart;
@@ -423,7 +430,14 @@ namespace Renderer {
 			// Receive the data in FUnits, the font program won't be run
 			std::unique_ptr<FontData> GetNonScaledData();
 			// The font program will be run
-			std::unique_ptr<FontData> GetScaledData(const uint32_t size);
+			// The glyphs are hinted in parallel when a thread pool is given
+			std::unique_ptr<FontData> GetScaledData(const uint32_t size, Util::ThreadPool* threadPool = nullptr);
+
+			// The characters of SetCharacters that the cmap maps to a glyph, valid after LoadGeneralTables
+			Characters GetMappedCharacters() const;
+			// Logs how long hinting every glyph of the font takes at a couple of sizes, on one thread and on the thread pool
+			// Also checks that both give the same outlines, warns for every size where they differ
+			static void Benchmark(const Util::File file, Util::ThreadPool& threadPool);
 
 		private:
 			// Helper functions
@@ -16,6 +16,9 @@ namespace Renderer {
 		_state._twilightPoints.resize(size);
 		_state._originalTwilightPoints.resize(size);
 	}
+	void TTFInstructionExecutor::SetMaxStackElements(const size_t size) {
+		_interpreterStack.reserve(size);
+	}
 	void TTFInstructionExecutor::SetScale(const uint32_t unitsPerEM, const uint32_t pointSize) {
 		_state._pointScale = (1 / (double)unitsPerEM) * (double)pointSize;
 		_state._pointSize = pointSize;
@@ -29,6 +32,7 @@ namespace Renderer {
 	}
 	void TTFInstructionExecutor::SetOriginalGlyphInfo(const std::vector<uint8_t> flags, const std::vector<Util::Vec2F> points, const std::vector<uint16_t> endpoints) {
 		_flags = flags;
+		_originalFlags.clear();
 		_originalFlags.reserve(_flags.size());
 		for (uint8_t flag : _flags) {
 			_originalFlags.push_back(flag & GLYF_ON_CURVE_POINT); // Only keep the on curve flag, the rest of the space for flags gets used for internal things
@@ -119,72 +123,44 @@ namespace Renderer {
 		// ----------------------------------------------
 
 		_storedState = _state;
+		// A glyph program can write the CVT and the storage area, every glyph starts from the values of the PREP
+		_storedControlValues = _controlValues;
+		_storedStorageArea = _storageArea;
 	}
 	void TTFInstructionExecutor::BindStoredGraphicsState() {
 		_state = _storedState;
+		_controlValues = _storedControlValues;
+		_storageArea = _storedStorageArea;
 	}
 
 	// ---------------------------------------------------
 	// Helpers
 	// ---------------------------------------------------
 
-	inline bool TTFInstructionExecutor::IsNextInstructionLeft() {
-		if (_currentlyExecutingFunctions.empty())
-			return _currentInstruction < _instructionStream.size();
-		else
-			return _currentlyExecutingFunctions.front()._currentInstruction < _functions[_currentlyExecutingFunctions.front()._function].size();
-	}
-	inline uint8_t TTFInstructionExecutor::GetNextInstructionByte() {
-		if (_currentlyExecutingFunctions.empty())
-			return _instructionStream[_currentInstruction++];
-		else
-			return _functions[_currentlyExecutingFunctions.front()._function][_currentlyExecutingFunctions.front()._currentInstruction++];
-	}
-	inline int32_t TTFInstructionExecutor::GetNextInstructionPaddedWord() {
-		uint8_t highByte = GetNextInstructionByte();
-		uint8_t lowByte = GetNextInstructionByte();
-		return (int32_t)static_cast<int16_t>((highByte << 8) | lowByte);
-	}
-
-	inline void TTFInstructionExecutor::JumpForwardAmountInstruction(const int32_t amount) {
-		if (_currentlyExecutingFunctions.empty())
-			_currentInstruction += amount;
-		else
-			_currentlyExecutingFunctions.front()._currentInstruction += amount;
-	}
-
 	inline void TTFInstructionExecutor::PushStack(const bool value) {
 		PushStack((uint32_t)value);
 	}
 	inline void TTFInstructionExecutor::PushStack(const uint8_t value) {
-		_interpreterStack.push_front(value);
+		_interpreterStack.push_back(value);
 	}
 	inline void TTFInstructionExecutor::PushStack(const int32_t value) {
-		_interpreterStack.push_front(value);
+		_interpreterStack.push_back(value);
 	}
 	inline void TTFInstructionExecutor::PushStack(const uint32_t value) {
-		_interpreterStack.push_front(static_cast<int32_t>(value));
+		_interpreterStack.push_back(static_cast<int32_t>(value));
 	}
 	inline int32_t TTFInstructionExecutor::GetNextStackInt32() {
 		if (_interpreterStack.empty())
 			THROW("[Renderer::TTFInstructionExecutor] Can't retrieve a value of an empty stack");
-		int32_t value = _interpreterStack.front();
-		_interpreterStack.pop_front();
+		int32_t value = _interpreterStack.back();
+		_interpreterStack.pop_back();
 		return value;
 	}
 	inline uint32_t TTFInstructionExecutor::GetNextStackUInt32() {
-		if (_interpreterStack.empty())
-			THROW("[Renderer::TTFInstructionExecutor] Can't retrieve a value of an empty stack");
-		int32_t value = _interpreterStack.front();
-		_interpreterStack.pop_front();
-		return static_cast<uint32_t>(value);
+		return static_cast<uint32_t>(GetNextStackInt32());
 	}
 	inline F26Dot6 TTFInstructionExecutor::GetNextStackF26Dot6() {
-		if (_interpreterStack.empty())
-			THROW("[Renderer::TTFInstructionExecutor] Can't retrieve a value of an empty stack");
-		int32_t value = _interpreterStack.front();
-		_interpreterStack.pop_front();
-		return value;
+		return GetNextStackInt32();
 	}
 
 	// Point getters and setters
@@ -278,269 +254,301 @@ namespace Renderer {
 	// Actual logic
 	// ---------------------------------------------------
 
-	void TTFInstructionExecutor::ExecuteStack() {
-		_currentInstruction = 0;
-		while (_currentInstruction < _instructionStream.size()) {
-			ExecuteCommand(GetNextInstructionByte());
+	std::shared_ptr<const TTFInstructionExecutor::Program> TTFInstructionExecutor::Decode(const std::vector<uint8_t>& stream) {
+		std::shared_ptr<Program> program = std::make_shared<Program>();
+		program->_size = (uint32_t)stream.size();
+		program->_instructions.reserve(stream.size());
+		// The if, else and function definitions that didn't find their end yet
+		std::vector<uint32_t> openBlocks;
+		size_t i = 0;
+		while (i < stream.size()) {
+			Program::Instruction instruction;
+			instruction._command = stream[i];
+			instruction._offset = (uint32_t)i++;
+
+			// Expand the values of the push instructions
+			const uint8_t command = instruction._command;
+			uint32_t amount = 0;
+			bool words = false;
+			if (command == 0x40 || command == 0x41) {
+				if (i >= stream.size()) THROW("[Renderer::TTFInstructionExecutor] Push instruction reads past the end of the instruction stream");
+				amount = stream[i++];
+				words = command == 0x41;
+			}
+			else if (command >= 0xB0 && command <= 0xB7) amount = command - 0xB0 + 1;
+			else if (command >= 0xB8 && command <= 0xBF) { amount = command - 0xB8 + 1; words = true; }
+			if (amount != 0) {
+				if (i + amount * (words ? 2 : 1) > stream.size())
+					THROW("[Renderer::TTFInstructionExecutor] Push instruction reads past the end of the instruction stream");
+				instruction._data = (uint32_t)program->_values.size();
+				instruction._amount = amount;
+				for (uint32_t v = 0; v < amount; v++) {
+					if (words) {
+						program->_values.push_back((int32_t)static_cast<int16_t>((stream[i] << 8) | stream[i + 1]));
+						i += 2;
+					}
+					else program->_values.push_back(stream[i++]);
+				}
+			}
+
+			// Match the blocks
+			const uint32_t index = (uint32_t)program->_instructions.size();
+			if (command == 0x58 || command == 0x2C) { // If, function definition
+				openBlocks.push_back(index);
+			}
+			else if (command == 0x1B) { // Else
+				// Without a target the else would jump back to the start of the program and loop forever
+				if (openBlocks.empty() || program->_instructions[openBlocks.back()]._command != 0x58)
+					THROW("[Renderer::TTFInstructionExecutor] Else without a matching if in the instruction stream");
+				// A false if continues after the else, the else itself skips to the endif
+				program->_instructions[openBlocks.back()]._data = index + 1;
+				openBlocks.back() = index;
+			}
+			else if (command == 0x59) { // Endif
+				if (openBlocks.empty() || program->_instructions[openBlocks.back()]._command == 0x2C)
+					THROW("[Renderer::TTFInstructionExecutor] Endif without a matching if in the instruction stream");
+				program->_instructions[openBlocks.back()]._data = index + 1;
+				openBlocks.pop_back();
+			}
+			else if (command == 0x2D) { // Function end, also ends the blocks inside the function that weren't ended
+				while (!openBlocks.empty()) {
+					const uint32_t block = openBlocks.back();
+					openBlocks.pop_back();
+					program->_instructions[block]._data = index;
+					if (program->_instructions[block]._command == 0x2C) break;
+				}
+			}
+			program->_instructions.push_back(instruction);
 		}
-		_instructionStream.clear();
+		// The blocks without an end run to the end of the stream
+		for (const uint32_t block : openBlocks) {
+			program->_instructions[block]._data = (uint32_t)program->_instructions.size();
+		}
+		return program;
+	}
+
+	void TTFInstructionExecutor::Execute(const std::shared_ptr<const Program>& program) {
+		_program = program;
+		_begin = 0;
+		_current = 0;
+		_end = (uint32_t)program->_instructions.size();
+		_interpreterStack.clear();
+		Run();
+		_program.reset();
 		if (!_interpreterStack.empty()) WARNING("[Renderer::TTFInstructionExecutor] Stack isn't empty");
 		_interpreterStack.clear();
 	}
 
-	void TTFInstructionExecutor::ExecuteCommand(const uint8_t command) {
-		_usedInstructions.insert(command);
-		switch (command) {
+	void TTFInstructionExecutor::Run() {
+		static const std::array<Command, 256> commands = CreateCommandTable();
+		// The instructions stay valid while a function runs, the caller keeps its program alive
+		const std::vector<Program::Instruction>& instructions = _program->_instructions;
+		while (_current < _end) {
+			const Program::Instruction& instruction = instructions[_current++];
+			commands[instruction._command](*this, instruction);
+		}
+	}
+	void TTFInstructionExecutor::RunFunction(const uint32_t f) {
+		if (f >= _functions.size() || !_functions[f]._program)
+			THROW("[Renderer::TTFInstructionExecutor] Calling a function that isn't defined");
+		std::shared_ptr<const Program> callerProgram = std::exchange(_program, _functions[f]._program);
+		const uint32_t callerBegin = _begin;
+		const uint32_t callerCurrent = _current;
+		const uint32_t callerEnd = _end;
+		_begin = _current = _functions[f]._begin;
+		_end = _functions[f]._end;
+		Run();
+		_program = std::move(callerProgram);
+		_begin = callerBegin;
+		_current = callerCurrent;
+		_end = callerEnd;
+	}
+	void TTFInstructionExecutor::JumpRelative(const Program::Instruction& instruction, const int32_t amount) {
+		if (amount == 0)
+			THROW("[Renderer::TTFInstructionExecutor] Can't jump back to same jump instruction, this will cause a loop");
+		const int64_t target = (int64_t)instruction._offset + amount;
+		const std::vector<Program::Instruction>& instructions = _program->_instructions;
+		auto it = std::lower_bound(instructions.begin(), instructions.end(), target, [](const Program::Instruction& i, const int64_t offset) {
+			return (int64_t)i._offset < offset;
+		});
+		// Jumping past the end stops the program, like running out of instructions
+		if (it != instructions.end() && it->_offset != target)
+			THROW("[Renderer::TTFInstructionExecutor] Can't jump into the middle of an instruction");
+		const uint32_t index = (uint32_t)(it - instructions.begin());
+		if (index < _begin)
+			THROW("[Renderer::TTFInstructionExecutor] Can't jump to before the start of the function");
+		_current = index;
+	}
+
+	std::array<TTFInstructionExecutor::Command, 256> TTFInstructionExecutor::CreateCommandTable() {
+		std::array<Command, 256> table;
+		table.fill([](TTFInstructionExecutor&, const Program::Instruction& instruction) {
+			THROW("[Renderer::TTFInstructionExecutor] Unkown TTF instruction = " + std::to_string(instruction._command));
+		});
+		#define ENGINE_TTF_COMMAND(command, call) table[command] = [](TTFInstructionExecutor& e, const Program::Instruction& instruction) { e.call; };
+
 		// Push commands
-		case 0x40: PushNBytes(); break;
-		case 0x41: PushNWords(); break;
-		case 0xB0: PushBytes(1); break;
-		case 0xB1: PushBytes(2); break;
-		case 0xB2: PushBytes(3); break;
-		case 0xB3: PushBytes(4); break;
-		case 0xB4: PushBytes(5); break;
-		case 0xB5: PushBytes(6); break;
-		case 0xB6: PushBytes(7); break;
-		case 0xB7: PushBytes(8); break;
-		case 0xB8: PushWords(1); break;
-		case 0xB9: PushWords(2); break;
-		case 0xBA: PushWords(3); break;
-		case 0xBB: PushWords(4); break;
-		case 0xBC: PushWords(5); break;
-		case 0xBD: PushWords(6); break;
-		case 0xBE: PushWords(7); break;
-		case 0xBF: PushWords(8); break;
+		ENGINE_TTF_COMMAND(0x40, PushValues(instruction))
+		ENGINE_TTF_COMMAND(0x41, PushValues(instruction))
+		for (uint32_t command = 0xB0; command <= 0xBF; command++) ENGINE_TTF_COMMAND(command, PushValues(instruction))
 		// Store commands
-		case 0x43: ReadStore(); break;
-		case 0x42: WriteStore(); break;
+		ENGINE_TTF_COMMAND(0x43, ReadStore())
+		ENGINE_TTF_COMMAND(0x42, WriteStore())
 		// CVT commands
-		case 0x44: WriteCVTInPixels(); break;
-		case 0x70: WriteCVTInFDU(); break;
- 		case 0x45: ReadCVT(); break;
+		ENGINE_TTF_COMMAND(0x44, WriteCVTInPixels())
+		ENGINE_TTF_COMMAND(0x70, WriteCVTInFDU())
+		ENGINE_TTF_COMMAND(0x45, ReadCVT())
 		// Vectors commands
-		case 0x00: SetFreedomAndProjectionVectorToAxis(false); break;
-		case 0x01: SetFreedomAndProjectionVectorToAxis(true); break;
-		case 0x02: SetProjectionVectorToAxis(false); break;
-		case 0x03: SetProjectionVectorToAxis(true); break;
-		case 0x04: SetFreedomVectorToAxis(false); break;
-		case 0x05: SetFreedomVectorToAxis(true); break;
-		case 0x06: SetProjectionVectorToLine(false); break;
-		case 0x07: SetProjectionVectorToLine(true); break;
-		case 0x08: SetFreedomVectorToLine(false); break;
-		case 0x09: SetFreedomVectorToLine(true); break;
-		case 0x0E: SetFreedomVectorToProjectionVector(); break;
-		case 0x86: SetDualProjectionVectorToLine(false); break;
-		case 0x87: SetDualProjectionVectorToLine(true); break;
-		case 0x0A: SetProjectionVectorFromStack(); break;
-		case 0x0B: SetFreedomVectorFromStack(); break;
-		case 0x0C: GetProjectionVector(); break;
-		case 0x0D: GetFreedomVector(); break;
+		ENGINE_TTF_COMMAND(0x00, SetFreedomAndProjectionVectorToAxis(false))
+		ENGINE_TTF_COMMAND(0x01, SetFreedomAndProjectionVectorToAxis(true))
+		ENGINE_TTF_COMMAND(0x02, SetProjectionVectorToAxis(false))
+		ENGINE_TTF_COMMAND(0x03, SetProjectionVectorToAxis(true))
+		ENGINE_TTF_COMMAND(0x04, SetFreedomVectorToAxis(false))
+		ENGINE_TTF_COMMAND(0x05, SetFreedomVectorToAxis(true))
+		ENGINE_TTF_COMMAND(0x06, SetProjectionVectorToLine(false))
+		ENGINE_TTF_COMMAND(0x07, SetProjectionVectorToLine(true))
+		ENGINE_TTF_COMMAND(0x08, SetFreedomVectorToLine(false))
+		ENGINE_TTF_COMMAND(0x09, SetFreedomVectorToLine(true))
+		ENGINE_TTF_COMMAND(0x0E, SetFreedomVectorToProjectionVector())
+		ENGINE_TTF_COMMAND(0x86, SetDualProjectionVectorToLine(false))
+		ENGINE_TTF_COMMAND(0x87, SetDualProjectionVectorToLine(true))
+		ENGINE_TTF_COMMAND(0x0A, SetProjectionVectorFromStack())
+		ENGINE_TTF_COMMAND(0x0B, SetFreedomVectorFromStack())
+		ENGINE_TTF_COMMAND(0x0C, GetProjectionVector())
+		ENGINE_TTF_COMMAND(0x0D, GetFreedomVector())
 		// Reference points
-		case 0x10: SetReferencePoint0(); break;
-		case 0x11: SetReferencePoint1(); break;
-		case 0x12: SetReferencePoint2(); break;
+		ENGINE_TTF_COMMAND(0x10, SetReferencePoint0())
+		ENGINE_TTF_COMMAND(0x11, SetReferencePoint1())
+		ENGINE_TTF_COMMAND(0x12, SetReferencePoint2())
 		// Zone pointers
-		case 0x13: SetZonePointer0(); break;
-		case 0x14: SetZonePointer1(); break;
-		case 0x15: SetZonePointer2(); break;
-		case 0x16: SetZonePointerS(); break;
+		ENGINE_TTF_COMMAND(0x13, SetZonePointer0())
+		ENGINE_TTF_COMMAND(0x14, SetZonePointer1())
+		ENGINE_TTF_COMMAND(0x15, SetZonePointer2())
+		ENGINE_TTF_COMMAND(0x16, SetZonePointerS())
 		// Rounding commands
-		case 0x19: RoundToHalfGrid(); break;
-		case 0x18: RoundToGrid(); break;
-		case 0x3D: RoundToDoubleGrid(); break;
-		case 0x7D: RoundDownToGrid(); break;
-		case 0x7C: RoundUpToGrid(); break;
-		case 0x7A: RoundNone(); break;
-		case 0x76: RoundSuper(); break;
-		case 0x77: RoundSuper45Degree(); break;
+		ENGINE_TTF_COMMAND(0x19, RoundToHalfGrid())
+		ENGINE_TTF_COMMAND(0x18, RoundToGrid())
+		ENGINE_TTF_COMMAND(0x3D, RoundToDoubleGrid())
+		ENGINE_TTF_COMMAND(0x7D, RoundDownToGrid())
+		ENGINE_TTF_COMMAND(0x7C, RoundUpToGrid())
+		ENGINE_TTF_COMMAND(0x7A, RoundNone())
+		ENGINE_TTF_COMMAND(0x76, RoundSuper())
+		ENGINE_TTF_COMMAND(0x77, RoundSuper45Degree())
 		// Miscellaneous graphic state commands
-		case 0x17: SetLoopVariable(); break;
-		case 0x1A: SetMinimumDistance(); break;
-		case 0x8E: SetInstructionExecutionControl(); break;
-		case 0x85: SetScanConversionControl(); break;
-		case 0x8D: SetScanType(); break;
-		case 0x1D: SetCVTCutIn(); break;
-		case 0x1E: SetSingleWidthCutIn(); break;
-		case 0x1F: SetSingleWidth(); break;
-		case 0x4D: SetAutoFlipOn(); break;
-		case 0x4E: SetAutoFlipOff(); break;
-		case 0x5E: SetDeltaBase(); break;
-		case 0x5F: SetDeltaShift(); break;
+		ENGINE_TTF_COMMAND(0x17, SetLoopVariable())
+		ENGINE_TTF_COMMAND(0x1A, SetMinimumDistance())
+		ENGINE_TTF_COMMAND(0x8E, SetInstructionExecutionControl())
+		ENGINE_TTF_COMMAND(0x85, SetScanConversionControl())
+		ENGINE_TTF_COMMAND(0x8D, SetScanType())
+		ENGINE_TTF_COMMAND(0x1D, SetCVTCutIn())
+		ENGINE_TTF_COMMAND(0x1E, SetSingleWidthCutIn())
+		ENGINE_TTF_COMMAND(0x1F, SetSingleWidth())
+		ENGINE_TTF_COMMAND(0x4D, SetAutoFlipOn())
+		ENGINE_TTF_COMMAND(0x4E, SetAutoFlipOff())
+		ENGINE_TTF_COMMAND(0x5E, SetDeltaBase())
+		ENGINE_TTF_COMMAND(0x5F, SetDeltaShift())
 		// Reading and writing data
-		case 0x46: GetCoordinateProjectedOnProjectionVector(false); break;
-		case 0x47: GetCoordinateProjectedOnProjectionVector(true); break;
-		case 0x48: SetCoordinateFromStackUsingGraphicsVectors(); break;
-		case 0x49: MeasureDistance(false); break;
-		case 0x4A: MeasureDistance(true); break;
-		case 0x4B: MeasurePixelsPerEM(); break;
-		case 0x4C: MeasurePointSize(); break;
+		ENGINE_TTF_COMMAND(0x46, GetCoordinateProjectedOnProjectionVector(false))
+		ENGINE_TTF_COMMAND(0x47, GetCoordinateProjectedOnProjectionVector(true))
+		ENGINE_TTF_COMMAND(0x48, SetCoordinateFromStackUsingGraphicsVectors())
+		ENGINE_TTF_COMMAND(0x49, MeasureDistance(false))
+		ENGINE_TTF_COMMAND(0x4A, MeasureDistance(true))
+		ENGINE_TTF_COMMAND(0x4B, MeasurePixelsPerEM())
+		ENGINE_TTF_COMMAND(0x4C, MeasurePointSize())
 		// Outline managing
-		case 0x80: FlipPoint(); break;
-		case 0x81: FlipRangeOn(); break;
-		case 0x82: FlipRangeOff(); break;
-		case 0x32: ShiftPointByLastPoint(false); break;
-		case 0x33: ShiftPointByLastPoint(true); break;
-		case 0x34: ShiftContourByLastPoint(false); break;
-		case 0x35: ShiftContourByLastPoint(true); break;
-		case 0x36: ShiftZoneByLastPoint(false); break;
-		case 0x37: ShiftZoneByLastPoint(true); break;
-		case 0x38: ShiftPointByPixelAmount(); break;
-		case 0x3A: MoveStackIndirectRelativePoint(false); break;
-		case 0x3B: MoveStackIndirectRelativePoint(true); break;
-		case 0x2E: MoveDirectAbsolutePoint(false); break;
-		case 0x2F: MoveDirectAbsolutePoint(true); break;
-		case 0x3E: MoveIndirectAbsolutePoint(false); break;
-		case 0x3F: MoveIndirectAbsolutePoint(true); break;
-
-		case 0xC0: MoveDirectRelativePoint(false, false, false, 0b00); break;
-		case 0xC1: MoveDirectRelativePoint(false, false, false, 0b01); break;
-		case 0xC2: MoveDirectRelativePoint(false, false, false, 0b10); break;
-		case 0xC3: MoveDirectRelativePoint(false, false, false, 0b11); break;
-		case 0xC4: MoveDirectRelativePoint(false, false, true, 0b00); break;
-		case 0xC5: MoveDirectRelativePoint(false, false, true, 0b01); break;
-		case 0xC6: MoveDirectRelativePoint(false, false, true, 0b10); break;
-		case 0xC7: MoveDirectRelativePoint(false, false, true, 0b11); break;
-
-		case 0xC8: MoveDirectRelativePoint(false, true, false, 0b00); break;
-		case 0xC9: MoveDirectRelativePoint(false, true, false, 0b01); break;
-		case 0xCA: MoveDirectRelativePoint(false, true, false, 0b10); break;
-		case 0xCB: MoveDirectRelativePoint(false, true, false, 0b11); break;
-		case 0xCC: MoveDirectRelativePoint(false, true, true, 0b00); break;
-		case 0xCD: MoveDirectRelativePoint(false, true, true, 0b01); break;
-		case 0xCE: MoveDirectRelativePoint(false, true, true, 0b10); break;
-		case 0xCF: MoveDirectRelativePoint(false, true, true, 0b11); break;
-
-		case 0xD0: MoveDirectRelativePoint(true, false, false, 0b00); break;
-		case 0xD1: MoveDirectRelativePoint(true, false, false, 0b01); break;
-		case 0xD2: MoveDirectRelativePoint(true, false, false, 0b10); break;
-		case 0xD3: MoveDirectRelativePoint(true, false, false, 0b11); break;
-		case 0xD4: MoveDirectRelativePoint(true, false, true, 0b00); break;
-		case 0xD5: MoveDirectRelativePoint(true, false, true, 0b01); break;
-		case 0xD6: MoveDirectRelativePoint(true, false, true, 0b10); break;
-		case 0xD7: MoveDirectRelativePoint(true, false, true, 0b11); break;
-
-		case 0xD8: MoveDirectRelativePoint(true, true, false, 0b00); break;
-		case 0xD9: MoveDirectRelativePoint(true, true, false, 0b01); break;
-		case 0xDA: MoveDirectRelativePoint(true, true, false, 0b10); break;
-		case 0xDB: MoveDirectRelativePoint(true, true, false, 0b11); break;
-		case 0xDC: MoveDirectRelativePoint(true, true, true, 0b00); break;
-		case 0xDD: MoveDirectRelativePoint(true, true, true, 0b01); break;
-		case 0xDE: MoveDirectRelativePoint(true, true, true, 0b10); break;
-		case 0xDF: MoveDirectRelativePoint(true, true, true, 0b11); break;
-
-		case 0xE0: MoveIndirectRelativePoint(false, false, false, 0b00); break;
-		case 0xE1: MoveIndirectRelativePoint(false, false, false, 0b01); break;
-		case 0xE2: MoveIndirectRelativePoint(false, false, false, 0b10); break;
-		case 0xE3: MoveIndirectRelativePoint(false, false, false, 0b11); break;
-		case 0xE4: MoveIndirectRelativePoint(false, false, true, 0b00); break;
-		case 0xE5: MoveIndirectRelativePoint(false, false, true, 0b01); break;
-		case 0xE6: MoveIndirectRelativePoint(false, false, true, 0b10); break;
-		case 0xE7: MoveIndirectRelativePoint(false, false, true, 0b11); break;
-
-		case 0xE8: MoveIndirectRelativePoint(false, true, false, 0b00); break;
-		case 0xE9: MoveIndirectRelativePoint(false, true, false, 0b01); break;
-		case 0xEA: MoveIndirectRelativePoint(false, true, false, 0b10); break;
-		case 0xEB: MoveIndirectRelativePoint(false, true, false, 0b11); break;
-		case 0xEC: MoveIndirectRelativePoint(false, true, true, 0b00); break;
-		case 0xED: MoveIndirectRelativePoint(false, true, true, 0b01); break;
-		case 0xEE: MoveIndirectRelativePoint(false, true, true, 0b10); break;
-		case 0xEF: MoveIndirectRelativePoint(false, true, true, 0b11); break;
-
-		case 0xF0: MoveIndirectRelativePoint(true, false, false, 0b00); break;
-		case 0xF1: MoveIndirectRelativePoint(true, false, false, 0b01); break;
-		case 0xF2: MoveIndirectRelativePoint(true, false, false, 0b10); break;
-		case 0xF3: MoveIndirectRelativePoint(true, false, false, 0b11); break;
-		case 0xF4: MoveIndirectRelativePoint(true, false, true, 0b00); break;
-		case 0xF5: MoveIndirectRelativePoint(true, false, true, 0b01); break;
-		case 0xF6: MoveIndirectRelativePoint(true, false, true, 0b10); break;
-		case 0xF7: MoveIndirectRelativePoint(true, false, true, 0b11); break;
-		
-		case 0xF8: MoveIndirectRelativePoint(true, true, false, 0b00); break;
-		case 0xF9: MoveIndirectRelativePoint(true, true, false, 0b01); break;
-		case 0xFA: MoveIndirectRelativePoint(true, true, false, 0b10); break;
-		case 0xFB: MoveIndirectRelativePoint(true, true, false, 0b11); break;
-		case 0xFC: MoveIndirectRelativePoint(true, true, true, 0b00); break;
-		case 0xFD: MoveIndirectRelativePoint(true, true, true, 0b01); break;
-		case 0xFE: MoveIndirectRelativePoint(true, true, true, 0b10); break;
-		case 0xFF: MoveIndirectRelativePoint(true, true, true, 0b11); break;
-
-		case 0x3C: AlignRelativePoint(); break;
-		case 0x0F: MovePointPToIntersection(); break;
-		case 0x27: AlignPoints(); break;
-		case 0x39: InterpolatePointByLastRelativeStretch(); break;
-		case 0x29: UntouchPoint(); break;
-		case 0x30: InterpolateUntouchedPointsThroughTheOutline(false); break;
-		case 0x31: InterpolateUntouchedPointsThroughTheOutline(true); break;
+		ENGINE_TTF_COMMAND(0x80, FlipPoint())
+		ENGINE_TTF_COMMAND(0x81, FlipRangeOn())
+		ENGINE_TTF_COMMAND(0x82, FlipRangeOff())
+		ENGINE_TTF_COMMAND(0x32, ShiftPointByLastPoint(false))
+		ENGINE_TTF_COMMAND(0x33, ShiftPointByLastPoint(true))
+		ENGINE_TTF_COMMAND(0x34, ShiftContourByLastPoint(false))
+		ENGINE_TTF_COMMAND(0x35, ShiftContourByLastPoint(true))
+		ENGINE_TTF_COMMAND(0x36, ShiftZoneByLastPoint(false))
+		ENGINE_TTF_COMMAND(0x37, ShiftZoneByLastPoint(true))
+		ENGINE_TTF_COMMAND(0x38, ShiftPointByPixelAmount())
+		ENGINE_TTF_COMMAND(0x3A, MoveStackIndirectRelativePoint(false))
+		ENGINE_TTF_COMMAND(0x3B, MoveStackIndirectRelativePoint(true))
+		ENGINE_TTF_COMMAND(0x2E, MoveDirectAbsolutePoint(false))
+		ENGINE_TTF_COMMAND(0x2F, MoveDirectAbsolutePoint(true))
+		ENGINE_TTF_COMMAND(0x3E, MoveIndirectAbsolutePoint(false))
+		ENGINE_TTF_COMMAND(0x3F, MoveIndirectAbsolutePoint(true))
+		// The flags are in the lower bits of the command: set rp0, keep the minimum distance, round and the distance type
+		for (uint32_t command = 0xC0; command <= 0xDF; command++) {
+			ENGINE_TTF_COMMAND(command, MoveDirectRelativePoint(instruction._command & 0x10, instruction._command & 0x08, instruction._command & 0x04, instruction._command & 0x03))
+		}
+		for (uint32_t command = 0xE0; command <= 0xFF; command++) {
+			ENGINE_TTF_COMMAND(command, MoveIndirectRelativePoint(instruction._command & 0x10, instruction._command & 0x08, instruction._command & 0x04, instruction._command & 0x03))
+		}
+		ENGINE_TTF_COMMAND(0x3C, AlignRelativePoint())
+		ENGINE_TTF_COMMAND(0x0F, MovePointPToIntersection())
+		ENGINE_TTF_COMMAND(0x27, AlignPoints())
+		ENGINE_TTF_COMMAND(0x39, InterpolatePointByLastRelativeStretch())
+		ENGINE_TTF_COMMAND(0x29, UntouchPoint())
+		ENGINE_TTF_COMMAND(0x30, InterpolateUntouchedPointsThroughTheOutline(false))
+		ENGINE_TTF_COMMAND(0x31, InterpolateUntouchedPointsThroughTheOutline(true))
 		// Exceptions
-		case 0x5D: DeltaExceptionP1(); break;
-		case 0x71: DeltaExceptionP2(); break;
-		case 0x72: DeltaExceptionP3(); break;
-		case 0x73: DeltaExceptionC1(); break;
-		case 0x74: DeltaExceptionC2(); break;
-		case 0x75: DeltaExceptionC3(); break;
+		ENGINE_TTF_COMMAND(0x5D, DeltaExceptionP1())
+		ENGINE_TTF_COMMAND(0x71, DeltaExceptionP2())
+		ENGINE_TTF_COMMAND(0x72, DeltaExceptionP3())
+		ENGINE_TTF_COMMAND(0x73, DeltaExceptionC1())
+		ENGINE_TTF_COMMAND(0x74, DeltaExceptionC2())
+		ENGINE_TTF_COMMAND(0x75, DeltaExceptionC3())
 		// Managing the stack
-		case 0x20: DuplicateTop(); break;
-		case 0x21: PopTop(); break;
-		case 0x22: ClearStack(); break;
-		case 0x23: SwapTop(); break;
-		case 0x24: ReturnDepth(); break;
-		case 0x25: CopyIndexedToTop(); break;
-		case 0x26: MoveIndexedToTop(); break;
-		case 0x8a: RollTopThree(); break;
+		ENGINE_TTF_COMMAND(0x20, DuplicateTop())
+		ENGINE_TTF_COMMAND(0x21, PopTop())
+		ENGINE_TTF_COMMAND(0x22, ClearStack())
+		ENGINE_TTF_COMMAND(0x23, SwapTop())
+		ENGINE_TTF_COMMAND(0x24, ReturnDepth())
+		ENGINE_TTF_COMMAND(0x25, CopyIndexedToTop())
+		ENGINE_TTF_COMMAND(0x26, MoveIndexedToTop())
+		ENGINE_TTF_COMMAND(0x8a, RollTopThree())
 		// Flow control
-		case 0x58: IfTest(); break;
-		case 0x1B: Else(); break;
-		case 0x59: EndIf(); break;
-		case 0x78: JumpRelativeOnTrue(); break;
-		case 0x1C: Jump(); break;
-		case 0x79: JumpRelativeOnFalse(); break;
+		ENGINE_TTF_COMMAND(0x58, IfTest(instruction))
+		ENGINE_TTF_COMMAND(0x1B, Else(instruction))
+		ENGINE_TTF_COMMAND(0x59, EndIf())
+		ENGINE_TTF_COMMAND(0x78, JumpRelativeOnTrue(instruction))
+		ENGINE_TTF_COMMAND(0x1C, Jump(instruction))
+		ENGINE_TTF_COMMAND(0x79, JumpRelativeOnFalse(instruction))
 		// Logical functions
-		case 0x50: LessThan(); break;
-		case 0x51: LessThanOrEqual(); break;
-		case 0x52: GreaterThan(); break;
-		case 0x53: GreaterThanOrEqual(); break;
-		case 0x54: Equal(); break;
-		case 0x55: NotEqual(); break;
-		case 0x56: Odd(); break;
-		case 0x57: Even(); break;
-		case 0x5A: LogicalAnd(); break;
-		case 0x5B: LogicalOr(); break;
-		case 0x5C: LogicalNot(); break;
+		ENGINE_TTF_COMMAND(0x50, LessThan())
+		ENGINE_TTF_COMMAND(0x51, LessThanOrEqual())
+		ENGINE_TTF_COMMAND(0x52, GreaterThan())
+		ENGINE_TTF_COMMAND(0x53, GreaterThanOrEqual())
+		ENGINE_TTF_COMMAND(0x54, Equal())
+		ENGINE_TTF_COMMAND(0x55, NotEqual())
+		ENGINE_TTF_COMMAND(0x56, Odd())
+		ENGINE_TTF_COMMAND(0x57, Even())
+		ENGINE_TTF_COMMAND(0x5A, LogicalAnd())
+		ENGINE_TTF_COMMAND(0x5B, LogicalOr())
+		ENGINE_TTF_COMMAND(0x5C, LogicalNot())
 		// Math functions
-		case 0x60: Add(); break;
-		case 0x61: Subtract(); break;
-		case 0x62: Divide(); break;
-		case 0x63: Multiply(); break;
-		case 0x64: AbsoluteValue(); break;
-		case 0x65: Negate(); break;
-		case 0x66: Floor(); break;
-		case 0x67: Ceiling(); break;
-		case 0x8B: MaximumTop2(); break;
-		case 0x8C: MinimumTop2(); break;
+		ENGINE_TTF_COMMAND(0x60, Add())
+		ENGINE_TTF_COMMAND(0x61, Subtract())
+		ENGINE_TTF_COMMAND(0x62, Divide())
+		ENGINE_TTF_COMMAND(0x63, Multiply())
+		ENGINE_TTF_COMMAND(0x64, AbsoluteValue())
+		ENGINE_TTF_COMMAND(0x65, Negate())
+		ENGINE_TTF_COMMAND(0x66, Floor())
+		ENGINE_TTF_COMMAND(0x67, Ceiling())
+		ENGINE_TTF_COMMAND(0x8B, MaximumTop2())
+		ENGINE_TTF_COMMAND(0x8C, MinimumTop2())
 		// Round
-		case 0x68: RoundInstruction(0); break;
-		case 0x69: RoundInstruction(1); break;
-		case 0x6A: RoundInstruction(2); break;
-		case 0x6B: RoundInstruction(3); break;
-		case 0x6C: NoRound(0); break;
-		case 0x6D: NoRound(1); break;
-		case 0x6E: NoRound(2); break;
-		case 0x6F: NoRound(3); break;
+		for (uint32_t command = 0x68; command <= 0x6B; command++) ENGINE_TTF_COMMAND(command, RoundInstruction(instruction._command & 0x03))
+		for (uint32_t command = 0x6C; command <= 0x6F; command++) ENGINE_TTF_COMMAND(command, NoRound(instruction._command & 0x03))
 		// Defining functions
-		case 0x2C: DefineFunction(); break;
-		case 0x2D: EndFunctionDefinition(); break;
-		case 0x2B: CallFunction(); break;
-		case 0x2A: LoopAndCallFunction(); break;
-		case 0x89: InstructionDefinition(); break;
+		ENGINE_TTF_COMMAND(0x2C, DefineFunction(instruction))
+		ENGINE_TTF_COMMAND(0x2D, EndFunctionDefinition())
+		ENGINE_TTF_COMMAND(0x2B, CallFunction())
+		ENGINE_TTF_COMMAND(0x2A, LoopAndCallFunction())
+		ENGINE_TTF_COMMAND(0x89, InstructionDefinition())
 		// Debugging
-		case 0x4F: Debug(); break;
+		ENGINE_TTF_COMMAND(0x4F, Debug())
 		// Miscellaneous
-		case 0x88: GetInformation(); break;
-		// case 0x91: GetVariation(); break;
+		ENGINE_TTF_COMMAND(0x88, GetInformation())
+		// ENGINE_TTF_COMMAND(0x91, GetVariation())
 
-		default:
-			THROW("[Renderer::TTFInstructionExecutor] Unkown TTF instruction = " + std::to_string(command));
-		}
+		#undef ENGINE_TTF_COMMAND
+		return table;
 	}
 
 	// ===================================================
@@ -548,27 +556,10 @@ namespace Renderer {
 	// ===================================================
 
 	// Push commands
-	void TTFInstructionExecutor::PushNBytes() {
-		uint8_t numBytes = GetNextInstructionByte();
-		for (uint8_t i = numBytes; i > 0; i--) {
-			PushStack(GetNextInstructionByte());
-		}
-	}
-	void TTFInstructionExecutor::PushNWords() {
-		uint8_t numWords = GetNextInstructionByte();
-		for (uint8_t i = numWords; i > 0; i--) {
-			PushStack(GetNextInstructionPaddedWord());
-		}
-	}
-	void TTFInstructionExecutor::PushBytes(const uint8_t num) {
-		for (uint8_t i = num; i > 0; i--) {
-			PushStack(GetNextInstructionByte());
-		}
-	}
-	void TTFInstructionExecutor::PushWords(const uint8_t num) {
-		for (uint8_t i = num; i > 0; i--) {
-			PushStack(GetNextInstructionPaddedWord());
-		}
+	void TTFInstructionExecutor::PushValues(const Program::Instruction& instruction) {
+		// The bytes and words were expanded when decoding, the last value ends on top
+		const int32_t* values = _program->_values.data() + instruction._data;
+		_interpreterStack.insert(_interpreterStack.end(), values, values + instruction._amount);
 	}
 
 	// Store commands
@@ -1408,10 +1399,12 @@ namespace Renderer {
 
 	// Managing the stack
 	void TTFInstructionExecutor::DuplicateTop() {
-		PushStack(_interpreterStack.front());
+		if (_interpreterStack.empty())
+			THROW("[Renderer::TTFInstructionExecutor] Can't retrieve a value of an empty stack");
+		PushStack(_interpreterStack.back());
 	}
 	void TTFInstructionExecutor::PopTop() {
-		_interpreterStack.pop_front();
+		GetNextStackInt32();
 	}
 	void TTFInstructionExecutor::ClearStack() {
 		_interpreterStack.clear();
@@ -1427,12 +1420,16 @@ namespace Renderer {
 	}
 	void TTFInstructionExecutor::CopyIndexedToTop() {
 		uint32_t index = GetNextStackUInt32();
-		PushStack(_interpreterStack[index - 1]);
+		if (index == 0 || index > _interpreterStack.size())
+			THROW("[Renderer::TTFInstructionExecutor] Invalid stack index");
+		PushStack(_interpreterStack[_interpreterStack.size() - index]);
 	}
 	void TTFInstructionExecutor::MoveIndexedToTop() {
 		uint32_t index = GetNextStackUInt32();
-		uint32_t value = _interpreterStack[index - 1];
-		_interpreterStack.erase(_interpreterStack.begin() + index - 1);
+		if (index == 0 || index > _interpreterStack.size())
+			THROW("[Renderer::TTFInstructionExecutor] Invalid stack index");
+		int32_t value = _interpreterStack[_interpreterStack.size() - index];
+		_interpreterStack.erase(_interpreterStack.end() - index);
 		PushStack(value);
 	}
 	void TTFInstructionExecutor::RollTopThree() {
@@ -1445,84 +1442,37 @@ namespace Renderer {
 	}
 
 	// Flow control
-	void TTFInstructionExecutor::IfTest() {
+	void TTFInstructionExecutor::IfTest(const Program::Instruction& instruction) {
 		uint32_t condition = GetNextStackUInt32();
 		if (condition) {
 			// Continue executing until the else statement
 			return;
 		}
-		else {
-			// Find an else or an endif statement
-			int nesting = 0;
-			while (IsNextInstructionLeft()) {
-				uint8_t nextInstruction = GetNextInstructionByte();
-				// Skip the instructions taking values from the instruction stream
-				if (nextInstruction >= 0xB0 && nextInstruction <= 0xB7) { JumpForwardAmountInstruction(nextInstruction - 0xB0 + 1); }
-				else if (nextInstruction >= 0xB8 && nextInstruction <= 0xBF) { JumpForwardAmountInstruction((nextInstruction - 0xB8 + 1) * 2); }
-				else if (nextInstruction == 0x40) { uint8_t amount = GetNextInstructionByte(); JumpForwardAmountInstruction(amount); }
-				else if (nextInstruction == 0x41) { uint8_t amount = GetNextInstructionByte() * 2; JumpForwardAmountInstruction(amount); }
-				else if (nextInstruction == 0x58) { // If
-					nesting++;
-				}
-				else if (nextInstruction == 0x1B && nesting == 0) { // Else
-					return;
-				}
-				else if (nextInstruction == 0x59) { // Endif
-					if (nesting != 0) {
-						nesting--;
-						continue;
-					}
-					return;
-				}
-			}
-		}
+		// Continue after the else or the endif statement, found when decoding
+		_current = instruction._data;
 	}
-	void TTFInstructionExecutor::Else() {
-		// Skip forward to the endif statement
-		int nesting = 0;
-		while (IsNextInstructionLeft()) {
-			uint8_t nextInstruction = GetNextInstructionByte();
-			// Skip the instructions taking values from the instruction stream
-			if (nextInstruction >= 0xB0 && nextInstruction <= 0xB7) { JumpForwardAmountInstruction(nextInstruction - 0xB0 + 1); }
-			else if (nextInstruction >= 0xB8 && nextInstruction <= 0xBF) { JumpForwardAmountInstruction((nextInstruction - 0xB8 + 1) * 2); }
-			else if (nextInstruction == 0x40) { uint8_t amount = GetNextInstructionByte(); JumpForwardAmountInstruction(amount); }
-			else if (nextInstruction == 0x41) { uint8_t amount = GetNextInstructionByte() * 2; JumpForwardAmountInstruction(amount); }
-			else if (nextInstruction == 0x58) { // If
-				nesting++;
-			}
-			else if (nextInstruction == 0x59) { // Endif
-				if (nesting != 0) {
-					nesting--;
-					continue;
-				}
-				return;
-			}
-		}
+	void TTFInstructionExecutor::Else(const Program::Instruction& instruction) {
+		// Skip forward to after the endif statement
+		_current = instruction._data;
 	}
 	void TTFInstructionExecutor::EndIf() {
 		// Ignore this statement
 	}
-	void TTFInstructionExecutor::JumpRelativeOnTrue() {
+	void TTFInstructionExecutor::JumpRelativeOnTrue(const Program::Instruction& instruction) {
 		uint32_t condition = GetNextStackUInt32();
 		int32_t amountJump = GetNextStackInt32();
-		if (amountJump == 0)
-			THROW("[Renderer::TTFInstructionExecutor] Can't jump back to same jump instruction, this will cause a loop");
 		if (condition)
-			JumpForwardAmountInstruction(amountJump - 1);
+			JumpRelative(instruction, amountJump);
 	}
-	void TTFInstructionExecutor::Jump() {
+	void TTFInstructionExecutor::Jump(const Program::Instruction& instruction) {
 		int32_t amountJump = GetNextStackInt32();
-		if (amountJump == 0)
-			THROW("[Renderer::TTFInstructionExecutor] Can't jump back to same jump instruction, this will cause a loop");
-		JumpForwardAmountInstruction(amountJump - 1);
+		JumpRelative(instruction, amountJump);
 	}
-	void TTFInstructionExecutor::JumpRelativeOnFalse() {
+	void TTFInstructionExecutor::JumpRelativeOnFalse(const Program::Instruction& instruction) {
 		uint32_t condition = GetNextStackUInt32();
 		int32_t amountJump = GetNextStackInt32();
-		if (amountJump == 0)
-			THROW("[Renderer::TTFInstructionExecutor] Can't jump back to same jump instruction, this will cause a loop");
 		if (!condition)
-			JumpForwardAmountInstruction(amountJump - 1);
+			JumpRelative(instruction, amountJump);
 	}
 
 	// Logical functions
@@ -1753,47 +1703,28 @@ namespace Renderer {
 	}
 
 	// Defining functions
-	void TTFInstructionExecutor::DefineFunction() {
+	void TTFInstructionExecutor::DefineFunction(const Program::Instruction& instruction) {
 		uint32_t f = GetNextStackUInt32();
-		size_t functionStart = _currentInstruction;
-		size_t functionEnd = _currentInstruction + 1;
-		while(functionEnd < _instructionStream.size()) {
-			uint8_t nextInstruction = GetNextInstructionByte();
-			// Skip the instructions taking values from the instruction stream
-			if (nextInstruction >= 0xB0 && nextInstruction <= 0xB7) { JumpForwardAmountInstruction(nextInstruction - 0xB0 + 1); }
-			else if (nextInstruction >= 0xB8 && nextInstruction <= 0xBF) { JumpForwardAmountInstruction((nextInstruction - 0xB8 + 1) * 2); }
-			else if (nextInstruction == 0x40) { uint8_t amount = GetNextInstructionByte(); JumpForwardAmountInstruction(amount); }
-			else if (nextInstruction == 0x41) { uint8_t amount = GetNextInstructionByte() * 2; JumpForwardAmountInstruction(amount); }
-			else if (nextInstruction == 0x2D) { // Function end
-				functionEnd = _currentInstruction - 1;
-				break;
-			}
-		}
-		_functions[f] = std::vector<uint8_t>(_instructionStream.begin() + functionStart, _instructionStream.begin() + functionEnd);
+		if (f >= _functions.size())
+			_functions.resize(f + 1);
+		// The function is the range up to its end, it shares the program instead of copying its instructions
+		_functions[f]._program = _program;
+		_functions[f]._begin = _current;
+		_functions[f]._end = instruction._data;
+		_current = instruction._data + 1;
 	}
 	void TTFInstructionExecutor::EndFunctionDefinition() {
 		// Used by defineFunction
 	}
 	void TTFInstructionExecutor::CallFunction() {
 		uint32_t f = GetNextStackUInt32();
-
-		_currentlyExecutingFunctions.push_front(ExecutingFunction());
-		_currentlyExecutingFunctions.front()._function = f;
-		while (_currentlyExecutingFunctions.front()._currentInstruction < _functions[f].size()) {
-			ExecuteCommand(_functions[f][_currentlyExecutingFunctions.front()._currentInstruction++]);
-		}
-		_currentlyExecutingFunctions.pop_front();
+		RunFunction(f);
 	}
 	void TTFInstructionExecutor::LoopAndCallFunction() {
 		uint32_t f = GetNextStackUInt32();
 		uint32_t count = GetNextStackUInt32();
 		for (uint32_t i = 0; i < count; i++) {
-			_currentlyExecutingFunctions.push_front(ExecutingFunction());
-			_currentlyExecutingFunctions.front()._function = f;
-			while (_currentlyExecutingFunctions.front()._currentInstruction < _functions[f].size()) {
-				ExecuteCommand(_functions[f][_currentlyExecutingFunctions.front()._currentInstruction++]);
-			}
-			_currentlyExecutingFunctions.pop_front();
+			RunFunction(f);
 		}
 	}
 	void TTFInstructionExecutor::InstructionDefinition() {
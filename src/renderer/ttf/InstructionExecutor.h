@@ -25,10 +25,29 @@ namespace Renderer {
 	class TTFInstructionExecutor {
 	public:
 
+		/**
+		 * @brief An instruction stream decoded once, so executing it never has to scan the bytes again
+		 * The values of the push instructions are expanded into one array, the if, else and function definitions
+		 * know the instruction after their end and the jumps find their target through the byte offsets.
+		 */
+		struct Program {
+			struct Instruction {
+				uint8_t _command;
+				uint32_t _offset;// In bytes from the start of the stream, the jumps are relative to it
+				uint32_t _data = 0;// Push: the first value, if/else: the instruction to continue at when skipping, function definition: its end
+				uint32_t _amount = 0;// Push: the amount of values
+			};
+			std::vector<Instruction> _instructions;
+			std::vector<int32_t> _values;
+			uint32_t _size = 0;// In bytes
+		};
+		static std::shared_ptr<const Program> Decode(const std::vector<uint8_t>& stream);
+
 		// Settings (!These are manditory to set!)
 		void SetMaxStorageAreaSize(const size_t size);
 		void SetMaxFunctions(const size_t size);
 		void SetMaxTwilightPoints(const size_t size);
+		void SetMaxStackElements(const size_t size);
 		void SetScale(const uint32_t unitsPerEM, const uint32_t pointSize);
 		// The flags should have already been expanded so every repeat is in the array
 		// The inputted points are still in FDU
@@ -51,20 +70,6 @@ namespace Renderer {
 			return FromF26Dot6<float>(_points[_points.size() - 1].y);
 		}
 
-		// Instruction Stream
-		inline void AddToInstructionStream(const std::vector<uint8_t>* instructions) {
-			_instructionStream.insert(_instructionStream.end(), instructions->begin(), instructions->end());
-		}
-		inline void AddToInstructionStream(const uint8_t value) {
-			_instructionStream.push_back(value);
-		}
-		inline void SetInstructionStream(const std::vector<uint8_t>* instructions) {
-			_instructionStream = *instructions;
-		}
-		inline void ReserveInstructionStreamSpace(const size_t size) {
-			_instructionStream.reserve(size);
-		}
-
 		// Control Values
 		inline void SetControlValues(const std::vector<int16_t>* values) {
 			_controlValues.reserve(values->size());
@@ -79,20 +84,20 @@ namespace Renderer {
 			_controlValues.reserve(size);
 		}
 
-		void ExecuteStack();
+		// The functions the program defines keep a reference to it, so copies of the executor share them
+		void Execute(const std::shared_ptr<const Program>& program);
 
 		// Used to store the state after the FPGM and CVT program
 		void StoreGraphicsState();
 		void BindStoredGraphicsState();
 
-		std::set<uint8_t> _usedInstructions;
-
 	private:
 
-		inline bool IsNextInstructionLeft();
-		inline uint8_t GetNextInstructionByte();
-		inline int32_t GetNextInstructionPaddedWord();
-		inline void JumpForwardAmountInstruction(const int32_t amount);
+		// Runs the instructions from _current up to _end of _program
+		void Run();
+		void RunFunction(const uint32_t f);
+		// The amount is in bytes from the start of the jump instruction
+		void JumpRelative(const Program::Instruction& instruction, const int32_t amount);
 
 		inline void PushStack(const bool value);
 		inline void PushStack(const uint8_t value);
@@ -102,7 +107,9 @@ namespace Renderer {
 		inline uint32_t GetNextStackUInt32();
 		inline F26Dot6 GetNextStackF26Dot6();
 
-		void ExecuteCommand(const uint8_t command);
+		// Every command gets the instruction it executes, the table is indexed with the command byte
+		typedef void (*Command)(TTFInstructionExecutor& executor, const Program::Instruction& instruction);
+		static std::array<Command, 256> CreateCommandTable();
 
 		// F26Dot6 helpers
 		template<class T>
@@ -141,19 +148,23 @@ namespace Renderer {
 		// Utils
 		inline Util::Vec2<F26Dot6> RoundToGrid(const Util::Vec2<F26Dot6> p);
 
-		size_t _currentInstruction = 0;
-		std::vector<uint8_t> _instructionStream;
-		std::deque<int32_t> _interpreterStack;
+		// The program or function that is executing
+		std::shared_ptr<const Program> _program;
+		uint32_t _begin = 0;
+		uint32_t _current = 0;
+		uint32_t _end = 0;
+		std::vector<int32_t> _interpreterStack;// The top is at the back
 		std::vector<F26Dot6> _controlValues;
 		bool _controlValuesScaled = false;
 		std::vector<uint32_t> _storageArea;
 
-		struct ExecutingFunction {
-			uint32_t _function;
-			size_t _currentInstruction;
+		// A range of the instructions of the program that defined it
+		struct Function {
+			std::shared_ptr<const Program> _program;
+			uint32_t _begin = 0;
+			uint32_t _end = 0;
 		};
-		std::deque<ExecutingFunction> _currentlyExecutingFunctions;
-		std::vector<std::vector<uint8_t>> _functions;
+		std::vector<Function> _functions;
 
 		std::vector<uint8_t> _originalFlags;
 		std::vector<Util::Vec2<F26Dot6>> _originalPoints;
@@ -212,6 +223,8 @@ namespace Renderer {
 		};
 		GraphicsState _state;
 		GraphicsState _storedState;
+		std::vector<F26Dot6> _storedControlValues;
+		std::vector<uint32_t> _storedStorageArea;
 
 
 		// Helpers
@@ -226,10 +239,7 @@ namespace Renderer {
 		// ===================================================
 		
 		// Push commands
-		void PushNBytes();
-		void PushNWords();
-		void PushBytes(const uint8_t num);
-		void PushWords(const uint8_t num);
+		void PushValues(const Program::Instruction& instruction);
 
 		// Store commands
 		void ReadStore();
@@ -340,12 +350,12 @@ namespace Renderer {
 		void RollTopThree();
 
 		// Flow control
-		void IfTest();
-		void Else();
+		void IfTest(const Program::Instruction& instruction);
+		void Else(const Program::Instruction& instruction);
 		void EndIf();
-		void JumpRelativeOnTrue();
-		void Jump();
-		void JumpRelativeOnFalse();
+		void JumpRelativeOnTrue(const Program::Instruction& instruction);
+		void Jump(const Program::Instruction& instruction);
+		void JumpRelativeOnFalse(const Program::Instruction& instruction);
 
 		// Logical functions
 		void LessThan();
@@ -377,7 +387,7 @@ namespace Renderer {
 		void NoRound(const uint8_t ab);
 
 		// Defining functions
-		void DefineFunction();
+		void DefineFunction(const Program::Instruction& instruction);
 		void EndFunctionDefinition();
 		void CallFunction();
 		void LoopAndCallFunction();
@@ -143,6 +143,60 @@ namespace Vulkan {
         _transferBuffer.CopyTo(context, commandBuffer, this);
     }
 
+
+
+
+    void RingVertexBuffer::Init(const Context& context, const uint32_t frameSize, const uint32_t framesInFlight) {
+        ASSERT(framesInFlight>0, "[Vulkan::RingVertexBuffer] Needs at least one frame in flight")
+        _frameSize = AlignSize(frameSize);
+        _framesInFlight = framesInFlight;
+        BaseBuffer::Init(
+            context,
+            (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT),
+            _frameSize * _framesInFlight,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+        UpdateMappedData(context);
+    }
+    void RingVertexBuffer::UpdateMappedData(const Context& context) {
+        VmaAllocationInfo allocationInfo;
+        vmaGetAllocationInfo(context._allocator, _allocation, &allocationInfo);
+        _ringMappedData = allocationInfo.pMappedData;
+        ASSERT(_ringMappedData!=nullptr, "[Vulkan::RingVertexBuffer] Failed to persistently map the ring buffer")
+    }
+
+    void RingVertexBuffer::StartFrame(Context& context, const uint32_t frameInFlight, const std::initializer_list<uint32_t> allocations) {
+        ASSERT(frameInFlight<_framesInFlight, "[Vulkan::RingVertexBuffer] Frame in flight is out of range")
+        uint32_t needed = 0;
+        for(const uint32_t size : allocations) needed += AlignSize(size);
+        if(needed > _frameSize) {
+            // The other partitions may still be read by the GPU
+            context.WaitIdle();
+            const uint32_t newFrameSize = std::bit_ceil(needed);
+            INFO("[Vulkan::RingVertexBuffer] Growing the partitions from " + std::to_string(_frameSize) + " to " + std::to_string(newFrameSize) + " bytes")
+            _frameSize = newFrameSize;
+            BaseBuffer::ResizeInternal(context, _frameSize * _framesInFlight);
+            UpdateMappedData(context);
+        }
+        _frameStart = frameInFlight * _frameSize;
+        _frameOffset = 0;
+    }
+    uint32_t RingVertexBuffer::Allocate(const uint32_t size) {
+        ASSERT(_frameOffset+AlignSize(size)<=_frameSize, "[Vulkan::RingVertexBuffer] Allocation was not reserved in StartFrame")
+        const uint32_t offset = _frameStart + _frameOffset;
+        _frameOffset += AlignSize(size);
+        return offset;
+    }
+    void RingVertexBuffer::EndFrame(const Context& context) {
+        if(_frameOffset == 0) return;
+        const VkResult result = vmaFlushAllocation(context._allocator, _allocation, _frameStart, _frameOffset);
+        ASSERT(result == VK_SUCCESS, "[Vulkan::RingVertexBuffer] Failed to flush the ring buffer")
+    }
+    void RingVertexBuffer::CopyTo(CommandBuffer& commandBuffer, VertexBuffer& buffer, const std::vector<VkBufferCopy>& regions) {
+        if(regions.empty()) return;
+        commandBuffer.CopyBuffer(_buffer, buffer._buffer, regions);
+    }
+
 }
 }
 }
\ No newline at end of file
@@ -23,8 +23,8 @@ namespace Vulkan {
         void SetData(Context& context, const T (&data)[S]) {
             SetData(context, &data, sizeof(T)*S);
         }
-        template<class T>
-        void SetData(Context& context, const std::vector<T>& data) {
+        template<class T, class Allocator>
+        void SetData(Context& context, const std::vector<T, Allocator>& data) {
             SetData(context, data.data(), (uint32_t)(sizeof(T)*data.size()));
         }
 
@@ -54,6 +54,7 @@ namespace Vulkan {
         void Cleanup(const Context& context);
         
         friend class TransferBuffer;
+        friend class RingVertexBuffer;
 
         VkBuffer _buffer = VK_NULL_HANDLE;
         uint32_t _size;
@@ -79,6 +80,12 @@ namespace Vulkan {
             );
         }
         inline void Cleanup(const Context& context) { BaseBuffer::Cleanup(context); }
+
+        // Recreates the buffer when it is smaller than size, the old content is lost
+        inline void Resize(const Context& context, const uint32_t size) {
+            if(size > _size) ResizeInternal(context, size);
+        }
+        inline uint32_t GetSize() const { return _size; }
     
     private:
         friend class CommandBuffer;
@@ -115,6 +122,12 @@ namespace Vulkan {
         }
         inline void Cleanup(const Context& context) { BaseBuffer::Cleanup(context); }
 
+        // Recreates the buffer when it is smaller than size, the old content is lost
+        inline void Resize(const Context& context, const uint32_t size) {
+            if(size > _size) ResizeInternal(context, size);
+        }
+        inline uint32_t GetSize() const { return _size; }
+
         void CopyTo(const Context& context, const CommandBuffer commandBuffer, BaseBuffer* buffer);
         void CopyTo(const Context& context, const CommandBuffer commandBuffer, VkImage image, const uint32_t width, const uint32_t height);
         void CopyTo(Context& context, BaseBuffer* buffer);
@@ -196,6 +209,54 @@ namespace Vulkan {
         friend class CommandBuffer;
     };
 
+    /**
+     * @brief A persistently mapped vertex buffer that is split into one partition per frame in flight
+     * Every frame the data is suballocated from the partition of that frame, so writing is a memcpy into
+     * mapped memory without mapping, recreating the buffer or submitting a transfer.
+     * The buffer only gets recreated when a frame needs more than a partition, it then grows to fit that frame.
+     *
+     * @warning The caller has to make sure the GPU is done with the frame in flight before starting it again (fence)
+     */
+    class RingVertexBuffer : public BaseBuffer {
+    public:
+
+        void Init(const Context& context, const uint32_t frameSize, const uint32_t framesInFlight);
+        inline void Cleanup(const Context& context) { BaseBuffer::Cleanup(context); }
+
+        /**
+         * @brief Starts suballocating from the partition of the frame in flight
+         * Grows (and waits for the device) when the allocations do not fit in a partition
+         *
+         * @param frameInFlight The frame in flight that is recorded
+         * @param allocations The sizes of all the allocations that will be made this frame
+         */
+        void StartFrame(Context& context, const uint32_t frameInFlight, const std::initializer_list<uint32_t> allocations);
+        /**
+         * @brief Reserves space in the partition of the current frame
+         *
+         * @param size The amount of bytes
+         * @return The offset in the buffer, to bind the buffer at and to get the mapped memory with
+         */
+        uint32_t Allocate(const uint32_t size);
+        inline void* GetMappedData(const uint32_t offset) { return static_cast<char*>(_ringMappedData) + offset; }
+        // Makes the data written this frame visible to the GPU (only does something on non coherent memory)
+        void EndFrame(const Context& context);
+        // Records a copy of the regions (srcOffset is an offset returned by Allocate) to a gpu local buffer
+        void CopyTo(CommandBuffer& commandBuffer, VertexBuffer& buffer, const std::vector<VkBufferCopy>& regions);
+
+    private:
+        friend class CommandBuffer;
+
+        static inline uint32_t AlignSize(const uint32_t size) { return (size + 15) & ~15u; }
+        void UpdateMappedData(const Context& context);
+
+        void* _ringMappedData = nullptr;
+        uint32_t _frameSize = 0;
+        uint32_t _framesInFlight = 1;
+        uint32_t _frameStart = 0;
+        uint32_t _frameOffset = 0;
+    };
+
 }
 }
 }
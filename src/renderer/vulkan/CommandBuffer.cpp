@@ -32,7 +32,6 @@ namespace Vulkan {
     }
 
     void CommandBuffer::AcquireNextSwapchainFrame(const Context& context, Swapchain& swapchain, const Semaphore& imageAvailable) {
-        _currentFrame = (_currentFrame + 1) % _framesInFlight;
         vkAcquireNextImageKHR(context._device, swapchain._swapChain, UINT64_MAX, imageAvailable[_currentFrame], VK_NULL_HANDLE, &swapchain._nextFramebuffer);
     }
 
@@ -111,6 +110,11 @@ namespace Vulkan {
         VkDeviceSize offsets[] = {offset};
         vkCmdBindVertexBuffers(_commandBuffers[_currentFrame], binding, 1, vertexBuffers, offsets);
     }
+    void CommandBuffer::BindVertexBuffer(const RingVertexBuffer& buffer, const uint32_t binding, const uint32_t offset) {
+        VkBuffer vertexBuffers[] = {buffer._buffer};
+        VkDeviceSize offsets[] = {offset};
+        vkCmdBindVertexBuffers(_commandBuffers[_currentFrame], binding, 1, vertexBuffers, offsets);
+    }
     void CommandBuffer::BindIndexBuffer(const IndexBuffer& buffer) {
         vkCmdBindIndexBuffer(_commandBuffers[_currentFrame], buffer._buffer, 0, VK_INDEX_TYPE_UINT16);
     }
@@ -129,6 +133,16 @@ namespace Vulkan {
         copyRegion.size = size;
         vkCmdCopyBuffer(_commandBuffers[_currentFrame], from, to, 1, &copyRegion);
     }
+    void CommandBuffer::CopyBuffer(const VkBuffer from, const VkBuffer to, const std::vector<VkBufferCopy>& regions) {
+        vkCmdCopyBuffer(_commandBuffers[_currentFrame], from, to, (uint32_t)regions.size(), regions.data());
+    }
+    void CommandBuffer::PipelineBarrier(const VkPipelineStageFlags srcStage, const VkAccessFlags srcAccess, const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess) {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(_commandBuffers[_currentFrame], srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
     void CommandBuffer::CopyBufferToImage(const VkBuffer from, const VkImage to, const uint32_t width, const uint32_t height) {
         VkBufferImageCopy region{};
         region.bufferOffset = 0;
@@ -155,6 +169,16 @@ namespace Vulkan {
             &region
         );
     }
+    void CommandBuffer::CopyBufferToImage(const VkBuffer from, const VkImage to, const std::vector<VkBufferImageCopy>& regions) {
+        vkCmdCopyBufferToImage(
+            _commandBuffers[_currentFrame],
+            from,
+            to,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            (uint32_t)regions.size(),
+            regions.data()
+        );
+    }
     void CommandBuffer::TransferImageLayout(const VkImage image, const VkImageLayout oldLayout, const VkImageLayout newLayout, const uint32_t sourceQueueFamily, const uint32_t destinationQueueFamily) {
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -184,10 +208,27 @@ namespace Vulkan {
 
             sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
             destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            if(_queue == QueueType::TransferQueue) {
+                // A transfer queue has no shader stages, the fence of the upload makes the data available to the graphics queue
+                barrier.dstAccessMask = 0;
+                destinationStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+            }
+        } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            // The previous frames may still sample the image
+            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        } else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+            // An image that is bound before anything is written to it
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
         } else { THROW("[Vulkan::CommandBuffer] Unsupported transition") }
 
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = 0;
         vkCmdPipelineBarrier(
             _commandBuffers[_currentFrame],
             sourceStage, destinationStage,
@@ -231,6 +272,12 @@ namespace Vulkan {
         vkWaitForFences(context._device, 1, &fence[_currentFrame], VK_TRUE, UINT64_MAX);
         vkResetFences(context._device, 1, &fence[_currentFrame]);
     }
+    void CommandBuffer::WaitAllFences(const Context& context, const Fence& fence) {
+        vkWaitForFences(context._device, (uint32_t)fence.size(), fence.data(), VK_TRUE, UINT64_MAX);
+    }
+    bool CommandBuffer::IsFenceSignaled(const Context& context, const Fence& fence) {
+        return vkGetFenceStatus(context._device, fence[_currentFrame]) == VK_SUCCESS;
+    }
 
     void CommandBuffer::Submit(
         Context& context, 
@@ -22,6 +22,9 @@ namespace Vulkan {
         void Init(Context& context, const QueueType queueType, const uint32_t framesInFlight=1);
         void Cleanup(const Context& context);
 
+        // Moves on to the command buffer, fences and semaphores of the next frame in flight
+        void NextFrameInFlight() { _currentFrame = (_currentFrame + 1) % _framesInFlight; }
+        uint32_t GetCurrentFrameInFlight() const { return _currentFrame; }
         void AcquireNextSwapchainFrame(const Context& context, Swapchain& swapchain, const Semaphore& imageAvailable);
 
         void StartRecording(const Context& context, const uint32_t specificFrameInFlight=UINT32_MAX, const bool oneTimeUse=false);
@@ -43,12 +46,17 @@ namespace Vulkan {
         void BindGraphicsPipeline(const Pipeline& pipeline);
         void BindVertexBuffer(const VertexBuffer& buffer, const uint32_t binding=0, const uint32_t offset=0);
         void BindVertexBuffer(const EfficientVertexBuffer& buffer, const uint32_t binding=0, const uint32_t offset=0);
+        void BindVertexBuffer(const RingVertexBuffer& buffer, const uint32_t binding, const uint32_t offset);
         void BindIndexBuffer(const IndexBuffer& buffer);
         void BindIndexBuffer(const EfficientIndexBuffer& buffer);
         void BindDescriptorSet(const Pipeline& pipeline);
 
         void CopyBuffer(const VkBuffer from, const VkBuffer to, const uint32_t size);
+        void CopyBuffer(const VkBuffer from, const VkBuffer to, const std::vector<VkBufferCopy>& regions);
+        // A global memory barrier, pass 0 as access masks for an execution only barrier
+        void PipelineBarrier(const VkPipelineStageFlags srcStage, const VkAccessFlags srcAccess, const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess);
         void CopyBufferToImage(const VkBuffer from, const VkImage to, const uint32_t width, const uint32_t height);
+        void CopyBufferToImage(const VkBuffer from, const VkImage to, const std::vector<VkBufferImageCopy>& regions);
         void TransferImageLayout(const VkImage, const VkImageLayout oldLayout, const VkImageLayout newLayout, const uint32_t sourceQueueFamily=VK_QUEUE_FAMILY_IGNORED, const uint32_t destinationQueueFamily=VK_QUEUE_FAMILY_IGNORED);
 
         void Draw(const int vertexCount, const int instanceCount, const int vertexOffset=0, const int instanceOffset=0);
@@ -58,6 +66,10 @@ namespace Vulkan {
         Fence CreateFence(const Context& context, const bool signaled=true);
 
         void WaitFence(const Context& context, const Fence& fence);
+        // Waits for the fence of every frame in flight, does not reset the fences
+        void WaitAllFences(const Context& context, const Fence& fence);
+        // Does not wait and does not reset the fence
+        bool IsFenceSignaled(const Context& context, const Fence& fence);
 
         void Submit(Context& context, const std::initializer_list<std::pair<Semaphore&, VkPipelineStageFlags>> waitFor={}, const std::initializer_list<Semaphore> signalSemaphore={}, const Fence& signalFence={});
         void PresentResult(Context& context, const Swapchain& swapchain, const std::initializer_list<Semaphore> waitFor);
@@ -53,6 +53,7 @@ namespace Vulkan {
         friend class CommandBuffer;
         friend class BaseBuffer;
         friend class EfficientGPUBuffer;
+        friend class RingVertexBuffer;
         friend class Texture;
         friend class TextureSampler;
 
@@ -61,6 +61,9 @@ namespace Vulkan {
         constexpr Attribute DVec2 = Attribute(VK_FORMAT_R64G64_SFLOAT, 26);
         constexpr Attribute DVec3 = Attribute(VK_FORMAT_R64G64B64_SFLOAT, 24);
         constexpr Attribute DVec4 = Attribute(VK_FORMAT_R64G64B64A64_SFLOAT, 32);
+        // Read as a vec4 between 0 and 1 by the shader
+        constexpr Attribute UNorm8Vec4 = Attribute(VK_FORMAT_R8G8B8A8_UNORM, 4);
+        constexpr Attribute UNorm16Vec4 = Attribute(VK_FORMAT_R16G16B16A16_UNORM, 8);
     }
     class PipelineCreator {
     public:
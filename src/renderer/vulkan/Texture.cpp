@@ -81,6 +81,20 @@ namespace Vulkan {
         copyCommandBuffer.TransferImageLayout(_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
         _transferBuffer.CopyTo(context, copyCommandBuffer, _image, _rectSize.x, _rectSize.y);
         copyCommandBuffer.TransferImageLayout(_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        _written = true;
+    }
+    void Texture::CopyRegions(CommandBuffer& commandBuffer, const TransferBuffer& buffer, const std::vector<VkBufferImageCopy>& regions) {
+        if(regions.empty()) return;
+        // The first copy has nothing to keep
+        commandBuffer.TransferImageLayout(_image, _written ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        commandBuffer.CopyBufferToImage(buffer._buffer, _image, regions);
+        commandBuffer.TransferImageLayout(_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        _written = true;
+    }
+    void Texture::PrepareForSampling(CommandBuffer& commandBuffer) {
+        if(_written) return;
+        commandBuffer.TransferImageLayout(_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        _written = true;
     }
     void Texture::TransferCompleteOnCommandBuffer(Context& context) {
         _transferBuffer.Cleanup(context);
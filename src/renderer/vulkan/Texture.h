@@ -58,6 +58,12 @@ namespace Vulkan {
         void EndTransferingData(Context& context);
         void EndTransferingData(Context& context, CommandBuffer& copyCommandBuffer);
         void TransferCompleteOnCommandBuffer(Context& context);
+        // Records a copy of the regions of the buffer into the image, the rest of the image keeps its content
+        // Can be recorded on the graphics command buffer of a frame, as it waits for the previous frames to stop sampling the image
+        void CopyRegions(CommandBuffer& commandBuffer, const TransferBuffer& buffer, const std::vector<VkBufferImageCopy>& regions);
+        // Records the transition to the shader read layout of an image that has not been written yet, does nothing otherwise
+        // Needed when the texture is bound to a descriptor set before its first copy
+        void PrepareForSampling(CommandBuffer& commandBuffer);
 
         uint32_t GetBoundDescriptorSlot() { return _boundDescriptorSlot; }
 
@@ -70,6 +76,7 @@ namespace Vulkan {
         TransferBuffer _transferBuffer;
         size_t _size;
         Util::Vec2U32 _rectSize;
+        bool _written = false;// Whether the image has been transitioned to the shader read layout
 
         uint32_t _boundDescriptorSlot = UINT32_MAX;
     };
@@ -129,6 +129,15 @@ namespace Util {
         }
         return true;
     }
+    bool FileManager::CanUseCache(const CacheID cacheID, const std::vector<File>& cacheFileDependency) {
+        File cacheFile = Cache(cacheID);
+        if(!cacheFile.Exists()) return false;
+        std::filesystem::file_time_type lastCacheChange = cacheFile.LastChange();
+        for(const File& file : cacheFileDependency) {
+            if(!file.Exists() || file.LastChange() > lastCacheChange) return false;
+        }
+        return true;
+    }
 
 }
 }
\ No newline at end of file
@@ -175,6 +175,8 @@ namespace Util {
     
         /// Will check if one of the inputFilePaths changed after the cacheID was created
         static bool CanUseCache(const CacheID cacheID, const std::initializer_list<std::string> inputFiles);
+        /// Same as above, but with files that were already retrieved (a file that does not exist anymore invalidates the cache)
+        static bool CanUseCache(const CacheID cacheID, const std::vector<File>& inputFiles);
 
     private:
 
@@ -0,0 +1,46 @@
+#include "util/FrameArena.h"
+
+namespace Engine {
+namespace Util {
+
+    FrameArena::FrameArena(const size_t capacity, std::pmr::memory_resource* upstream) : _upstream(upstream), _capacity(capacity) {
+        _memory = (uint8_t*)_upstream->allocate(_capacity, alignof(std::max_align_t));
+    }
+    FrameArena::~FrameArena() {
+        Reset();
+        _upstream->deallocate(_memory, _capacity, alignof(std::max_align_t));
+    }
+
+    void FrameArena::Reset() {
+        _highWaterMark = std::max(_highWaterMark, GetUsed());
+        if(_overflows.size()) {
+            for(const Overflow& overflow : _overflows) {
+                _upstream->deallocate(overflow._memory, overflow._size, overflow._alignment);
+            }
+            _overflows.clear();
+            // Grow so the next frame with the same amount of allocations fits
+            _upstream->deallocate(_memory, _capacity, alignof(std::max_align_t));
+            const size_t newCapacity = std::bit_ceil(_highWaterMark);
+            INFO("[Util::FrameArena] Growing the frame arena from " + std::to_string(_capacity) + " to " + std::to_string(newCapacity) + " bytes (high-water mark " + std::to_string(_highWaterMark) + " bytes)")
+            _capacity = newCapacity;
+            _memory = (uint8_t*)_upstream->allocate(_capacity, alignof(std::max_align_t));
+        }
+        _used = 0;
+        _overflowUsed = 0;
+    }
+
+    void* FrameArena::do_allocate(const size_t bytes, const size_t alignment) {
+        const size_t start = (((size_t)_memory + _used + alignment - 1) & ~(alignment - 1)) - (size_t)_memory;
+        if(start + bytes <= _capacity) {
+            _used = start + bytes;
+            return _memory + start;
+        }
+        // Does not fit anymore, let the upstream handle it until the next reset
+        void* memory = _upstream->allocate(bytes, alignment);
+        _overflows.push_back(Overflow{memory, bytes, alignment});
+        _overflowUsed += bytes;
+        return memory;
+    }
+
+}
+}
\ No newline at end of file
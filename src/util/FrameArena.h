@@ -0,0 +1,68 @@
+#ifndef ENGINE_UTIL_FRAME_ARENA_H
+#define ENGINE_UTIL_FRAME_ARENA_H
+
+#include "core/PCH.h"
+
+// The amount of bytes the frame arena starts with, it grows when a frame needs more
+#ifndef ENGINE_UTIL_FRAME_ARENA_SIZE
+    #define ENGINE_UTIL_FRAME_ARENA_SIZE 1024*1024
+#endif
+
+namespace Engine {
+namespace Util {
+
+    /**
+     * @brief A linear allocator for memory that only has to live until the end of the frame
+     * Allocating is a pointer bump and deallocating does nothing, all the memory is released at once with Reset.
+     * It can be used with every std::pmr container:
+     * ```
+     * std::pmr::vector<Entity> hits(&arena);
+     * ```
+     * When a frame needs more memory than the arena has, the extra memory is taken from the upstream resource
+     * and the arena grows to the high-water mark on the next Reset.
+     *
+     * @warning Not thread safe, only use it from the thread running the game loop
+     * @warning Everything allocated in the arena is invalid after Reset, the destructors are not called
+     */
+    class FrameArena : public std::pmr::memory_resource {
+    public:
+        FrameArena(const size_t capacity = ENGINE_UTIL_FRAME_ARENA_SIZE, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+        ~FrameArena();
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        // Releases all the memory allocated since the previous reset
+        void Reset();
+
+        // Bytes allocated since the previous reset
+        inline size_t GetUsed() const { return _used + _overflowUsed; }
+        inline size_t GetCapacity() const { return _capacity; }
+        // The largest amount of bytes a single frame used
+        inline size_t GetHighWaterMark() const { return _highWaterMark; }
+
+    protected:
+        void* do_allocate(const size_t bytes, const size_t alignment) override;
+        void do_deallocate(void* p, const size_t bytes, const size_t alignment) override {}
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    private:
+        std::pmr::memory_resource* _upstream;
+        uint8_t* _memory = nullptr;
+        size_t _capacity = 0;
+        size_t _used = 0;
+        size_t _highWaterMark = 0;
+
+        struct Overflow {
+            void* _memory;
+            size_t _size;
+            size_t _alignment;
+        };
+        std::vector<Overflow> _overflows;
+        size_t _overflowUsed = 0;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "util/Profiler.h"
+
+#if ENGINE_ENABLE_PROFILER
+#include "util/FileManager.h"
+
+namespace Engine {
+namespace Util {
+
+    const std::chrono::steady_clock::time_point Profiler::_epoch = std::chrono::steady_clock::now();
+
+    namespace {
+
+        struct ProfileEvent {
+            const char* _name;
+            uint64_t _start;
+            uint64_t _end;
+        };
+        // Single producer ring buffer, only the owning thread writes to it
+        struct ThreadBuffer {
+            std::array<ProfileEvent, ENGINE_PROFILER_EVENTS_PER_THREAD> _events;
+            std::atomic<uint64_t> _written = 0;
+            std::atomic<const char*> _name = nullptr;
+            uint32_t _id = 0;
+        };
+
+        std::mutex bufferMutex;
+        // Buffers are never deleted, so the zones of stopped threads can still be dumped
+        std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+        thread_local ThreadBuffer* localBuffer = nullptr;
+
+        // Only accessed from the thread calling OnFrameEnd
+        std::array<uint64_t, ENGINE_PROFILER_FRAME_HISTORY> frameEnds;
+        uint64_t amountFrames = 0;
+
+        std::mutex dumpMutex;
+        std::string requestedDumpPath;
+        size_t requestedDumpFrames = 0;
+        float spikeThreshold = 0;
+        std::string spikeDumpPath;
+        size_t spikeDumpFrames = 0;
+
+        ThreadBuffer* GetThreadBuffer() {
+            if(localBuffer) return localBuffer;
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+            localBuffer = threadBuffers.back().get();
+            localBuffer->_id = (uint32_t)threadBuffers.size()-1;
+            return localBuffer;
+        }
+
+        void WriteEscaped(std::ostream& stream, const char* string) {
+            for(; *string; string++) {
+                if(*string == '"' || *string == '\\') stream << '\\';
+                stream << *string;
+            }
+        }
+
+        void Dump(const std::string& path, const size_t amountFrames) {
+            File file(path);
+            std::ofstream stream = file.GetOutStream(std::ios::trunc);
+            Profiler::WriteTrace(stream, amountFrames);
+            INFO("[Util::Profiler] Dumped the last " + std::to_string(amountFrames) + " frames to '" + path + "'")
+        }
+
+    }
+
+    void Profiler::Record(const char* name, const uint64_t start, const uint64_t end) {
+        ThreadBuffer* buffer = GetThreadBuffer();
+        const uint64_t index = buffer->_written.load(std::memory_order_relaxed);
+        buffer->_events[index % ENGINE_PROFILER_EVENTS_PER_THREAD] = ProfileEvent{name, start, end};
+        buffer->_written.store(index+1, std::memory_order_release);
+    }
+
+    void Profiler::OnFrameEnd() {
+        const uint64_t now = Now();
+        const uint64_t previousFrameEnd = amountFrames ? frameEnds[(amountFrames-1)%ENGINE_PROFILER_FRAME_HISTORY] : 0;
+        Record("Frame", previousFrameEnd, now);
+        frameEnds[amountFrames%ENGINE_PROFILER_FRAME_HISTORY] = now;
+        amountFrames++;
+
+        std::string dumpPath;
+        size_t dumpFrames = 0;
+        {
+            std::lock_guard<std::mutex> lock(dumpMutex);
+            if(requestedDumpPath.size()) {
+                dumpPath = std::move(requestedDumpPath);
+                dumpFrames = requestedDumpFrames;
+                requestedDumpPath.clear();
+            } else if(spikeThreshold > 0 && amountFrames > 1 && (float)(now-previousFrameEnd)/1000000000 > spikeThreshold) {
+                dumpPath = spikeDumpPath;
+                dumpFrames = spikeDumpFrames;
+                WARNING("[Util::Profiler] Frame took " + std::to_string((float)(now-previousFrameEnd)/1000000) + "ms, dumping the profile")
+            }
+        }
+        if(dumpPath.size()) Dump(dumpPath, dumpFrames);
+    }
+    void Profiler::SetThreadName(const char* name) {
+        GetThreadBuffer()->_name.store(name, std::memory_order_relaxed);
+    }
+
+    void Profiler::RequestDump(const std::string path, const size_t amountFrames) {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        requestedDumpPath = path;
+        requestedDumpFrames = amountFrames;
+    }
+    void Profiler::DumpOnSpike(const float thresholdSeconds, const std::string path, const size_t amountFrames) {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        spikeThreshold = thresholdSeconds;
+        spikeDumpPath = path;
+        spikeDumpFrames = amountFrames;
+    }
+
+    void Profiler::WriteTrace(std::ostream& stream, size_t frames) {
+        frames = std::min<size_t>(frames, ENGINE_PROFILER_FRAME_HISTORY-1);
+        const uint64_t from = amountFrames > frames ? frameEnds[(amountFrames-frames-1)%ENGINE_PROFILER_FRAME_HISTORY] : 0;
+
+        std::vector<ThreadBuffer*> buffers;
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            for(auto& buffer : threadBuffers) buffers.push_back(buffer.get());
+        }
+
+        stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        std::vector<ProfileEvent> events;
+        for(ThreadBuffer* buffer : buffers) {
+            const char* name = buffer->_name.load(std::memory_order_relaxed);
+            if(name) {
+                stream << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->_id << ",\"args\":{\"name\":\"";
+                WriteEscaped(stream, name);
+                stream << "\"}}";
+                first = false;
+            }
+
+            // Copy the events, then drop every event the owning thread may have overwritten while copying
+            const uint64_t writtenBefore = buffer->_written.load(std::memory_order_acquire);
+            const uint64_t start = writtenBefore > ENGINE_PROFILER_EVENTS_PER_THREAD ? writtenBefore-ENGINE_PROFILER_EVENTS_PER_THREAD : 0;
+            events.clear();
+            for(uint64_t i = start; i < writtenBefore; i++) {
+                events.push_back(buffer->_events[i % ENGINE_PROFILER_EVENTS_PER_THREAD]);
+            }
+            const uint64_t writtenAfter = buffer->_written.load(std::memory_order_acquire);
+            const uint64_t validFrom = writtenAfter > ENGINE_PROFILER_EVENTS_PER_THREAD ? writtenAfter-ENGINE_PROFILER_EVENTS_PER_THREAD : 0;
+            // Leave one slot of margin for the write that may be in progress
+            const size_t skip = validFrom > start ? std::min<size_t>(validFrom-start+1, events.size()) : 0;
+
+            for(size_t i = skip; i < events.size(); i++) {
+                const ProfileEvent& event = events[i];
+                if(event._end < from) continue;
+                stream << (first ? "" : ",") << "{\"name\":\"";
+                WriteEscaped(stream, event._name);
+                stream << "\",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->_id
+                       << ",\"ts\":" << std::fixed << std::setprecision(3) << (double)event._start/1000
+                       << ",\"dur\":" << (double)(event._end-event._start)/1000 << "}";
+                first = false;
+            }
+        }
+        stream << "]}";
+    }
+
+}
+}
+
+#endif
\ No newline at end of file
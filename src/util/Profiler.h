@@ -0,0 +1,121 @@
+#ifndef ENGINE_UTIL_PROFILER_H
+#define ENGINE_UTIL_PROFILER_H
+
+#include "core/PCH.h"
+
+// Compiles all the profiling macros to nothing when set to 0
+#ifndef ENGINE_ENABLE_PROFILER
+    #define ENGINE_ENABLE_PROFILER 0
+#endif
+// The amount of zones every thread can store before the oldest zones get overwritten
+#ifndef ENGINE_PROFILER_EVENTS_PER_THREAD
+    #define ENGINE_PROFILER_EVENTS_PER_THREAD 65536
+#endif
+// The amount of frame boundaries that are remembered (the maximum amount of frames that can be dumped)
+#ifndef ENGINE_PROFILER_FRAME_HISTORY
+    #define ENGINE_PROFILER_FRAME_HISTORY 256
+#endif
+
+#define ENGINE_PROFILER_CONCAT_INTERNAL(a, b) a##b
+#define ENGINE_PROFILER_CONCAT(a, b) ENGINE_PROFILER_CONCAT_INTERNAL(a, b)
+
+#if ENGINE_ENABLE_PROFILER
+    // Times the enclosing scope, the name must be a string literal (only the pointer is stored)
+    #define ENGINE_PROFILE_SCOPE(name) Engine::Util::ProfileZone ENGINE_PROFILER_CONCAT(_profileZone, __LINE__)(name);
+    // Times the enclosing function
+    #define ENGINE_PROFILE_FUNCTION() ENGINE_PROFILE_SCOPE(__func__)
+    // Marks the end of a frame, must be called from the thread that runs the game loop
+    #define ENGINE_PROFILE_FRAME() Engine::Util::Profiler::OnFrameEnd();
+    // Gives the calling thread a name in the trace output, the name must be a string literal
+    #define ENGINE_PROFILE_THREAD(name) Engine::Util::Profiler::SetThreadName(name);
+#else
+    #define ENGINE_PROFILE_SCOPE(name)
+    #define ENGINE_PROFILE_FUNCTION()
+    #define ENGINE_PROFILE_FRAME()
+    #define ENGINE_PROFILE_THREAD(name)
+#endif
+
+namespace Engine {
+namespace Util {
+
+    /**
+     * @brief Collects timed zones from every thread and writes them as Chrome trace event JSON
+     * The output can be opened with chrome://tracing or https://ui.perfetto.dev
+     *
+     * Every thread writes into its own ring buffer, so recording a zone never takes a lock.
+     * Only the first zone on a new thread registers the buffer (under a mutex).
+     * Use the ENGINE_PROFILE_* macros instead of calling this class directly, they compile to nothing
+     * when ENGINE_ENABLE_PROFILER is 0.
+     */
+    class Profiler {
+    public:
+#if ENGINE_ENABLE_PROFILER
+        /**
+         * @brief Records a zone on the calling thread
+         *
+         * @param name The name of the zone, must outlive the profiler (a string literal)
+         * @param start The start in nanoseconds since the profiler epoch
+         * @param end The end in nanoseconds since the profiler epoch
+         */
+        static void Record(const char* name, const uint64_t start, const uint64_t end);
+        /**
+         * @brief Marks the end of the current frame, executes pending dumps
+         *
+         */
+        static void OnFrameEnd();
+        static void SetThreadName(const char* name);
+
+        /**
+         * @brief Dumps the last frames to a file at the end of the current frame
+         * Safe to call from any thread
+         *
+         * @param path The file to write the JSON to (will be overwritten)
+         * @param amountFrames The amount of frames to include (at most ENGINE_PROFILER_FRAME_HISTORY)
+         */
+        static void RequestDump(const std::string path, const size_t amountFrames);
+        /**
+         * @brief Dumps the last frames every time a frame takes longer than the threshold
+         *
+         * @param thresholdSeconds The frame time that counts as a spike, 0 disables spike dumps
+         * @param path The file to write the JSON to (will be overwritten by every spike)
+         * @param amountFrames The amount of frames before the spike to include
+         */
+        static void DumpOnSpike(const float thresholdSeconds, const std::string path, const size_t amountFrames);
+        /**
+         * @brief Writes the last frames directly to the stream
+         *
+         * @param stream The stream to write the JSON to
+         * @param amountFrames The amount of frames to include
+         */
+        static void WriteTrace(std::ostream& stream, const size_t amountFrames);
+
+        static inline uint64_t Now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+        }
+    private:
+        static const std::chrono::steady_clock::time_point _epoch;
+#else
+        static void OnFrameEnd() {}
+        static void SetThreadName(const char* name) {}
+        static void RequestDump(const std::string path, const size_t amountFrames) {}
+        static void DumpOnSpike(const float thresholdSeconds, const std::string path, const size_t amountFrames) {}
+        static void WriteTrace(std::ostream& stream, const size_t amountFrames) {}
+#endif
+    };
+
+#if ENGINE_ENABLE_PROFILER
+    // Records the lifetime of the object as a zone, use ENGINE_PROFILE_SCOPE instead of this class
+    class ProfileZone {
+    public:
+        ProfileZone(const char* name) : _name(name), _start(Profiler::Now()) {}
+        ~ProfileZone() { Profiler::Record(_name, _start, Profiler::Now()); }
+    private:
+        const char* _name;
+        uint64_t _start;
+    };
+#endif
+
+}
+}
+
+#endif
\ No newline at end of file
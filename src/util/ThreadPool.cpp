@@ -0,0 +1,73 @@
+#include "util/ThreadPool.h"
+#include "util/Profiler.h"
+
+namespace Engine {
+namespace Util {
+
+    ThreadPool::ThreadPool(const uint32_t amountWorkers) {
+        _workers.reserve(amountWorkers);
+        for(uint32_t i = 0; i < amountWorkers; i++) {
+            _workers.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wakeWorkers.notify_all();
+        for(std::thread& worker : _workers) worker.join();
+    }
+
+    void ThreadPool::Execute(const size_t batches, const std::function<void(size_t)>& job) {
+        if(batches == 0) return;
+        if(batches == 1 || _workers.empty()) {
+            for(size_t i = 0; i < batches; i++) job(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = &job;
+            _batches = batches;
+            _nextBatch.store(0, std::memory_order_relaxed);
+            _finishedBatches.store(0, std::memory_order_relaxed);
+            _generation++;
+        }
+        _wakeWorkers.notify_all();
+        RunBatches();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        // Also wait for the workers to leave, so none of them touches the next job before it is set up
+        _jobDone.wait(lock, [&]() { return _finishedBatches.load(std::memory_order_acquire) == _batches && _activeWorkers == 0; });
+        _job = nullptr;
+    }
+    void ThreadPool::RunBatches() {
+        while(true) {
+            const size_t batch = _nextBatch.fetch_add(1, std::memory_order_relaxed);
+            if(batch >= _batches) return;
+            (*_job)(batch);
+            _finishedBatches.fetch_add(1, std::memory_order_release);
+        }
+    }
+    void ThreadPool::WorkerLoop() {
+        ENGINE_PROFILE_THREAD("Worker")
+        uint64_t generation = 0;
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wakeWorkers.wait(lock, [&]() { return _stop || (_job && _generation != generation); });
+                if(_stop) return;
+                generation = _generation;
+                _activeWorkers++;
+            }
+            RunBatches();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _activeWorkers--;
+            }
+            _jobDone.notify_all();
+        }
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef ENGINE_UTIL_THREAD_POOL_H
+#define ENGINE_UTIL_THREAD_POOL_H
+
+#include "core/PCH.h"
+#include <condition_variable>
+
+namespace Engine {
+namespace Util {
+
+    /**
+     * @brief A fixed set of worker threads to split loops over
+     * The thread calling ParallelFor works on the batches as well and only returns when all of them are done,
+     * so the function can safely reference locals of the caller.
+     *
+     * @warning The function passed to ParallelFor must not throw
+     * @warning Only one thread at a time may call ParallelFor
+     */
+    class ThreadPool {
+    public:
+        // Uses one thread less than the hardware has, the calling thread is the last one
+        ThreadPool(const uint32_t amountWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // The amount of threads that work on a ParallelFor, including the calling thread
+        inline uint32_t GetAmountThreads() const { return (uint32_t)_workers.size() + 1; }
+
+        /**
+         * @brief Calls func(batch, begin, end) for every batch of [0, count)
+         *
+         * @param count The amount of elements
+         * @param batchSize The maximum amount of elements in one batch, batch i starts at i*batchSize
+         * @param func Is called as func(const size_t batch, const size_t begin, const size_t end)
+         */
+        template<class Func>
+        void ParallelFor(const size_t count, const size_t batchSize, Func&& func) {
+            ASSERT(batchSize > 0, "[Util::ThreadPool] The batch size must be greater than zero")
+            const size_t batches = (count + batchSize - 1) / batchSize;
+            Execute(batches, [&](const size_t batch) {
+                func(batch, batch*batchSize, std::min(count, (batch+1)*batchSize));
+            });
+        }
+
+    private:
+        void Execute(const size_t batches, const std::function<void(size_t)>& job);
+        void RunBatches();
+        void WorkerLoop();
+
+        std::vector<std::thread> _workers;
+        std::mutex _mutex;
+        std::condition_variable _wakeWorkers;
+        std::condition_variable _jobDone;
+        bool _stop = false;
+        uint64_t _generation = 0;
+        uint32_t _activeWorkers = 0;
+
+        const std::function<void(size_t)>* _job = nullptr;
+        size_t _batches = 0;
+        std::atomic<size_t> _nextBatch = 0;
+        std::atomic<size_t> _finishedBatches = 0;
+    };
+
+}
+}
+
+#endif
\ No newline at end of file